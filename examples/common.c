@@ -243,61 +243,20 @@ dc_status_t
 dctool_descriptor_search (dc_descriptor_t **out, const char *name, dc_family_t family, unsigned int model)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_descriptor_t *descriptor = NULL;
 
-	dc_iterator_t *iterator = NULL;
-	rc = dc_descriptor_iterator (&iterator);
-	if (rc != DC_STATUS_SUCCESS) {
-		ERROR ("Error creating the device descriptor iterator.");
-		return rc;
-	}
-
-	dc_descriptor_t *descriptor = NULL, *current = NULL;
-	while ((rc = dc_iterator_next (iterator, &descriptor)) == DC_STATUS_SUCCESS) {
-		if (name) {
-			const char *vendor = dc_descriptor_get_vendor (descriptor);
-			const char *product = dc_descriptor_get_product (descriptor);
-
-			size_t n = strlen (vendor);
-			if (strncasecmp (name, vendor, n) == 0 && name[n] == ' ' &&
-				strcasecmp (name + n + 1, product) == 0)
-			{
-				current = descriptor;
-				break;
-			} else if (strcasecmp (name, product) == 0) {
-				current = descriptor;
-				break;
-			}
-		} else {
-			if (family == dc_descriptor_get_type (descriptor)) {
-				if (model == dc_descriptor_get_model (descriptor)) {
-					// Exact match found. Return immediately.
-					dc_descriptor_free (current);
-					current = descriptor;
-					break;
-				} else {
-					// Possible match found. Keep searching for an exact match.
-					// If no exact match is found, the first match is returned.
-					if (current == NULL) {
-						current = descriptor;
-						descriptor = NULL;
-					}
-				}
-			}
-		}
-
-		dc_descriptor_free (descriptor);
+	if (name) {
+		rc = dc_descriptor_lookup_name (&descriptor, name);
+	} else {
+		rc = dc_descriptor_lookup_model (&descriptor, family, model);
 	}
 
-	if (rc != DC_STATUS_SUCCESS && rc != DC_STATUS_DONE) {
-		dc_descriptor_free (current);
-		dc_iterator_free (iterator);
-		ERROR ("Error iterating the device descriptors.");
+	if (rc != DC_STATUS_SUCCESS && rc != DC_STATUS_UNSUPPORTED) {
+		ERROR ("Error searching the device descriptors.");
 		return rc;
 	}
 
-	dc_iterator_free (iterator);
-
-	*out = current;
+	*out = descriptor;
 
 	return DC_STATUS_SUCCESS;
 }
@@ -43,16 +43,62 @@
 
 typedef struct event_data_t {
 	const char *cachedir;
-	dc_event_devinfo_t devinfo;
+	dc_store_t *store;
 } event_data_t;
 
 typedef struct dive_data_t {
 	dc_device_t *device;
-	dc_buffer_t **fingerprint;
 	unsigned int number;
 	dctool_output_t *output;
 } dive_data_t;
 
+static void
+event_cb (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata)
+{
+	const dc_event_devinfo_t *devinfo = (const dc_event_devinfo_t *) data;
+
+	event_data_t *eventdata = (event_data_t *) userdata;
+
+	// Forward to the default event handler.
+	dctool_event_cb (device, event, data, userdata);
+
+	switch (event) {
+	case DC_EVENT_DEVINFO:
+		// The store has already loaded its fingerprint at this point. If
+		// the store has none yet, import the fingerprint file of older
+		// versions, to avoid downloading all dives again.
+		if (eventdata->store) {
+			char filename[1024] = {0};
+			dc_family_t family = dc_device_get_type (device);
+			dc_buffer_t *fingerprint = dc_buffer_new (0);
+
+			if (fingerprint &&
+				dc_store_get_fingerprint (eventdata->store, family, devinfo->serial, fingerprint) == DC_STATUS_SUCCESS &&
+				dc_buffer_get_size (fingerprint) == 0) {
+				// Generate the fingerprint filename.
+				snprintf (filename, sizeof (filename), "%s/%s-%08X.bin",
+					eventdata->cachedir, dctool_family_name (family), devinfo->serial);
+
+				// Read the fingerprint file.
+				dc_buffer_t *legacy = dctool_file_read (filename);
+				if (legacy && dc_buffer_get_size (legacy)) {
+					message ("Importing the fingerprint file (%s).\n", filename);
+					dc_store_set_fingerprint (eventdata->store, family, devinfo->serial,
+						dc_buffer_get_data (legacy), dc_buffer_get_size (legacy));
+					dc_device_set_fingerprint (device,
+						dc_buffer_get_data (legacy), dc_buffer_get_size (legacy));
+				}
+				dc_buffer_free (legacy);
+			}
+
+			dc_buffer_free (fingerprint);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 static int
 dive_cb (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
 {
@@ -67,15 +113,6 @@ dive_cb (const unsigned char *data, unsigned int size, const unsigned char *fing
 		message ("%02X", fingerprint[i]);
 	message ("\n");
 
-	// Keep a copy of the most recent fingerprint. Because dives are
-	// guaranteed to be downloaded in reverse order, the most recent
-	// dive is always the first dive.
-	if (divedata->number == 1) {
-		dc_buffer_t *fp = dc_buffer_new (fsize);
-		dc_buffer_append (fp, fingerprint, fsize);
-		*divedata->fingerprint = fp;
-	}
-
 	// Create the parser.
 	message ("Creating the parser.\n");
 	rc = dc_parser_new (&parser, divedata->device);
@@ -105,59 +142,14 @@ cleanup:
 	return 1;
 }
 
-static void
-event_cb (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata)
-{
-	const dc_event_devinfo_t *devinfo = (const dc_event_devinfo_t *) data;
-
-	event_data_t *eventdata = (event_data_t *) userdata;
-
-	// Forward to the default event handler.
-	dctool_event_cb (device, event, data, userdata);
-
-	switch (event) {
-	case DC_EVENT_DEVINFO:
-		// Load the fingerprint from the cache. If there is no
-		// fingerprint present in the cache, a NULL buffer is returned,
-		// and the registered fingerprint will be cleared.
-		if (eventdata->cachedir) {
-			char filename[1024] = {0};
-			dc_family_t family = DC_FAMILY_NULL;
-			dc_buffer_t *fingerprint = NULL;
-
-			// Generate the fingerprint filename.
-			family = dc_device_get_type (device);
-			snprintf (filename, sizeof (filename), "%s/%s-%08X.bin",
-				eventdata->cachedir, dctool_family_name (family), devinfo->serial);
-
-			// Read the fingerprint file.
-			fingerprint = dctool_file_read (filename);
-
-			// Register the fingerprint data.
-			dc_device_set_fingerprint (device,
-				dc_buffer_get_data (fingerprint),
-				dc_buffer_get_size (fingerprint));
-
-			// Free the buffer again.
-			dc_buffer_free (fingerprint);
-		}
-
-		// Keep a copy of the event data. It will be used for generating
-		// the fingerprint filename again after a (successful) download.
-		eventdata->devinfo = *devinfo;
-		break;
-	default:
-		break;
-	}
-}
-
 static dc_status_t
-download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *cachedir, dc_buffer_t *fingerprint, dctool_output_t *output)
+download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t transport, const char *devname, const char *cachedir, dc_buffer_t *fingerprint, dc_buffer_t *dive, unsigned int headers, dctool_output_t *output)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	dc_iostream_t *iostream = NULL;
 	dc_device_t *device = NULL;
-	dc_buffer_t *ofingerprint = NULL;
+	dc_store_t *store = NULL;
+	event_data_t eventdata = {0};
 
 	// Open the I/O stream.
 	message ("Opening the I/O stream (%s, %s).\n",
@@ -179,14 +171,6 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 		goto cleanup;
 	}
 
-	// Initialize the event data.
-	event_data_t eventdata = {0};
-	if (fingerprint) {
-		eventdata.cachedir = NULL;
-	} else {
-		eventdata.cachedir = cachedir;
-	}
-
 	// Register the event handler.
 	message ("Registering the event handler.\n");
 	int events = DC_EVENT_WAITING | DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK | DC_EVENT_VENDOR;
@@ -204,6 +188,28 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 		goto cleanup;
 	}
 
+	// Register the download state store. The store loads the fingerprint
+	// as soon as the serial number is known, and saves the fingerprint of
+	// the most recent dive after a successful download. An interrupted
+	// download is resumed from the checkpoints in the store.
+	if (cachedir && fingerprint == NULL) {
+		message ("Opening the store (%s).\n", cachedir);
+		rc = dc_store_open (&store, context, cachedir, DC_STORE_CHECKPOINT);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error opening the store.");
+			goto cleanup;
+		}
+
+		rc = dc_device_set_store (device, store);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR ("Error registering the store.");
+			goto cleanup;
+		}
+
+		eventdata.cachedir = cachedir;
+		eventdata.store = store;
+	}
+
 	// Register the fingerprint data.
 	if (fingerprint) {
 		message ("Registering the fingerprint data.\n");
@@ -217,35 +223,36 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, dc_transport_t tra
 	// Initialize the dive data.
 	dive_data_t divedata = {0};
 	divedata.device = device;
-	divedata.fingerprint = &ofingerprint;
 	divedata.number = 0;
 	divedata.output = output;
 
 	// Download the dives.
-	message ("Downloading the dives.\n");
-	rc = dc_device_foreach (device, dive_cb, &divedata);
+	if (dive) {
+		message ("Downloading the dive.\n");
+		dc_buffer_t *buffer = dc_buffer_new (0);
+		rc = dc_device_read_dive (device, dc_buffer_get_data (dive), dc_buffer_get_size (dive), buffer);
+		if (rc == DC_STATUS_SUCCESS) {
+			dive_cb (dc_buffer_get_data (buffer), dc_buffer_get_size (buffer),
+				dc_buffer_get_data (dive), dc_buffer_get_size (dive), &divedata);
+		}
+		dc_buffer_free (buffer);
+	} else if (headers) {
+		message ("Downloading the dive headers.\n");
+		rc = dc_device_foreach_headers (device, dive_cb, &divedata);
+	} else {
+		// The dives are parsed on a worker thread, while the next dive
+		// is being downloaded.
+		message ("Downloading the dives.\n");
+		rc = dc_device_foreach_pipelined (device, dive_cb, &divedata);
+	}
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error downloading the dives.");
 		goto cleanup;
 	}
 
-	// Store the fingerprint data.
-	if (cachedir && ofingerprint) {
-		char filename[1024] = {0};
-		dc_family_t family = DC_FAMILY_NULL;
-
-		// Generate the fingerprint filename.
-		family = dc_device_get_type (device);
-		snprintf (filename, sizeof (filename), "%s/%s-%08X.bin",
-			cachedir, dctool_family_name (family), eventdata.devinfo.serial);
-
-		// Write the fingerprint file.
-		dctool_file_write (filename, ofingerprint);
-	}
-
 cleanup:
-	dc_buffer_free (ofingerprint);
 	dc_device_close (device);
+	dc_store_close (store);
 	dc_iostream_close (iostream);
 	return rc;
 }
@@ -256,20 +263,23 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 	int exitcode = EXIT_SUCCESS;
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_buffer_t *fingerprint = NULL;
+	dc_buffer_t *dive = NULL;
 	dctool_output_t *output = NULL;
 	dctool_units_t units = DCTOOL_UNITS_METRIC;
 	dc_transport_t transport = dctool_transport_default (descriptor);
 
 	// Default option values.
 	unsigned int help = 0;
+	unsigned int headers = 0;
 	const char *fphex = NULL;
+	const char *divehex = NULL;
 	const char *filename = NULL;
 	const char *cachedir = NULL;
 	const char *format = "xml";
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ht:o:p:c:f:u:";
+	const char *optstring = "ht:o:p:c:f:u:Hd:";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
@@ -279,6 +289,8 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 		{"cache",       required_argument, 0, 'c'},
 		{"format",      required_argument, 0, 'f'},
 		{"units",       required_argument, 0, 'u'},
+		{"headers",     no_argument,       0, 'H'},
+		{"dive",        required_argument, 0, 'd'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -310,6 +322,12 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 			if (strcmp (optarg, "imperial") == 0)
 				units = DCTOOL_UNITS_IMPERIAL;
 			break;
+		case 'H':
+			headers = 1;
+			break;
+		case 'd':
+			divehex = optarg;
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -333,12 +351,17 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 
 	// Convert the fingerprint to binary.
 	fingerprint = dctool_convert_hex2bin (fphex);
+	dive = dctool_convert_hex2bin (divehex);
 
 	// Create the output.
 	if (strcasecmp(format, "raw") == 0) {
 		output = dctool_raw_output_new (filename);
 	} else if (strcasecmp(format, "xml") == 0) {
 		output = dctool_xml_output_new (filename, units);
+	} else if (strcasecmp(format, "csv") == 0) {
+		output = dctool_csv_output_new (filename, units);
+	} else if (strcasecmp(format, "binary") == 0) {
+		output = dctool_binary_output_new (filename, units);
 	} else {
 		message ("Unknown output format: %s\n", format);
 		exitcode = EXIT_FAILURE;
@@ -351,7 +374,7 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 	}
 
 	// Download the dives.
-	status = download (context, descriptor, transport, argv[0], cachedir, fingerprint, output);
+	status = download (context, descriptor, transport, argv[0], cachedir, fingerprint, dive, headers, output);
 	if (status != DC_STATUS_SUCCESS) {
 		message ("ERROR: %s\n", dctool_errmsg (status));
 		exitcode = EXIT_FAILURE;
@@ -360,6 +383,7 @@ dctool_download_run (int argc, char *argv[], dc_context_t *context, dc_descripto
 
 cleanup:
 	dctool_output_free (output);
+	dc_buffer_free (dive);
 	dc_buffer_free (fingerprint);
 	return exitcode;
 }
@@ -381,6 +405,8 @@ const dctool_command_t dctool_download = {
 	"   -c, --cache <directory>    Cache directory\n"
 	"   -f, --format <format>      Output format\n"
 	"   -u, --units <units>        Set units (metric or imperial)\n"
+	"   -H, --headers              Download the dive headers only\n"
+	"   -d, --dive <fingerprint>   Download a single dive (hexadecimal)\n"
 #else
 	"   -h                 Show help message\n"
 	"   -t <transport>     Transport type\n"
@@ -389,6 +415,8 @@ const dctool_command_t dctool_download = {
 	"   -c <directory>     Cache directory\n"
 	"   -f <format>        Output format\n"
 	"   -u <units>         Set units (metric or imperial)\n"
+	"   -H                 Download the dive headers only\n"
+	"   -d <fingerprint>   Download a single dive (hexadecimal)\n"
 #endif
 	"\n"
 	"Supported output formats:\n"
@@ -397,6 +425,16 @@ const dctool_command_t dctool_download = {
 	"\n"
 	"      All dives are exported to a single xml file.\n"
 	"\n"
+	"   CSV\n"
+	"\n"
+	"      The samples of all dives are exported to a single csv file,\n"
+	"      with one row per sample.\n"
+	"\n"
+	"   BINARY\n"
+	"\n"
+	"      The samples of all dives are exported to a single binary file,\n"
+	"      with one array of values per column.\n"
+	"\n"
 	"   RAW\n"
 	"\n"
 	"      Each dive is exported to a raw (binary) file. To output multiple\n"
@@ -92,16 +92,18 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	// Default option values.
 	unsigned int help = 0;
 	const char *filename = NULL;
+	const char *format = "xml";
 	unsigned int devtime = 0;
 	dc_ticks_t systime = 0;
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ho:d:s:u:";
+	const char *optstring = "ho:f:d:s:u:";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"output",      required_argument, 0, 'o'},
+		{"format",      required_argument, 0, 'f'},
 		{"devtime",     required_argument, 0, 'd'},
 		{"systime",     required_argument, 0, 's'},
 		{"units",       required_argument, 0, 'u'},
@@ -118,6 +120,9 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		case 'o':
 			filename = optarg;
 			break;
+		case 'f':
+			format = optarg;
+			break;
 		case 'd':
 			devtime = strtoul (optarg, NULL, 0);
 			break;
@@ -145,7 +150,17 @@ dctool_parse_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	}
 
 	// Create the output.
-	output = dctool_xml_output_new (filename, units);
+	if (strcasecmp(format, "xml") == 0) {
+		output = dctool_xml_output_new (filename, units);
+	} else if (strcasecmp(format, "csv") == 0) {
+		output = dctool_csv_output_new (filename, units);
+	} else if (strcasecmp(format, "binary") == 0) {
+		output = dctool_binary_output_new (filename, units);
+	} else {
+		message ("Unknown output format: %s\n", format);
+		exitcode = EXIT_FAILURE;
+		goto cleanup;
+	}
 	if (output == NULL) {
 		message ("Failed to create the output.\n");
 		exitcode = EXIT_FAILURE;
@@ -192,12 +207,14 @@ const dctool_command_t dctool_parse = {
 #ifdef HAVE_GETOPT_LONG
 	"   -h, --help                 Show help message\n"
 	"   -o, --output <filename>    Output filename\n"
+	"   -f, --format <format>      Output format (xml, csv or binary)\n"
 	"   -d, --devtime <timestamp>  Device time\n"
 	"   -s, --systime <timestamp>  System time\n"
 	"   -u, --units <units>        Set units (metric or imperial)\n"
 #else
 	"   -h              Show help message\n"
 	"   -o <filename>   Output filename\n"
+	"   -f <format>     Output format (xml, csv or binary)\n"
 	"   -d <devtime>    Device time\n"
 	"   -s <systime>    System time\n"
 	"   -u <units>      Set units (metric or imperial)\n"
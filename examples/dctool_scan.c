@@ -37,6 +37,7 @@
 #include <libdivecomputer/irda.h>
 #include <libdivecomputer/bluetooth.h>
 #include <libdivecomputer/usbhid.h>
+#include <libdivecomputer/autodetect.h>
 
 #include "dctool.h"
 #include "common.h"
@@ -110,6 +111,63 @@ cleanup:
 	return status;
 }
 
+static dc_status_t
+autodetect (dc_context_t *context, unsigned int transports, unsigned int timeout)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_iterator_t *iterator = NULL;
+
+	status = dc_autodetect (&iterator, context, transports, timeout);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR ("Failed to detect the devices.");
+		return status;
+	}
+
+	// Print the matches, best matches first.
+	dc_autodetect_match_t *match = NULL;
+	while ((status = dc_iterator_next (iterator, &match)) == DC_STATUS_SUCCESS) {
+		dc_descriptor_t *descriptor = dc_autodetect_match_get_descriptor (match);
+		dc_transport_t transport = dc_autodetect_match_get_transport (match);
+		void *device = dc_autodetect_match_get_device (match);
+		const char *name = dc_autodetect_match_get_name (match);
+		char buffer[DC_BLUETOOTH_SIZE];
+
+		printf ("%s\t%s\t",
+			dc_autodetect_match_get_rank (match) == DC_AUTODETECT_DEVICE ? "device" : "name",
+			dctool_transport_name (transport));
+		switch (transport) {
+		case DC_TRANSPORT_IRDA:
+			printf ("%08x %s", dc_irda_device_get_address (device), name);
+			break;
+		case DC_TRANSPORT_BLUETOOTH:
+			printf ("%s %s",
+				dc_bluetooth_addr2str(dc_bluetooth_device_get_address (device), buffer, sizeof(buffer)),
+				name);
+			break;
+		case DC_TRANSPORT_USBHID:
+			printf ("%04x:%04x", dc_usbhid_device_get_vid (device), dc_usbhid_device_get_pid (device));
+			break;
+		default:
+			printf ("%s", name);
+			break;
+		}
+		printf ("\t%s %s\n",
+			dc_descriptor_get_vendor (descriptor),
+			dc_descriptor_get_product (descriptor));
+
+		dc_autodetect_match_free (match);
+	}
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_DONE) {
+		ERROR ("Failed to enumerate the devices.");
+		dc_iterator_free (iterator);
+		return status;
+	}
+
+	dc_iterator_free (iterator);
+
+	return DC_STATUS_SUCCESS;
+}
+
 static int
 dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t *descriptor)
 {
@@ -118,15 +176,18 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 
 	// Default option values.
 	unsigned int help = 0;
+	unsigned int autodetect_timeout = 0;
+	const char *transport_name = NULL;
 	dc_transport_t transport = dctool_transport_default (descriptor);
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ht:";
+	const char *optstring = "ht:a:";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"transport",   required_argument, 0, 't'},
+		{"autodetect",  required_argument, 0, 'a'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -138,8 +199,12 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 			help = 1;
 			break;
 		case 't':
+			transport_name = optarg;
 			transport = dctool_transport_type (optarg);
 			break;
+		case 'a':
+			autodetect_timeout = strtoul (optarg, NULL, 0);
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -155,12 +220,22 @@ dctool_scan_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	}
 
 	// Check the transport type.
-	if (transport == DC_TRANSPORT_NONE) {
+	if (transport == DC_TRANSPORT_NONE && (transport_name || !autodetect_timeout)) {
 		message ("No valid transport type specified.\n");
 		exitcode = EXIT_FAILURE;
 		goto cleanup;
 	}
 
+	// Identify the devices on all transports, unless one is given.
+	if (autodetect_timeout) {
+		status = autodetect (context, transport_name ? transport : DC_TRANSPORT_NONE, autodetect_timeout);
+		if (status != DC_STATUS_SUCCESS) {
+			message ("ERROR: %s\n", dctool_errmsg (status));
+			exitcode = EXIT_FAILURE;
+		}
+		goto cleanup;
+	}
+
 	// Scan for supported devices.
 	status = scan (context, descriptor, transport);
 	if (status != DC_STATUS_SUCCESS) {
@@ -185,8 +260,10 @@ const dctool_command_t dctool_scan = {
 #ifdef HAVE_GETOPT_LONG
 	"   -h, --help               Show help message\n"
 	"   -t, --transport <name>   Transport type\n"
+	"   -a, --autodetect <ms>    Identify the devices within the timeout\n"
 #else
 	"   -h               Show help message\n"
 	"   -t <transport>   Transport type\n"
+	"   -a <ms>          Identify the devices within the timeout\n"
 #endif
 };
@@ -52,6 +52,71 @@ dctool_output_allocate (const dctool_output_vtable_t *vtable);
 void
 dctool_output_deallocate (dctool_output_t *output);
 
+double
+dctool_convert_depth (double value, dctool_units_t units);
+
+double
+dctool_convert_temperature (double value, dctool_units_t units);
+
+double
+dctool_convert_pressure (double value, dctool_units_t units);
+
+double
+dctool_convert_volume (double value, dctool_units_t units);
+
+/*
+ * The tabular outputs (csv and binary) store the samples as rows with a
+ * fixed set of columns. A new row is started for every time sample. If
+ * a sample type occurs more than once within the same time sample (for
+ * example the pressure of multiple tanks), a continuation row with the
+ * same time is started. Missing values are stored as NAN.
+ */
+typedef enum dctool_column_t {
+	DCTOOL_COLUMN_TIME,
+	DCTOOL_COLUMN_DEPTH,
+	DCTOOL_COLUMN_TEMPERATURE,
+	DCTOOL_COLUMN_TANK,
+	DCTOOL_COLUMN_PRESSURE,
+	DCTOOL_COLUMN_RBT,
+	DCTOOL_COLUMN_HEARTBEAT,
+	DCTOOL_COLUMN_BEARING,
+	DCTOOL_COLUMN_SETPOINT,
+	DCTOOL_COLUMN_PPO2,
+	DCTOOL_COLUMN_CNS,
+	DCTOOL_COLUMN_GASMIX,
+	DCTOOL_COLUMN_DECO_TYPE,
+	DCTOOL_COLUMN_DECO_TIME,
+	DCTOOL_COLUMN_DECO_DEPTH,
+	DCTOOL_COLUMN_TTS,
+	DCTOOL_COLUMN_COUNT
+} dctool_column_t;
+
+typedef struct dctool_column_info_t {
+	const char *name;
+	unsigned int decimals;
+} dctool_column_info_t;
+
+extern const dctool_column_info_t dctool_columns[DCTOOL_COLUMN_COUNT];
+
+typedef void (*dctool_row_callback_t) (const double row[], void *userdata);
+
+typedef struct dctool_row_t {
+	dctool_units_t units;
+	unsigned int mask;
+	double values[DCTOOL_COLUMN_COUNT];
+	dctool_row_callback_t callback;
+	void *userdata;
+} dctool_row_t;
+
+void
+dctool_row_init (dctool_row_t *row, dctool_units_t units, dctool_row_callback_t callback, void *userdata);
+
+void
+dctool_row_sample (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
+
+void
+dctool_row_flush (dctool_row_t *row);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -21,9 +21,31 @@
 
 #include <stdlib.h>
 #include <assert.h>
+#include <math.h>
+
+#include <libdivecomputer/units.h>
 
 #include "output-private.h"
 
+const dctool_column_info_t dctool_columns[DCTOOL_COLUMN_COUNT] = {
+	{"time",        0},
+	{"depth",       2},
+	{"temperature", 2},
+	{"tank",        0},
+	{"pressure",    2},
+	{"rbt",         0},
+	{"heartbeat",   0},
+	{"bearing",     0},
+	{"setpoint",    2},
+	{"ppo2",        2},
+	{"cns",         1},
+	{"gasmix",      0},
+	{"deco_type",   0},
+	{"deco_time",   0},
+	{"deco_depth",  2},
+	{"tts",         0},
+};
+
 dctool_output_t *
 dctool_output_allocate (const dctool_output_vtable_t *vtable)
 {
@@ -77,3 +99,143 @@ dctool_output_free (dctool_output_t *output)
 
 	return status;
 }
+
+double
+dctool_convert_depth (double value, dctool_units_t units)
+{
+	if (units == DCTOOL_UNITS_IMPERIAL) {
+		return value / FEET;
+	} else {
+		return value;
+	}
+}
+
+double
+dctool_convert_temperature (double value, dctool_units_t units)
+{
+	if (units == DCTOOL_UNITS_IMPERIAL) {
+		return value * (9.0 / 5.0) + 32.0;
+	} else {
+		return value;
+	}
+}
+
+double
+dctool_convert_pressure (double value, dctool_units_t units)
+{
+	if (units == DCTOOL_UNITS_IMPERIAL) {
+		return value * BAR / PSI;
+	} else {
+		return value;
+	}
+}
+
+double
+dctool_convert_volume (double value, dctool_units_t units)
+{
+	if (units == DCTOOL_UNITS_IMPERIAL) {
+		return value / 1000.0 / CUFT;
+	} else {
+		return value;
+	}
+}
+
+static void
+dctool_row_reset (dctool_row_t *row)
+{
+	row->mask = 0;
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		row->values[i] = NAN;
+	}
+}
+
+void
+dctool_row_init (dctool_row_t *row, dctool_units_t units, dctool_row_callback_t callback, void *userdata)
+{
+	row->units = units;
+	row->callback = callback;
+	row->userdata = userdata;
+	dctool_row_reset (row);
+}
+
+void
+dctool_row_flush (dctool_row_t *row)
+{
+	if (row->mask == 0)
+		return;
+
+	row->callback (row->values, row->userdata);
+
+	dctool_row_reset (row);
+}
+
+static void
+dctool_row_set (dctool_row_t *row, dctool_column_t column, double value)
+{
+	unsigned int mask = 1u << column;
+
+	// Start a continuation row for the same time.
+	if (row->mask & mask) {
+		double time = row->values[DCTOOL_COLUMN_TIME];
+		dctool_row_flush (row);
+		row->values[DCTOOL_COLUMN_TIME] = time;
+		row->mask = 1u << DCTOOL_COLUMN_TIME;
+	}
+
+	row->values[column] = value;
+	row->mask |= mask;
+}
+
+void
+dctool_row_sample (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dctool_row_t *row = (dctool_row_t *) userdata;
+
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		dctool_row_flush (row);
+		dctool_row_set (row, DCTOOL_COLUMN_TIME, value.time);
+		break;
+	case DC_SAMPLE_DEPTH:
+		dctool_row_set (row, DCTOOL_COLUMN_DEPTH, dctool_convert_depth (value.depth, row->units));
+		break;
+	case DC_SAMPLE_PRESSURE:
+		dctool_row_set (row, DCTOOL_COLUMN_TANK, value.pressure.tank);
+		dctool_row_set (row, DCTOOL_COLUMN_PRESSURE, dctool_convert_pressure (value.pressure.value, row->units));
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		dctool_row_set (row, DCTOOL_COLUMN_TEMPERATURE, dctool_convert_temperature (value.temperature, row->units));
+		break;
+	case DC_SAMPLE_RBT:
+		dctool_row_set (row, DCTOOL_COLUMN_RBT, value.rbt);
+		break;
+	case DC_SAMPLE_HEARTBEAT:
+		dctool_row_set (row, DCTOOL_COLUMN_HEARTBEAT, value.heartbeat);
+		break;
+	case DC_SAMPLE_BEARING:
+		dctool_row_set (row, DCTOOL_COLUMN_BEARING, value.bearing);
+		break;
+	case DC_SAMPLE_SETPOINT:
+		dctool_row_set (row, DCTOOL_COLUMN_SETPOINT, value.setpoint);
+		break;
+	case DC_SAMPLE_PPO2:
+		dctool_row_set (row, DCTOOL_COLUMN_PPO2, value.ppo2);
+		break;
+	case DC_SAMPLE_CNS:
+		dctool_row_set (row, DCTOOL_COLUMN_CNS, value.cns * 100.0);
+		break;
+	case DC_SAMPLE_GASMIX:
+		dctool_row_set (row, DCTOOL_COLUMN_GASMIX, value.gasmix);
+		break;
+	case DC_SAMPLE_DECO:
+		dctool_row_set (row, DCTOOL_COLUMN_DECO_TYPE, value.deco.type);
+		dctool_row_set (row, DCTOOL_COLUMN_DECO_TIME, value.deco.time);
+		dctool_row_set (row, DCTOOL_COLUMN_DECO_DEPTH, dctool_convert_depth (value.deco.depth, row->units));
+		break;
+	case DC_SAMPLE_TTS:
+		dctool_row_set (row, DCTOOL_COLUMN_TTS, value.time);
+		break;
+	default:
+		break;
+	}
+}
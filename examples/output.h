@@ -39,6 +39,12 @@ typedef enum dctool_units_t {
 dctool_output_t *
 dctool_xml_output_new (const char *filename, dctool_units_t units);
 
+dctool_output_t *
+dctool_csv_output_new (const char *filename, dctool_units_t units);
+
+dctool_output_t *
+dctool_binary_output_new (const char *filename, dctool_units_t units);
+
 dctool_output_t *
 dctool_raw_output_new (const char *template);
 
@@ -0,0 +1,227 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdivecomputer/buffer.h>
+
+#include "output-private.h"
+#include "writer.h"
+#include "utils.h"
+
+/*
+ * Columnar binary format. All numbers are stored in little endian.
+ *
+ * The file starts with the "DCTB" magic, the format version, the units
+ * and the number of columns, followed by the null terminated name of
+ * each column. Next is a record for each dive, containing the number,
+ * the size and the fingerprint (length + data) of the dive, the seven
+ * date/time components, the divetime, the maxdepth and the number of
+ * rows. The samples follow as one array of 64 bit floating point values
+ * per column, with NAN for missing values.
+ */
+
+#define MAGIC   0x42544344 /* "DCTB" */
+#define VERSION 1
+
+static dc_status_t dctool_binary_output_write (dctool_output_t *output, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize);
+static dc_status_t dctool_binary_output_free (dctool_output_t *output);
+
+typedef struct dctool_binary_output_t {
+	dctool_output_t base;
+	dctool_writer_t *ostream;
+	dctool_units_t units;
+	dc_buffer_t *columns[DCTOOL_COLUMN_COUNT];
+} dctool_binary_output_t;
+
+static const dctool_output_vtable_t binary_vtable = {
+	sizeof(dctool_binary_output_t), /* size */
+	dctool_binary_output_write, /* write */
+	dctool_binary_output_free, /* free */
+};
+
+typedef struct row_data_t {
+	dc_buffer_t **columns;
+	unsigned int nrows;
+	int error;
+} row_data_t;
+
+static void
+row_cb (const double row[], void *userdata)
+{
+	row_data_t *rowdata = (row_data_t *) userdata;
+
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		if (!dc_buffer_append (rowdata->columns[i], (const unsigned char *) &row[i], sizeof (row[i])))
+			rowdata->error = 1;
+	}
+
+	rowdata->nrows++;
+}
+
+dctool_output_t *
+dctool_binary_output_new (const char *filename, dctool_units_t units)
+{
+	dctool_binary_output_t *output = NULL;
+
+	if (filename == NULL)
+		goto error_exit;
+
+	// Allocate memory.
+	output = (dctool_binary_output_t *) dctool_output_allocate (&binary_vtable);
+	if (output == NULL) {
+		goto error_exit;
+	}
+
+	// Allocate the column buffers.
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		output->columns[i] = dc_buffer_new (0);
+	}
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		if (output->columns[i] == NULL)
+			goto error_free;
+	}
+
+	// Open the output file.
+	output->ostream = dctool_writer_open (filename, 1);
+	if (output->ostream == NULL) {
+		goto error_free;
+	}
+
+	output->units = units;
+
+	dctool_writer_u32 (output->ostream, MAGIC);
+	dctool_writer_u32 (output->ostream, VERSION);
+	dctool_writer_u32 (output->ostream, units);
+	dctool_writer_u32 (output->ostream, DCTOOL_COLUMN_COUNT);
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dctool_writer_write (output->ostream, dctool_columns[i].name, strlen (dctool_columns[i].name) + 1);
+	}
+
+	return (dctool_output_t *) output;
+
+error_free:
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dc_buffer_free (output->columns[i]);
+	}
+	dctool_output_deallocate ((dctool_output_t *) output);
+error_exit:
+	return NULL;
+}
+
+static dc_status_t
+dctool_binary_output_write (dctool_output_t *abstract, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize)
+{
+	dctool_binary_output_t *output = (dctool_binary_output_t *) abstract;
+	dctool_writer_t *ostream = output->ostream;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	// Parse the datetime.
+	message ("Parsing the datetime.\n");
+	dc_datetime_t dt = {0};
+	status = dc_parser_get_datetime (parser, &dt);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+		ERROR ("Error parsing the datetime.");
+		return status;
+	}
+
+	// Parse the divetime.
+	message ("Parsing the divetime.\n");
+	unsigned int divetime = 0;
+	status = dc_parser_get_field (parser, DC_FIELD_DIVETIME, 0, &divetime);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+		ERROR ("Error parsing the divetime.");
+		return status;
+	}
+
+	// Parse the maxdepth.
+	message ("Parsing the maxdepth.\n");
+	double maxdepth = 0.0;
+	status = dc_parser_get_field (parser, DC_FIELD_MAXDEPTH, 0, &maxdepth);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+		ERROR ("Error parsing the maxdepth.");
+		return status;
+	}
+
+	// Parse the sample data into the column buffers.
+	message ("Parsing the sample data.\n");
+	row_data_t rowdata = {0};
+	rowdata.columns = output->columns;
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dc_buffer_clear (output->columns[i]);
+	}
+
+	dctool_row_t row;
+	dctool_row_init (&row, output->units, row_cb, &rowdata);
+	status = dc_parser_samples_foreach (parser, dctool_row_sample, &row);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR ("Error parsing the sample data.");
+		return status;
+	}
+	dctool_row_flush (&row);
+
+	if (rowdata.error) {
+		ERROR ("Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	dctool_writer_u32 (ostream, abstract->number);
+	dctool_writer_u32 (ostream, size);
+	dctool_writer_u32 (ostream, fingerprint ? fsize : 0);
+	if (fingerprint)
+		dctool_writer_write (ostream, fingerprint, fsize);
+	dctool_writer_u32 (ostream, dt.year);
+	dctool_writer_u32 (ostream, dt.month);
+	dctool_writer_u32 (ostream, dt.day);
+	dctool_writer_u32 (ostream, dt.hour);
+	dctool_writer_u32 (ostream, dt.minute);
+	dctool_writer_u32 (ostream, dt.second);
+	dctool_writer_u32 (ostream, dt.timezone);
+	dctool_writer_u32 (ostream, divetime);
+	dctool_writer_f64 (ostream, dctool_convert_depth (maxdepth, output->units));
+	dctool_writer_u32 (ostream, rowdata.nrows);
+
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		const double *values = (const double *) dc_buffer_get_data (output->columns[i]);
+		for (unsigned int j = 0; j < rowdata.nrows; ++j) {
+			dctool_writer_f64 (ostream, values[j]);
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dctool_binary_output_free (dctool_output_t *abstract)
+{
+	dctool_binary_output_t *output = (dctool_binary_output_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (dctool_writer_close (output->ostream) != 0)
+		status = DC_STATUS_IO;
+
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dc_buffer_free (output->columns[i]);
+	}
+
+	return status;
+}
@@ -0,0 +1,134 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "output-private.h"
+#include "writer.h"
+#include "utils.h"
+
+static dc_status_t dctool_csv_output_write (dctool_output_t *output, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize);
+static dc_status_t dctool_csv_output_free (dctool_output_t *output);
+
+typedef struct dctool_csv_output_t {
+	dctool_output_t base;
+	dctool_writer_t *ostream;
+	dctool_units_t units;
+} dctool_csv_output_t;
+
+static const dctool_output_vtable_t csv_vtable = {
+	sizeof(dctool_csv_output_t), /* size */
+	dctool_csv_output_write, /* write */
+	dctool_csv_output_free, /* free */
+};
+
+typedef struct row_data_t {
+	dctool_writer_t *ostream;
+	unsigned int number;
+} row_data_t;
+
+static void
+row_cb (const double row[], void *userdata)
+{
+	row_data_t *rowdata = (row_data_t *) userdata;
+
+	dctool_writer_uint (rowdata->ostream, rowdata->number, 0);
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dctool_writer_putc (rowdata->ostream, ',');
+		if (!isnan (row[i]))
+			dctool_writer_double (rowdata->ostream, row[i], dctool_columns[i].decimals);
+	}
+	dctool_writer_putc (rowdata->ostream, '\n');
+}
+
+dctool_output_t *
+dctool_csv_output_new (const char *filename, dctool_units_t units)
+{
+	dctool_csv_output_t *output = NULL;
+
+	if (filename == NULL)
+		goto error_exit;
+
+	// Allocate memory.
+	output = (dctool_csv_output_t *) dctool_output_allocate (&csv_vtable);
+	if (output == NULL) {
+		goto error_exit;
+	}
+
+	// Open the output file.
+	output->ostream = dctool_writer_open (filename, 0);
+	if (output->ostream == NULL) {
+		goto error_free;
+	}
+
+	output->units = units;
+
+	dctool_writer_puts (output->ostream, "dive");
+	for (unsigned int i = 0; i < DCTOOL_COLUMN_COUNT; ++i) {
+		dctool_writer_putc (output->ostream, ',');
+		dctool_writer_puts (output->ostream, dctool_columns[i].name);
+	}
+	dctool_writer_putc (output->ostream, '\n');
+
+	return (dctool_output_t *) output;
+
+error_free:
+	dctool_output_deallocate ((dctool_output_t *) output);
+error_exit:
+	return NULL;
+}
+
+static dc_status_t
+dctool_csv_output_write (dctool_output_t *abstract, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize)
+{
+	dctool_csv_output_t *output = (dctool_csv_output_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	row_data_t rowdata = {0};
+	rowdata.ostream = output->ostream;
+	rowdata.number = abstract->number;
+
+	dctool_row_t row;
+	dctool_row_init (&row, output->units, row_cb, &rowdata);
+
+	// Parse the sample data.
+	message ("Parsing the sample data.\n");
+	status = dc_parser_samples_foreach (parser, dctool_row_sample, &row);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR ("Error parsing the sample data.");
+	}
+
+	dctool_row_flush (&row);
+
+	return status;
+}
+
+static dc_status_t
+dctool_csv_output_free (dctool_output_t *abstract)
+{
+	dctool_csv_output_t *output = (dctool_csv_output_t *) abstract;
+
+	if (dctool_writer_close (output->ostream) != 0)
+		return DC_STATUS_IO;
+
+	return DC_STATUS_SUCCESS;
+}
@@ -23,9 +23,8 @@
 #include <string.h>
 #include <stdio.h>
 
-#include <libdivecomputer/units.h>
-
 #include "output-private.h"
+#include "writer.h"
 #include "utils.h"
 
 static dc_status_t dctool_xml_output_write (dctool_output_t *output, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize);
@@ -33,7 +32,7 @@ static dc_status_t dctool_xml_output_free (dctool_output_t *output);
 
 typedef struct dctool_xml_output_t {
 	dctool_output_t base;
-	FILE *ostream;
+	dctool_writer_t *ostream;
 	dctool_units_t units;
 } dctool_xml_output_t;
 
@@ -44,49 +43,57 @@ static const dctool_output_vtable_t xml_vtable = {
 };
 
 typedef struct sample_data_t {
-	FILE *ostream;
+	dctool_writer_t *ostream;
 	dctool_units_t units;
 	unsigned int nsamples;
 } sample_data_t;
 
-static double
-convert_depth (double value, dctool_units_t units)
+static void
+xml_element_uint (dctool_writer_t *ostream, const char *name, unsigned int value)
 {
-	if (units == DCTOOL_UNITS_IMPERIAL) {
-		return value / FEET;
-	} else {
-		return value;
-	}
+	dctool_writer_putc (ostream, '<');
+	dctool_writer_puts (ostream, name);
+	dctool_writer_putc (ostream, '>');
+	dctool_writer_uint (ostream, value, 0);
+	dctool_writer_puts (ostream, "</");
+	dctool_writer_puts (ostream, name);
+	dctool_writer_puts (ostream, ">\n");
 }
 
-static double
-convert_temperature (double value, dctool_units_t units)
+static void
+xml_element_double (dctool_writer_t *ostream, const char *name, double value, unsigned int decimals)
 {
-	if (units == DCTOOL_UNITS_IMPERIAL) {
-		return value * (9.0 / 5.0) + 32.0;
-	} else {
-		return value;
-	}
+	dctool_writer_putc (ostream, '<');
+	dctool_writer_puts (ostream, name);
+	dctool_writer_putc (ostream, '>');
+	dctool_writer_double (ostream, value, decimals);
+	dctool_writer_puts (ostream, "</");
+	dctool_writer_puts (ostream, name);
+	dctool_writer_puts (ostream, ">\n");
 }
 
-static double
-convert_pressure (double value, dctool_units_t units)
+static void
+xml_element_time (dctool_writer_t *ostream, const char *name, unsigned int value)
 {
-	if (units == DCTOOL_UNITS_IMPERIAL) {
-		return value * BAR / PSI;
-	} else {
-		return value;
-	}
+	dctool_writer_putc (ostream, '<');
+	dctool_writer_puts (ostream, name);
+	dctool_writer_putc (ostream, '>');
+	dctool_writer_uint (ostream, value / 60, 2);
+	dctool_writer_putc (ostream, ':');
+	dctool_writer_uint (ostream, value % 60, 2);
+	dctool_writer_puts (ostream, "</");
+	dctool_writer_puts (ostream, name);
+	dctool_writer_puts (ostream, ">\n");
 }
 
-static double
-convert_volume (double value, dctool_units_t units)
+static void
+xml_attribute_uint (dctool_writer_t *ostream, const char *name, unsigned int value)
 {
-	if (units == DCTOOL_UNITS_IMPERIAL) {
-		return value / 1000.0 / CUFT;
-	} else {
-		return value;
-	}
+	dctool_writer_putc (ostream, ' ');
+	dctool_writer_puts (ostream, name);
+	dctool_writer_puts (ostream, "=\"");
+	dctool_writer_uint (ostream, value, 0);
+	dctool_writer_putc (ostream, '"');
 }
 
 static void
@@ -103,65 +110,90 @@ sample_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
 		"ndl", "safety", "deco", "deep"};
 
 	sample_data_t *sampledata = (sample_data_t *) userdata;
+	dctool_writer_t *ostream = sampledata->ostream;
 
 	switch (type) {
 	case DC_SAMPLE_TIME:
 		if (sampledata->nsamples++)
-			fprintf (sampledata->ostream, "</sample>\n");
-		fprintf (sampledata->ostream, "<sample>\n");
-		fprintf (sampledata->ostream, "   <time>%02u:%02u</time>\n", value.time / 60, value.time % 60);
+			dctool_writer_puts (ostream, "</sample>\n");
+		dctool_writer_puts (ostream, "<sample>\n   ");
+		xml_element_time (ostream, "time", value.time);
 		break;
 	case DC_SAMPLE_DEPTH:
-		fprintf (sampledata->ostream, "   <depth>%.2f</depth>\n",
-			convert_depth(value.depth, sampledata->units));
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "depth",
+			dctool_convert_depth (value.depth, sampledata->units), 2);
 		break;
 	case DC_SAMPLE_PRESSURE:
-		fprintf (sampledata->ostream, "   <pressure tank=\"%u\">%.2f</pressure>\n",
-			value.pressure.tank,
-			convert_pressure(value.pressure.value, sampledata->units));
+		dctool_writer_puts (ostream, "   <pressure");
+		xml_attribute_uint (ostream, "tank", value.pressure.tank);
+		dctool_writer_putc (ostream, '>');
+		dctool_writer_double (ostream,
+			dctool_convert_pressure (value.pressure.value, sampledata->units), 2);
+		dctool_writer_puts (ostream, "</pressure>\n");
 		break;
 	case DC_SAMPLE_TEMPERATURE:
-		fprintf (sampledata->ostream, "   <temperature>%.2f</temperature>\n",
-			convert_temperature(value.temperature, sampledata->units));
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "temperature",
+			dctool_convert_temperature (value.temperature, sampledata->units), 2);
 		break;
 	case DC_SAMPLE_EVENT:
 		if (value.event.type != SAMPLE_EVENT_GASCHANGE && value.event.type != SAMPLE_EVENT_GASCHANGE2) {
-			fprintf (sampledata->ostream, "   <event type=\"%u\" time=\"%u\" flags=\"%u\" value=\"%u\">%s</event>\n",
-				value.event.type, value.event.time, value.event.flags, value.event.value, events[value.event.type]);
+			dctool_writer_puts (ostream, "   <event");
+			xml_attribute_uint (ostream, "type", value.event.type);
+			xml_attribute_uint (ostream, "time", value.event.time);
+			xml_attribute_uint (ostream, "flags", value.event.flags);
+			xml_attribute_uint (ostream, "value", value.event.value);
+			dctool_writer_putc (ostream, '>');
+			dctool_writer_puts (ostream, events[value.event.type]);
+			dctool_writer_puts (ostream, "</event>\n");
 		}
 		break;
 	case DC_SAMPLE_RBT:
-		fprintf (sampledata->ostream, "   <rbt>%u</rbt>\n", value.rbt);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_uint (ostream, "rbt", value.rbt);
 		break;
 	case DC_SAMPLE_HEARTBEAT:
-		fprintf (sampledata->ostream, "   <heartbeat>%u</heartbeat>\n", value.heartbeat);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_uint (ostream, "heartbeat", value.heartbeat);
 		break;
 	case DC_SAMPLE_BEARING:
-		fprintf (sampledata->ostream, "   <bearing>%u</bearing>\n", value.bearing);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_uint (ostream, "bearing", value.bearing);
 		break;
 	case DC_SAMPLE_VENDOR:
-		fprintf (sampledata->ostream, "   <vendor type=\"%u\" size=\"%u\">", value.vendor.type, value.vendor.size);
-		for (unsigned int i = 0; i < value.vendor.size; ++i)
-			fprintf (sampledata->ostream, "%02X", ((const unsigned char *) value.vendor.data)[i]);
-		fprintf (sampledata->ostream, "</vendor>\n");
+		dctool_writer_puts (ostream, "   <vendor");
+		xml_attribute_uint (ostream, "type", value.vendor.type);
+		xml_attribute_uint (ostream, "size", value.vendor.size);
+		dctool_writer_putc (ostream, '>');
+		dctool_writer_hex (ostream, (const unsigned char *) value.vendor.data, value.vendor.size);
+		dctool_writer_puts (ostream, "</vendor>\n");
 		break;
 	case DC_SAMPLE_SETPOINT:
-		fprintf (sampledata->ostream, "   <setpoint>%.2f</setpoint>\n", value.setpoint);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "setpoint", value.setpoint, 2);
 		break;
 	case DC_SAMPLE_PPO2:
-		fprintf (sampledata->ostream, "   <ppo2>%.2f</ppo2>\n", value.ppo2);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "ppo2", value.ppo2, 2);
 		break;
 	case DC_SAMPLE_CNS:
-		fprintf (sampledata->ostream, "   <cns>%.1f</cns>\n", value.cns * 100.0);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "cns", value.cns * 100.0, 1);
 		break;
 	case DC_SAMPLE_DECO:
-		fprintf (sampledata->ostream, "   <deco time=\"%u\" depth=\"%.2f\">%s</deco>\n",
-			value.deco.time,
-			convert_depth(value.deco.depth, sampledata->units),
-			decostop[value.deco.type]);
+		dctool_writer_puts (ostream, "   <deco");
+		xml_attribute_uint (ostream, "time", value.deco.time);
+		dctool_writer_puts (ostream, " depth=\"");
+		dctool_writer_double (ostream,
+			dctool_convert_depth (value.deco.depth, sampledata->units), 2);
+		dctool_writer_puts (ostream, "\">");
+		dctool_writer_puts (ostream, decostop[value.deco.type]);
+		dctool_writer_puts (ostream, "</deco>\n");
 		break;
 	case DC_SAMPLE_GASMIX:
-		fprintf (sampledata->ostream, "   <gasmix>%u</gasmix>\n", value.gasmix);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_uint (ostream, "gasmix", value.gasmix);
 		break;
 	default:
 		break;
@@ -183,14 +215,14 @@ dctool_xml_output_new (const char *filename, dctool_units_t units)
 	}
 
 	// Open the output file.
-	output->ostream = fopen (filename, "w");
+	output->ostream = dctool_writer_open (filename, 0);
 	if (output->ostream == NULL) {
 		goto error_free;
 	}
 
 	output->units = units;
 
-	fprintf (output->ostream, "<device>\n");
+	dctool_writer_puts (output->ostream, "<device>\n");
 
 	return (dctool_output_t *) output;
 
@@ -204,6 +236,7 @@ static dc_status_t
 dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize)
 {
 	dctool_xml_output_t *output = (dctool_xml_output_t *) abstract;
+	dctool_writer_t *ostream = output->ostream;
 	dc_status_t status = DC_STATUS_SUCCESS;
 
 	// Initialize the sample data.
@@ -212,13 +245,14 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 	sampledata.ostream = output->ostream;
 	sampledata.units = output->units;
 
-	fprintf (output->ostream, "<dive>\n<number>%u</number>\n<size>%u</size>\n", abstract->number, size);
+	dctool_writer_puts (ostream, "<dive>\n");
+	xml_element_uint (ostream, "number", abstract->number);
+	xml_element_uint (ostream, "size", size);
 
 	if (fingerprint) {
-		fprintf (output->ostream, "<fingerprint>");
-		for (unsigned int i = 0; i < fsize; ++i)
-			fprintf (output->ostream, "%02X", fingerprint[i]);
-		fprintf (output->ostream, "</fingerprint>\n");
+		dctool_writer_puts (ostream, "<fingerprint>");
+		dctool_writer_hex (ostream, fingerprint, fsize);
+		dctool_writer_puts (ostream, "</fingerprint>\n");
 	}
 
 	// Parse the datetime.
@@ -230,16 +264,27 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 		goto cleanup;
 	}
 
-	if (dt.timezone == DC_TIMEZONE_NONE) {
-		fprintf (output->ostream, "<datetime>%04i-%02i-%02i %02i:%02i:%02i</datetime>\n",
-			dt.year, dt.month, dt.day,
-			dt.hour, dt.minute, dt.second);
-	} else {
-		fprintf (output->ostream, "<datetime>%04i-%02i-%02i %02i:%02i:%02i %+03i:%02i</datetime>\n",
-			dt.year, dt.month, dt.day,
-			dt.hour, dt.minute, dt.second,
-			dt.timezone / 3600, (dt.timezone % 3600) / 60);
+	dctool_writer_puts (ostream, "<datetime>");
+	dctool_writer_uint (ostream, dt.year, 4);
+	dctool_writer_putc (ostream, '-');
+	dctool_writer_uint (ostream, dt.month, 2);
+	dctool_writer_putc (ostream, '-');
+	dctool_writer_uint (ostream, dt.day, 2);
+	dctool_writer_putc (ostream, ' ');
+	dctool_writer_uint (ostream, dt.hour, 2);
+	dctool_writer_putc (ostream, ':');
+	dctool_writer_uint (ostream, dt.minute, 2);
+	dctool_writer_putc (ostream, ':');
+	dctool_writer_uint (ostream, dt.second, 2);
+	if (dt.timezone != DC_TIMEZONE_NONE) {
+		unsigned int timezone = dt.timezone < 0 ? -dt.timezone : dt.timezone;
+		dctool_writer_putc (ostream, ' ');
+		dctool_writer_putc (ostream, dt.timezone < 0 ? '-' : '+');
+		dctool_writer_uint (ostream, timezone / 3600, 2);
+		dctool_writer_putc (ostream, ':');
+		dctool_writer_uint (ostream, (timezone % 3600) / 60, 2);
 	}
+	dctool_writer_puts (ostream, "</datetime>\n");
 
 	// Parse the divetime.
 	message ("Parsing the divetime.\n");
@@ -250,8 +295,7 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 		goto cleanup;
 	}
 
-	fprintf (output->ostream, "<divetime>%02u:%02u</divetime>\n",
-		divetime / 60, divetime % 60);
+	xml_element_time (ostream, "divetime", divetime);
 
 	// Parse the maxdepth.
 	message ("Parsing the maxdepth.\n");
@@ -262,8 +306,8 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 		goto cleanup;
 	}
 
-	fprintf (output->ostream, "<maxdepth>%.2f</maxdepth>\n",
-		convert_depth(maxdepth, output->units));
+	xml_element_double (ostream, "maxdepth",
+		dctool_convert_depth (maxdepth, output->units), 2);
 
 	// Parse the avgdepth.
 	message ("Parsing the avgdepth.\n");
@@ -275,8 +319,8 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 	}
 
 	if (status != DC_STATUS_UNSUPPORTED) {
-		fprintf (output->ostream, "<avgdepth>%.2f</avgdepth>\n",
-			convert_depth(avgdepth, output->units));
+		xml_element_double (ostream, "avgdepth",
+			dctool_convert_depth (avgdepth, output->units), 2);
 	}
 
 	// Parse the temperature.
@@ -295,9 +339,12 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 		}
 
 		if (status != DC_STATUS_UNSUPPORTED) {
-			fprintf (output->ostream, "<temperature type=\"%s\">%.1f</temperature>\n",
-				names[i],
-				convert_temperature(temperature, output->units));
+			dctool_writer_puts (ostream, "<temperature type=\"");
+			dctool_writer_puts (ostream, names[i]);
+			dctool_writer_puts (ostream, "\">");
+			dctool_writer_double (ostream,
+				dctool_convert_temperature (temperature, output->units), 1);
+			dctool_writer_puts (ostream, "</temperature>\n");
 		}
 	}
 
@@ -318,15 +365,13 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 			goto cleanup;
 		}
 
-		fprintf (output->ostream,
-			"<gasmix>\n"
-			"   <he>%.1f</he>\n"
-			"   <o2>%.1f</o2>\n"
-			"   <n2>%.1f</n2>\n"
-			"</gasmix>\n",
-			gasmix.helium * 100.0,
-			gasmix.oxygen * 100.0,
-			gasmix.nitrogen * 100.0);
+		dctool_writer_puts (ostream, "<gasmix>\n   ");
+		xml_element_double (ostream, "he", gasmix.helium * 100.0, 1);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "o2", gasmix.oxygen * 100.0, 1);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "n2", gasmix.nitrogen * 100.0, 1);
+		dctool_writer_puts (ostream, "</gasmix>\n");
 	}
 
 	// Parse the tanks.
@@ -348,27 +393,28 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 			goto cleanup;
 		}
 
-		fprintf (output->ostream, "<tank>\n");
+		dctool_writer_puts (ostream, "<tank>\n");
 		if (tank.gasmix != DC_GASMIX_UNKNOWN) {
-			fprintf (output->ostream,
-				"   <gasmix>%u</gasmix>\n",
-				tank.gasmix);
+			dctool_writer_puts (ostream, "   ");
+			xml_element_uint (ostream, "gasmix", tank.gasmix);
 		}
 		if (tank.type != DC_TANKVOLUME_NONE) {
-			fprintf (output->ostream,
-				"   <type>%s</type>\n"
-				"   <volume>%.1f</volume>\n"
-				"   <workpressure>%.2f</workpressure>\n",
-				names[tank.type],
-				convert_volume(tank.volume, output->units),
-				convert_pressure(tank.workpressure, output->units));
+			dctool_writer_puts (ostream, "   <type>");
+			dctool_writer_puts (ostream, names[tank.type]);
+			dctool_writer_puts (ostream, "</type>\n   ");
+			xml_element_double (ostream, "volume",
+				dctool_convert_volume (tank.volume, output->units), 1);
+			dctool_writer_puts (ostream, "   ");
+			xml_element_double (ostream, "workpressure",
+				dctool_convert_pressure (tank.workpressure, output->units), 2);
 		}
-		fprintf (output->ostream,
-			"   <beginpressure>%.2f</beginpressure>\n"
-			"   <endpressure>%.2f</endpressure>\n"
-			"</tank>\n",
-			convert_pressure(tank.beginpressure, output->units),
-			convert_pressure(tank.endpressure, output->units));
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "beginpressure",
+			dctool_convert_pressure (tank.beginpressure, output->units), 2);
+		dctool_writer_puts (ostream, "   ");
+		xml_element_double (ostream, "endpressure",
+			dctool_convert_pressure (tank.endpressure, output->units), 2);
+		dctool_writer_puts (ostream, "</tank>\n");
 	}
 
 	// Parse the dive mode.
@@ -382,8 +428,9 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 
 	if (status != DC_STATUS_UNSUPPORTED) {
 		const char *names[] = {"freedive", "gauge", "oc", "ccr", "scr"};
-		fprintf (output->ostream, "<divemode>%s</divemode>\n",
-			names[divemode]);
+		dctool_writer_puts (ostream, "<divemode>");
+		dctool_writer_puts (ostream, names[divemode]);
+		dctool_writer_puts (ostream, "</divemode>\n");
 	}
 
 	// Parse the salinity.
@@ -396,8 +443,11 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 	}
 
 	if (status != DC_STATUS_UNSUPPORTED) {
-		fprintf (output->ostream, "<salinity type=\"%u\">%.1f</salinity>\n",
-			salinity.type, salinity.density);
+		dctool_writer_puts (ostream, "<salinity");
+		xml_attribute_uint (ostream, "type", salinity.type);
+		dctool_writer_putc (ostream, '>');
+		dctool_writer_double (ostream, salinity.density, 1);
+		dctool_writer_puts (ostream, "</salinity>\n");
 	}
 
 	// Parse the atmospheric pressure.
@@ -410,8 +460,8 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 	}
 
 	if (status != DC_STATUS_UNSUPPORTED) {
-		fprintf (output->ostream, "<atmospheric>%.5f</atmospheric>\n",
-			convert_pressure(atmospheric, output->units));
+		xml_element_double (ostream, "atmospheric",
+			dctool_convert_pressure (atmospheric, output->units), 5);
 	}
 
 	message ("Parsing strings.\n");
@@ -427,9 +477,11 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 			break;
 		if (!str.desc || !str.value)
 			break;
-		fprintf (output->ostream, "<extradata key='%s' value='%s' />\n",
-			str.desc, str.value);
-
+		dctool_writer_puts (ostream, "<extradata key='");
+		dctool_writer_puts (ostream, str.desc);
+		dctool_writer_puts (ostream, "' value='");
+		dctool_writer_puts (ostream, str.value);
+		dctool_writer_puts (ostream, "' />\n");
 	}
 
 	// Parse the sample data.
@@ -443,8 +495,8 @@ dctool_xml_output_write (dctool_output_t *abstract, dc_parser_t *parser, const u
 cleanup:
 
 	if (sampledata.nsamples)
-		fprintf (output->ostream, "</sample>\n");
-	fprintf (output->ostream, "</dive>\n");
+		dctool_writer_puts (ostream, "</sample>\n");
+	dctool_writer_puts (ostream, "</dive>\n");
 
 	return status;
 }
@@ -454,9 +506,10 @@ dctool_xml_output_free (dctool_output_t *abstract)
 {
 	dctool_xml_output_t *output = (dctool_xml_output_t *) abstract;
 
-	fprintf (output->ostream, "</device>\n");
+	dctool_writer_puts (output->ostream, "</device>\n");
 
-	fclose (output->ostream);
+	if (dctool_writer_close (output->ostream) != 0)
+		return DC_STATUS_IO;
 
 	return DC_STATUS_SUCCESS;
 }
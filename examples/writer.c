@@ -0,0 +1,245 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "writer.h"
+
+#define BUFSIZE (64 * 1024)
+
+// Values with a larger magnitude can't be scaled to an exact integer.
+#define MAXDOUBLE 1e15
+
+struct dctool_writer_t {
+	FILE *ostream;
+	size_t size;
+	int error;
+	unsigned char buffer[BUFSIZE];
+};
+
+static void
+dctool_writer_flush (dctool_writer_t *writer)
+{
+	if (writer->size == 0)
+		return;
+
+	if (!writer->error && fwrite (writer->buffer, 1, writer->size, writer->ostream) != writer->size)
+		writer->error = 1;
+
+	writer->size = 0;
+}
+
+dctool_writer_t *
+dctool_writer_open (const char *filename, int binary)
+{
+	dctool_writer_t *writer = NULL;
+
+	if (filename == NULL)
+		return NULL;
+
+	writer = (dctool_writer_t *) malloc (sizeof (dctool_writer_t));
+	if (writer == NULL)
+		return NULL;
+
+	writer->ostream = fopen (filename, binary ? "wb" : "w");
+	if (writer->ostream == NULL) {
+		free (writer);
+		return NULL;
+	}
+
+	writer->size = 0;
+	writer->error = 0;
+
+	return writer;
+}
+
+int
+dctool_writer_close (dctool_writer_t *writer)
+{
+	int error = 0;
+
+	if (writer == NULL)
+		return 0;
+
+	dctool_writer_flush (writer);
+
+	if (fclose (writer->ostream) != 0)
+		writer->error = 1;
+
+	error = writer->error;
+
+	free (writer);
+
+	return error ? -1 : 0;
+}
+
+void
+dctool_writer_write (dctool_writer_t *writer, const void *data, size_t size)
+{
+	const unsigned char *p = (const unsigned char *) data;
+
+	while (size) {
+		if (writer->size == BUFSIZE)
+			dctool_writer_flush (writer);
+
+		size_t n = BUFSIZE - writer->size;
+		if (n > size)
+			n = size;
+
+		memcpy (writer->buffer + writer->size, p, n);
+		writer->size += n;
+		p += n;
+		size -= n;
+	}
+}
+
+void
+dctool_writer_putc (dctool_writer_t *writer, char c)
+{
+	if (writer->size == BUFSIZE)
+		dctool_writer_flush (writer);
+
+	writer->buffer[writer->size++] = c;
+}
+
+void
+dctool_writer_puts (dctool_writer_t *writer, const char *s)
+{
+	dctool_writer_write (writer, s, strlen (s));
+}
+
+static void
+dctool_writer_digits (dctool_writer_t *writer, unsigned long long value, unsigned int width)
+{
+	char digits[32];
+	unsigned int n = 0;
+
+	do {
+		digits[sizeof (digits) - ++n] = '0' + (value % 10);
+		value /= 10;
+	} while (value && n < sizeof (digits));
+
+	while (n < width && n < sizeof (digits)) {
+		digits[sizeof (digits) - ++n] = '0';
+	}
+
+	dctool_writer_write (writer, digits + sizeof (digits) - n, n);
+}
+
+void
+dctool_writer_uint (dctool_writer_t *writer, unsigned int value, unsigned int width)
+{
+	dctool_writer_digits (writer, value, width);
+}
+
+static void
+dctool_writer_double_slow (dctool_writer_t *writer, double value, unsigned int decimals)
+{
+	char buffer[512];
+	int n = snprintf (buffer, sizeof (buffer), "%.*f", decimals, value);
+	if (n < 0 || (size_t) n >= sizeof (buffer))
+		return;
+
+	// Replace the locale dependent decimal separator.
+	for (int i = 0; i < n; ++i) {
+		if (buffer[i] == ',')
+			buffer[i] = '.';
+	}
+
+	dctool_writer_write (writer, buffer, n);
+}
+
+void
+dctool_writer_double (dctool_writer_t *writer, double value, unsigned int decimals)
+{
+	static const double scales[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+	// Fall back to the C library for special values, very large
+	// numbers and precisions which are not used in practice.
+	if (decimals >= sizeof (scales) / sizeof (scales[0]) ||
+		!(fabs (value) < MAXDOUBLE / scales[decimals])) {
+		dctool_writer_double_slow (writer, value, decimals);
+		return;
+	}
+
+	double scaled = fabs (value) * scales[decimals];
+	double integer = floor (scaled);
+	double fraction = scaled - integer;
+
+	// Values halfway between two results are rounded by the C library,
+	// to get exactly the same result as printf.
+	if (fabs (fraction - 0.5) < 1e-6) {
+		dctool_writer_double_slow (writer, value, decimals);
+		return;
+	}
+
+	unsigned long long scale = (unsigned long long) scales[decimals];
+	unsigned long long number = (unsigned long long) integer + (fraction > 0.5);
+
+	// The sign of a negative zero is printed as well, like printf does.
+	if (signbit (value))
+		dctool_writer_putc (writer, '-');
+
+	dctool_writer_digits (writer, number / scale, 0);
+	if (decimals) {
+		dctool_writer_putc (writer, '.');
+		dctool_writer_digits (writer, number % scale, decimals);
+	}
+}
+
+void
+dctool_writer_hex (dctool_writer_t *writer, const unsigned char data[], size_t size)
+{
+	const char ascii[] = {
+		'0', '1', '2', '3', '4', '5', '6', '7',
+		'8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+	for (size_t i = 0; i < size; ++i) {
+		dctool_writer_putc (writer, ascii[(data[i] >> 4) & 0x0F]);
+		dctool_writer_putc (writer, ascii[data[i] & 0x0F]);
+	}
+}
+
+void
+dctool_writer_u32 (dctool_writer_t *writer, unsigned int value)
+{
+	unsigned char data[4] = {
+		value & 0xFF,
+		(value >> 8) & 0xFF,
+		(value >> 16) & 0xFF,
+		(value >> 24) & 0xFF};
+
+	dctool_writer_write (writer, data, sizeof (data));
+}
+
+void
+dctool_writer_f64 (dctool_writer_t *writer, double value)
+{
+	unsigned long long bits = 0;
+	memcpy (&bits, &value, sizeof (bits));
+
+	dctool_writer_u32 (writer, bits & 0xFFFFFFFF);
+	dctool_writer_u32 (writer, (bits >> 32) & 0xFFFFFFFF);
+}
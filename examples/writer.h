@@ -0,0 +1,86 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DCTOOL_WRITER_H
+#define DCTOOL_WRITER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Buffered output stream.
+ *
+ * All output is collected in a large memory buffer, and only written to
+ * the file when the buffer is full. Numbers are formatted without the C
+ * library, so the output does not depend on the current locale. Errors
+ * are sticky, and reported by dctool_writer_close.
+ */
+typedef struct dctool_writer_t dctool_writer_t;
+
+dctool_writer_t *
+dctool_writer_open (const char *filename, int binary);
+
+int
+dctool_writer_close (dctool_writer_t *writer);
+
+void
+dctool_writer_write (dctool_writer_t *writer, const void *data, size_t size);
+
+void
+dctool_writer_putc (dctool_writer_t *writer, char c);
+
+void
+dctool_writer_puts (dctool_writer_t *writer, const char *s);
+
+/*
+ * Write an unsigned integer, padded with zeros to at least the given
+ * number of digits.
+ */
+void
+dctool_writer_uint (dctool_writer_t *writer, unsigned int value, unsigned int width);
+
+/*
+ * Write a floating point number with a fixed number of decimals, the
+ * equivalent of the "%.*f" printf conversion with a '.' as the decimal
+ * separator.
+ */
+void
+dctool_writer_double (dctool_writer_t *writer, double value, unsigned int decimals);
+
+void
+dctool_writer_hex (dctool_writer_t *writer, const unsigned char data[], size_t size);
+
+/*
+ * Write a number in little endian binary format.
+ */
+void
+dctool_writer_u32 (dctool_writer_t *writer, unsigned int value);
+
+void
+dctool_writer_f64 (dctool_writer_t *writer, double value);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DCTOOL_WRITER_H */
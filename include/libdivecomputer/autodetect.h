@@ -0,0 +1,87 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_AUTODETECT_H
+#define DC_AUTODETECT_H
+
+#include "common.h"
+#include "context.h"
+#include "iterator.h"
+#include "descriptor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dc_autodetect_match_t dc_autodetect_match_t;
+
+typedef enum dc_autodetect_rank_t {
+	/* Matched by the name the device advertises. */
+	DC_AUTODETECT_NAME = 1,
+	/* Identified by its USB id, or by its reply to a probe command. */
+	DC_AUTODETECT_DEVICE = 2,
+} dc_autodetect_rank_t;
+
+/*
+ * Enumerate the devices on all requested transports at the same time,
+ * and return an iterator with the matching descriptors, best matches
+ * first. USB HID devices are matched by their vendor and product id,
+ * bluetooth and IrDA devices by their name. Each serial port is probed
+ * with the version command of the families that support one, and all
+ * ports are probed in parallel.
+ *
+ * The timeout (in milliseconds) bounds the probes: once it expires, all
+ * pending probes are cancelled. A zero timeout waits for all probes to
+ * finish. A bluetooth inquiry or IrDA discovery
+ * cannot be interrupted and always runs to completion. A zero transports
+ * mask selects all transports supported by the context.
+ *
+ * The transport device returned by dc_autodetect_match_get_device is a
+ * dc_serial_device_t, dc_usbhid_device_t, dc_bluetooth_device_t or
+ * dc_irda_device_t, depending on the transport, and is owned by the
+ * match.
+ */
+
+dc_status_t
+dc_autodetect (dc_iterator_t **iterator, dc_context_t *context, unsigned int transports, unsigned int timeout);
+
+dc_descriptor_t *
+dc_autodetect_match_get_descriptor (dc_autodetect_match_t *match);
+
+dc_transport_t
+dc_autodetect_match_get_transport (dc_autodetect_match_t *match);
+
+dc_autodetect_rank_t
+dc_autodetect_match_get_rank (dc_autodetect_match_t *match);
+
+const char *
+dc_autodetect_match_get_name (dc_autodetect_match_t *match);
+
+void *
+dc_autodetect_match_get_device (dc_autodetect_match_t *match);
+
+void
+dc_autodetect_match_free (dc_autodetect_match_t *match);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_AUTODETECT_H */
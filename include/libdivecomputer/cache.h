@@ -0,0 +1,55 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_CACHE_H
+#define DC_CACHE_H
+
+#include "common.h"
+#include "context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dc_cache_t dc_cache_t;
+
+/*
+ * The parser cache stores the output of the parser (date/time, fields
+ * and samples) for each dive in a compact binary file in the given
+ * directory. Entries are keyed by a hash of the family, the model, the
+ * raw dive data, the calibration of the parser and the library version,
+ * so any change in the library invalidates the cache automatically.
+ *
+ * A cache is attached to a parser with dc_parser_set_cache. Dives with
+ * sample types the cache can't store are not cached, and are always
+ * parsed again.
+ */
+
+dc_status_t
+dc_cache_open (dc_cache_t **cache, dc_context_t *context, const char *directory);
+
+dc_status_t
+dc_cache_close (dc_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_CACHE_H */
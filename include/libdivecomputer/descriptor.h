@@ -52,6 +52,26 @@ dc_descriptor_get_model (dc_descriptor_t *descriptor);
 unsigned int
 dc_descriptor_get_transports (dc_descriptor_t *descriptor);
 
+/*
+ * Find the descriptor for a family and model number, a "vendor product"
+ * or product name (case-insensitive, with whitespace collapsed), a USB
+ * vendor and product id, or a bluetooth device name. If the model number
+ * is unknown, the first descriptor of the family is returned. All return
+ * DC_STATUS_UNSUPPORTED if there is no matching descriptor.
+ */
+
+dc_status_t
+dc_descriptor_lookup_model (dc_descriptor_t **descriptor, dc_family_t family, unsigned int model);
+
+dc_status_t
+dc_descriptor_lookup_name (dc_descriptor_t **descriptor, const char *name);
+
+dc_status_t
+dc_descriptor_lookup_usb (dc_descriptor_t **descriptor, unsigned int vid, unsigned int pid);
+
+dc_status_t
+dc_descriptor_lookup_bluetooth (dc_descriptor_t **descriptor, const char *name);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -28,6 +28,7 @@
 #include "iostream.h"
 #include "buffer.h"
 #include "datetime.h"
+#include "store.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -79,9 +80,26 @@ dc_device_get_type (dc_device_t *device);
 dc_status_t
 dc_device_set_cancel (dc_device_t *device, dc_cancel_callback_t callback, void *userdata);
 
+dc_status_t
+dc_device_cancel (dc_device_t *device);
+
 dc_status_t
 dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callback_t callback, void *userdata);
 
+/*
+ * Limit the rate of the progress events. A progress event is only passed
+ * to the event callback once at least the interval (in milliseconds) has
+ * elapsed, and the progress has advanced by at least the delta (in
+ * thousandths of the maximum) since the last one that was passed. Zero
+ * disables a limit. The first and the final event of a transfer are
+ * always passed on.
+ */
+dc_status_t
+dc_device_set_progress (dc_device_t *device, unsigned int interval, unsigned int delta);
+
+dc_status_t
+dc_device_set_store (dc_device_t *device, dc_store_t *store);
+
 dc_status_t
 dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 
@@ -97,6 +115,15 @@ dc_device_dump (dc_device_t *device, dc_buffer_t *buffer);
 dc_status_t
 dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+dc_status_t
+dc_device_foreach_pipelined (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+dc_status_t
+dc_device_foreach_headers (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+dc_status_t
+dc_device_read_dive (dc_device_t *device, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
+
 dc_status_t
 dc_device_timesync (dc_device_t *device, const dc_datetime_t *datetime);
 
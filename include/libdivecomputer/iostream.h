@@ -273,6 +273,22 @@ dc_iostream_purge (dc_iostream_t *iostream, dc_direction_t direction);
 dc_status_t
 dc_iostream_sleep (dc_iostream_t *iostream, unsigned int milliseconds);
 
+/**
+ * Cancel all pending and future I/O operations.
+ *
+ * While cancelled, every read, write and sleep operation returns
+ * #DC_STATUS_CANCELLED immediately, and an operation that is blocked
+ * waiting for data is interrupted. Unlike the other functions, this
+ * function can be called from another thread.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[in]  value     Non-zero to cancel, zero to resume.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_iostream_set_cancelled (dc_iostream_t *iostream, unsigned int value);
+
 /**
  * Close the I/O stream and free all resources.
  *
@@ -27,6 +27,7 @@
 #include "descriptor.h"
 #include "device.h"
 #include "datetime.h"
+#include "cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -264,6 +265,9 @@ dc_parser_new2 (dc_parser_t **parser, dc_context_t *context, dc_descriptor_t *de
 dc_family_t
 dc_parser_get_type (dc_parser_t *parser);
 
+dc_status_t
+dc_parser_set_cache (dc_parser_t *parser, dc_cache_t *cache);
+
 dc_status_t
 dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int size);
 
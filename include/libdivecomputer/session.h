@@ -0,0 +1,65 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_SESSION_H
+#define DC_SESSION_H
+
+#include "common.h"
+#include "device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dc_session_t dc_session_t;
+
+/*
+ * A session downloads the dives of a device in the background, and
+ * delivers the events and the dives on the thread that calls
+ * dc_session_dispatch. The file descriptor of the session becomes
+ * readable whenever there is something to dispatch, so it can be
+ * watched from any event loop (poll, epoll, glib, Qt, ...).
+ *
+ * The dispatch function returns DC_STATUS_SUCCESS while the download
+ * is still running, DC_STATUS_DONE once it has finished successfully,
+ * or the error code of the download. While the session is active, the
+ * device must not be used directly.
+ */
+
+dc_status_t
+dc_session_new (dc_session_t **session, dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+int
+dc_session_get_fd (dc_session_t *session);
+
+dc_status_t
+dc_session_dispatch (dc_session_t *session);
+
+dc_status_t
+dc_session_cancel (dc_session_t *session);
+
+dc_status_t
+dc_session_free (dc_session_t *session);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_SESSION_H */
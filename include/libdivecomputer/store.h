@@ -0,0 +1,85 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_STORE_H
+#define DC_STORE_H
+
+#include "common.h"
+#include "context.h"
+#include "buffer.h"
+#include "datetime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef enum dc_store_flags_t {
+	DC_STORE_DEFAULT = 0,
+	DC_STORE_HASHES = (1 << 0),
+	DC_STORE_MIRROR = (1 << 1),
+	DC_STORE_CHECKPOINT = (1 << 2),
+} dc_store_flags_t;
+
+typedef struct dc_store_t dc_store_t;
+
+/*
+ * The store persists the download state of each device (identified by its
+ * family and serial number) in a single file per device in the given
+ * directory. All updates are kept in memory, and written to disk with an
+ * atomic replace by dc_store_sync and dc_store_close.
+ *
+ * With DC_STORE_CHECKPOINT, the data of an interrupted download is kept in
+ * a separate file, such that the next attempt can continue where the
+ * previous one stopped. The checkpoints are removed again after a
+ * successful download.
+ */
+
+dc_status_t
+dc_store_open (dc_store_t **store, dc_context_t *context, const char *directory, unsigned int flags);
+
+dc_status_t
+dc_store_sync (dc_store_t *store);
+
+dc_status_t
+dc_store_close (dc_store_t *store);
+
+dc_status_t
+dc_store_get_fingerprint (dc_store_t *store, dc_family_t family, unsigned int serial, dc_buffer_t *fingerprint);
+
+dc_status_t
+dc_store_set_fingerprint (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size);
+
+dc_status_t
+dc_store_get_clock (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int *devtime, dc_ticks_t *systime);
+
+dc_status_t
+dc_store_set_clock (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int devtime, dc_ticks_t systime);
+
+int
+dc_store_has_dive (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size);
+
+dc_status_t
+dc_store_add_dive (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_STORE_H */
@@ -34,6 +34,15 @@ extern "C" {
 dc_status_t
 suunto_d9_device_version (dc_device_t *device, unsigned char data[], unsigned int size);
 
+/*
+ * Enable the pipelined profile download. The next read command is sent
+ * as soon as the previous answer has arrived, and the answer is verified
+ * while the next one is being transferred. On any error, the download
+ * falls back to the default lock-step mode. Disabled by default.
+ */
+dc_status_t
+suunto_d9_device_set_pipelined (dc_device_t *device, unsigned int value);
+
 dc_status_t
 suunto_d9_device_reset_maxdepth (dc_device_t *device);
 
@@ -55,12 +55,16 @@ array_reverse_bits (unsigned char data[], unsigned int size)
 int
 array_isequal (const unsigned char data[], unsigned int size, unsigned char value)
 {
-	for (unsigned int i = 0; i < size; ++i) {
-		if (data[i] != value)
-			return 0;
-	}
+	if (size == 0)
+		return 1;
 
-	return 1;
+	if (data[0] != value)
+		return 0;
+
+	// All bytes are equal to the first one, if and only if the array is
+	// equal to itself shifted by one byte. This lets the (vectorized)
+	// memcmp implementation of the C library do the heavy lifting.
+	return memcmp (data, data + 1, size - 1) == 0;
 }
 
 
@@ -68,11 +72,19 @@ const unsigned char *
 array_search_forward (const unsigned char *data, unsigned int size,
                       const unsigned char *marker, unsigned int msize)
 {
+	if (msize == 0)
+		return data;
+
+	const unsigned char *end = data + size;
 	while (size >= msize) {
-		if (memcmp (data, marker, msize) == 0)
-			return data;
-		size--;
-		data++;
+		// Skip quickly to the next candidate position with memchr.
+		const unsigned char *p = memchr (data, marker[0], size - msize + 1);
+		if (p == NULL)
+			break;
+		if (memcmp (p + 1, marker + 1, msize - 1) == 0)
+			return p;
+		data = p + 1;
+		size = end - data;
 	}
 	return NULL;
 }
@@ -82,9 +94,14 @@ const unsigned char *
 array_search_backward (const unsigned char *data, unsigned int size,
                        const unsigned char *marker, unsigned int msize)
 {
+	if (msize == 0)
+		return data + size;
+
+	const unsigned char last = marker[msize - 1];
 	data += size;
 	while (size >= msize) {
-		if (memcmp (data - msize, marker, msize) == 0)
+		// Only compare the full marker when the last byte matches.
+		if (data[-1] == last && memcmp (data - msize, marker, msize - 1) == 0)
 			return data;
 		size--;
 		data--;
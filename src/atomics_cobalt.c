@@ -75,6 +75,8 @@ static const dc_device_vtable_t atomics_cobalt_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	atomics_cobalt_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	atomics_cobalt_device_close /* close */
 };
@@ -109,7 +109,7 @@ atomics_cobalt_parser_set_calibration (dc_parser_t *abstract, double atmospheric
 	parser->atmospheric = atmospheric;
 	parser->hydrostatic = hydrostatic;
 
-	return DC_STATUS_SUCCESS;
+	return dc_parser_calibrate (abstract, atmospheric, hydrostatic);
 }
 
 
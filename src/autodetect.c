@@ -0,0 +1,721 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libdivecomputer/autodetect.h>
+#include <libdivecomputer/serial.h>
+#include <libdivecomputer/usbhid.h>
+#include <libdivecomputer/bluetooth.h>
+#include <libdivecomputer/irda.h>
+#include <libdivecomputer/hw_ostc3.h>
+#include <libdivecomputer/hw_frog.h>
+#include <libdivecomputer/suunto_d9.h>
+#include <libdivecomputer/oceanic_atom2.h>
+#include <libdivecomputer/oceanic_veo250.h>
+#include <libdivecomputer/oceanic_vtpro.h>
+
+#include "descriptor-private.h"
+#include "iterator-private.h"
+#include "context-private.h"
+#include "device-private.h"
+#include "thread.h"
+#include "timer.h"
+
+#define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
+
+#define SZ_VERSION 64
+
+typedef dc_status_t (*dc_autodetect_version_t) (dc_device_t *device, unsigned char data[], unsigned int size);
+
+typedef struct dc_autodetect_probe_t {
+	dc_family_t family;
+	// A second family sharing the same protocol, which is only
+	// distinguished by the model number.
+	dc_family_t related;
+	dc_autodetect_version_t version;
+	unsigned int size;
+	// Offset of the model number in the version data, or -1 if the
+	// version data does not contain the model number.
+	int model;
+} dc_autodetect_probe_t;
+
+/*
+ * The families with a version command that needs no prior setup. They
+ * are tried in this order on each serial port, until one of them gets
+ * a valid answer.
+ */
+static const dc_autodetect_probe_t g_probes[] = {
+	{DC_FAMILY_HW_OSTC3,       DC_FAMILY_NULL,          hw_ostc3_device_version,       64, -1},
+	{DC_FAMILY_HW_FROG,        DC_FAMILY_NULL,          hw_frog_device_version,        17, -1},
+	{DC_FAMILY_SUUNTO_D9,      DC_FAMILY_SUUNTO_VYPER2, suunto_d9_device_version,       4,  0},
+	{DC_FAMILY_OCEANIC_ATOM2,  DC_FAMILY_NULL,          oceanic_atom2_device_version,  16, -1},
+	{DC_FAMILY_OCEANIC_VEO250, DC_FAMILY_NULL,          oceanic_veo250_device_version, 16, -1},
+	{DC_FAMILY_OCEANIC_VTPRO,  DC_FAMILY_NULL,          oceanic_vtpro_device_version,  16, -1},
+};
+
+struct dc_autodetect_match_t {
+	dc_descriptor_t *descriptor;
+	dc_transport_t transport;
+	dc_autodetect_rank_t rank;
+	size_t sequence;
+	void *device;
+};
+
+typedef struct dc_autodetect_t {
+	dc_context_t *context;
+	// Silent context for the probes, which fail on every port
+	// without a matching device.
+	dc_context_t *quiet;
+	unsigned int transports;
+	unsigned int timeout;
+	dc_timer_t *timer;
+	// NULL on platforms without thread support.
+	dc_mutex_t *mutex;
+	dc_cond_t *cond;
+	unsigned int pending;
+	unsigned int cancelled;
+	dc_autodetect_match_t **matches;
+	size_t count, capacity;
+} dc_autodetect_t;
+
+typedef struct dc_autodetect_job_t {
+	dc_autodetect_t *autodetect;
+	void (*func) (struct dc_autodetect_job_t *job);
+	dc_thread_t *thread;
+	// Serial port to probe, and the I/O stream of the running probe.
+	dc_serial_device_t *port;
+	dc_iostream_t *iostream;
+} dc_autodetect_job_t;
+
+typedef struct dc_autodetect_iterator_t {
+	dc_iterator_t base;
+	dc_autodetect_match_t **matches;
+	size_t count, current;
+} dc_autodetect_iterator_t;
+
+static dc_status_t dc_autodetect_iterator_next (dc_iterator_t *iterator, void *item);
+static dc_status_t dc_autodetect_iterator_free (dc_iterator_t *iterator);
+
+static const dc_iterator_vtable_t dc_autodetect_iterator_vtable = {
+	sizeof(dc_autodetect_iterator_t),
+	dc_autodetect_iterator_next,
+	dc_autodetect_iterator_free,
+};
+
+static void
+dc_autodetect_lock (dc_autodetect_t *autodetect)
+{
+	if (autodetect->mutex)
+		dc_mutex_lock (autodetect->mutex);
+}
+
+static void
+dc_autodetect_unlock (dc_autodetect_t *autodetect)
+{
+	if (autodetect->mutex)
+		dc_mutex_unlock (autodetect->mutex);
+}
+
+static unsigned int
+dc_autodetect_remaining (dc_autodetect_t *autodetect)
+{
+	dc_usecs_t now = 0;
+	if (dc_timer_now (autodetect->timer, &now) != DC_STATUS_SUCCESS)
+		return 0;
+
+	dc_usecs_t elapsed = now / 1000;
+	if (elapsed >= autodetect->timeout)
+		return 0;
+
+	return autodetect->timeout - elapsed;
+}
+
+static int
+dc_autodetect_is_cancelled (dc_autodetect_t *autodetect)
+{
+	dc_autodetect_lock (autodetect);
+	if (!autodetect->cancelled && autodetect->timeout && dc_autodetect_remaining (autodetect) == 0)
+		autodetect->cancelled = 1;
+	int cancelled = autodetect->cancelled;
+	dc_autodetect_unlock (autodetect);
+
+	return cancelled;
+}
+
+static void
+dc_autodetect_device_free (dc_transport_t transport, void *device)
+{
+	switch (transport) {
+	case DC_TRANSPORT_SERIAL:
+		dc_serial_device_free ((dc_serial_device_t *) device);
+		break;
+	case DC_TRANSPORT_USBHID:
+		dc_usbhid_device_free ((dc_usbhid_device_t *) device);
+		break;
+	case DC_TRANSPORT_BLUETOOTH:
+		dc_bluetooth_device_free ((dc_bluetooth_device_t *) device);
+		break;
+	case DC_TRANSPORT_IRDA:
+		dc_irda_device_free ((dc_irda_device_t *) device);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+dc_autodetect_add (dc_autodetect_t *autodetect, dc_descriptor_t *descriptor, dc_transport_t transport, dc_autodetect_rank_t rank, void *device)
+{
+	dc_autodetect_match_t *match = (dc_autodetect_match_t *) malloc (sizeof (dc_autodetect_match_t));
+	if (match == NULL) {
+		ERROR (autodetect->context, "Failed to allocate memory.");
+		dc_autodetect_device_free (transport, device);
+		return;
+	}
+
+	match->descriptor = descriptor;
+	match->transport = transport;
+	match->rank = rank;
+	match->device = device;
+
+	dc_autodetect_lock (autodetect);
+
+	if (autodetect->count == autodetect->capacity) {
+		size_t capacity = autodetect->capacity ? autodetect->capacity * 2 : 8;
+		dc_autodetect_match_t **matches = (dc_autodetect_match_t **) realloc (autodetect->matches, capacity * sizeof (dc_autodetect_match_t *));
+		if (matches == NULL) {
+			dc_autodetect_unlock (autodetect);
+			ERROR (autodetect->context, "Failed to allocate memory.");
+			dc_autodetect_match_free (match);
+			return;
+		}
+		autodetect->matches = matches;
+		autodetect->capacity = capacity;
+	}
+
+	match->sequence = autodetect->count;
+	autodetect->matches[autodetect->count++] = match;
+
+	dc_autodetect_unlock (autodetect);
+
+	INFO (autodetect->context, "Found %s %s (%s).",
+		dc_descriptor_get_vendor (descriptor),
+		dc_descriptor_get_product (descriptor),
+		rank == DC_AUTODETECT_DEVICE ? "identified" : "by name");
+}
+
+static dc_status_t
+dc_autodetect_probe (dc_autodetect_job_t *job, const dc_autodetect_probe_t *probe, dc_descriptor_t *descriptor, unsigned int *model)
+{
+	dc_autodetect_t *autodetect = job->autodetect;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_iostream_t *iostream = NULL;
+	dc_device_t *device = NULL;
+	unsigned char data[SZ_VERSION] = {0};
+
+	status = dc_serial_open (&iostream, autodetect->quiet, dc_serial_device_get_name (job->port));
+	if (status != DC_STATUS_SUCCESS) {
+		return status;
+	}
+
+	// Publish the I/O stream, such that the probe can be cancelled once
+	// the timeout expires.
+	dc_autodetect_lock (autodetect);
+	if (autodetect->cancelled)
+		status = DC_STATUS_CANCELLED;
+	else
+		job->iostream = iostream;
+	dc_autodetect_unlock (autodetect);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_close;
+
+	status = dc_device_open (&device, autodetect->quiet, descriptor, iostream);
+	if (status == DC_STATUS_SUCCESS) {
+		status = probe->version (device, data, probe->size);
+		// The I/O stream is not resumed, because the probe can be
+		// cancelled at any time, including during the shutdown
+		// handshake. Once cancelled, the handshake fails immediately.
+		dc_device_abort (device);
+	}
+
+	dc_autodetect_lock (autodetect);
+	job->iostream = NULL;
+	if (status != DC_STATUS_SUCCESS && autodetect->cancelled)
+		status = DC_STATUS_CANCELLED;
+	dc_autodetect_unlock (autodetect);
+
+	if (status == DC_STATUS_SUCCESS && probe->model >= 0)
+		*model = data[probe->model];
+
+error_close:
+	dc_iostream_close (iostream);
+	return status;
+}
+
+static void
+dc_autodetect_serial (dc_autodetect_job_t *job)
+{
+	dc_autodetect_t *autodetect = job->autodetect;
+	const char *name = dc_serial_device_get_name (job->port);
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_probes); ++i) {
+		const dc_autodetect_probe_t *probe = &g_probes[i];
+
+		if (dc_autodetect_is_cancelled (autodetect))
+			break;
+
+		dc_descriptor_t *descriptor = NULL;
+		if (dc_descriptor_lookup_model (&descriptor, probe->family, 0) != DC_STATUS_SUCCESS)
+			continue;
+
+		dc_filter_t filter = dc_descriptor_get_filter (descriptor);
+		if (filter && !filter (DC_TRANSPORT_SERIAL, name))
+			continue;
+
+		unsigned int model = 0;
+		dc_status_t status = dc_autodetect_probe (job, probe, descriptor, &model);
+		if (status == DC_STATUS_SUCCESS) {
+			if (probe->model >= 0) {
+				// Prefer an exact match in either of the families.
+				dc_descriptor_lookup_model (&descriptor, probe->family, model);
+				if (dc_descriptor_get_model (descriptor) != model && probe->related != DC_FAMILY_NULL) {
+					dc_descriptor_t *related = NULL;
+					if (dc_descriptor_lookup_model (&related, probe->related, model) == DC_STATUS_SUCCESS &&
+						dc_descriptor_get_model (related) == model)
+						descriptor = related;
+				}
+			}
+
+			dc_autodetect_add (autodetect, descriptor, DC_TRANSPORT_SERIAL, DC_AUTODETECT_DEVICE, job->port);
+			job->port = NULL;
+			break;
+		} else if (status == DC_STATUS_CANCELLED || status == DC_STATUS_NODEVICE ||
+			status == DC_STATUS_NOACCESS) {
+			break;
+		}
+	}
+}
+
+static void
+dc_autodetect_usbhid (dc_autodetect_job_t *job)
+{
+	dc_autodetect_t *autodetect = job->autodetect;
+	dc_iterator_t *iterator = NULL;
+	dc_usbhid_device_t *device = NULL;
+
+	dc_status_t status = dc_usbhid_iterator_new (&iterator, autodetect->context, NULL);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (autodetect->context, "Failed to enumerate the USB HID devices.");
+		return;
+	}
+
+	while (dc_iterator_next (iterator, &device) == DC_STATUS_SUCCESS) {
+		dc_descriptor_t *descriptor = NULL;
+		status = dc_descriptor_lookup_usb (&descriptor,
+			dc_usbhid_device_get_vid (device), dc_usbhid_device_get_pid (device));
+		if (status == DC_STATUS_SUCCESS &&
+			(dc_descriptor_get_transports (descriptor) & DC_TRANSPORT_USBHID)) {
+			dc_autodetect_add (autodetect, descriptor, DC_TRANSPORT_USBHID, DC_AUTODETECT_DEVICE, device);
+		} else {
+			dc_usbhid_device_free (device);
+		}
+	}
+
+	dc_iterator_free (iterator);
+}
+
+static void
+dc_autodetect_bluetooth (dc_autodetect_job_t *job)
+{
+	dc_autodetect_t *autodetect = job->autodetect;
+	dc_iterator_t *iterator = NULL;
+	dc_bluetooth_device_t *device = NULL;
+
+	dc_status_t status = dc_bluetooth_iterator_new (&iterator, autodetect->context, NULL);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (autodetect->context, "Failed to enumerate the bluetooth devices.");
+		return;
+	}
+
+	while (dc_iterator_next (iterator, &device) == DC_STATUS_SUCCESS) {
+		dc_descriptor_t *descriptor = NULL;
+		const char *name = dc_bluetooth_device_get_name (device);
+		status = name ? dc_descriptor_lookup_bluetooth (&descriptor, name) : DC_STATUS_UNSUPPORTED;
+		if (status == DC_STATUS_SUCCESS &&
+			(dc_descriptor_get_transports (descriptor) & DC_TRANSPORT_BLUETOOTH)) {
+			dc_autodetect_add (autodetect, descriptor, DC_TRANSPORT_BLUETOOTH, DC_AUTODETECT_NAME, device);
+		} else {
+			dc_bluetooth_device_free (device);
+		}
+	}
+
+	dc_iterator_free (iterator);
+}
+
+static dc_descriptor_t *
+dc_autodetect_irda_lookup (const char *name)
+{
+	dc_iterator_t *iterator = NULL;
+	dc_descriptor_t *descriptor = NULL, *result = NULL;
+
+	// IrDA names are only known to the filters, and IrDA devices are
+	// rare enough that a linear search is fine.
+	if (dc_descriptor_iterator (&iterator) != DC_STATUS_SUCCESS)
+		return NULL;
+
+	while (result == NULL && dc_iterator_next (iterator, &descriptor) == DC_STATUS_SUCCESS) {
+		dc_filter_t filter = dc_descriptor_get_filter (descriptor);
+		if ((dc_descriptor_get_transports (descriptor) & DC_TRANSPORT_IRDA) &&
+			filter && filter (DC_TRANSPORT_IRDA, name)) {
+			result = descriptor;
+		}
+	}
+
+	dc_iterator_free (iterator);
+
+	return result;
+}
+
+static void
+dc_autodetect_irda (dc_autodetect_job_t *job)
+{
+	dc_autodetect_t *autodetect = job->autodetect;
+	dc_iterator_t *iterator = NULL;
+	dc_irda_device_t *device = NULL;
+
+	dc_status_t status = dc_irda_iterator_new (&iterator, autodetect->context, NULL);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (autodetect->context, "Failed to enumerate the IrDA devices.");
+		return;
+	}
+
+	while (dc_iterator_next (iterator, &device) == DC_STATUS_SUCCESS) {
+		dc_descriptor_t *descriptor = dc_autodetect_irda_lookup (dc_irda_device_get_name (device));
+		if (descriptor) {
+			dc_autodetect_add (autodetect, descriptor, DC_TRANSPORT_IRDA, DC_AUTODETECT_NAME, device);
+		} else {
+			dc_irda_device_free (device);
+		}
+	}
+
+	dc_iterator_free (iterator);
+}
+
+static void
+dc_autodetect_run (void *userdata)
+{
+	dc_autodetect_job_t *job = (dc_autodetect_job_t *) userdata;
+	dc_autodetect_t *autodetect = job->autodetect;
+
+	job->func (job);
+
+	dc_mutex_lock (autodetect->mutex);
+	autodetect->pending--;
+	dc_cond_signal (autodetect->cond);
+	dc_mutex_unlock (autodetect->mutex);
+}
+
+static int
+dc_autodetect_compare (const void *a, const void *b)
+{
+	const dc_autodetect_match_t *ma = *(const dc_autodetect_match_t * const *) a;
+	const dc_autodetect_match_t *mb = *(const dc_autodetect_match_t * const *) b;
+
+	if (ma->rank != mb->rank)
+		return ma->rank > mb->rank ? -1 : 1;
+
+	// Keep the order in which the devices were found.
+	if (ma->sequence != mb->sequence)
+		return ma->sequence < mb->sequence ? -1 : 1;
+
+	return 0;
+}
+
+dc_status_t
+dc_autodetect (dc_iterator_t **out, dc_context_t *context, unsigned int transports, unsigned int timeout)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_autodetect_iterator_t *iterator = NULL;
+	dc_autodetect_t autodetect;
+	dc_autodetect_job_t *jobs = NULL;
+	dc_serial_device_t **ports = NULL;
+	size_t nports = 0, njobs = 0;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	memset (&autodetect, 0, sizeof (autodetect));
+	autodetect.context = context;
+	autodetect.timeout = timeout;
+	autodetect.transports = dc_context_get_transports (context);
+	if (transports)
+		autodetect.transports &= transports;
+
+	iterator = (dc_autodetect_iterator_t *) dc_iterator_allocate (context, &dc_autodetect_iterator_vtable);
+	if (iterator == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	status = dc_timer_new (&autodetect.timer);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create a high resolution timer.");
+		goto cleanup_iterator;
+	}
+
+	status = dc_context_new (&autodetect.quiet);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create the probe context.");
+		goto cleanup_timer;
+	}
+	dc_context_set_loglevel (autodetect.quiet, DC_LOGLEVEL_NONE);
+
+	// Without thread support, all jobs run one after the other.
+	if (dc_mutex_new (&autodetect.mutex) == DC_STATUS_SUCCESS &&
+		dc_cond_new (&autodetect.cond) != DC_STATUS_SUCCESS) {
+		dc_mutex_free (autodetect.mutex);
+		autodetect.mutex = NULL;
+	}
+
+	// Listing the serial ports is fast, and determines the number of
+	// probe jobs.
+	if (autodetect.transports & DC_TRANSPORT_SERIAL) {
+		dc_iterator_t *serial = NULL;
+		dc_serial_device_t *port = NULL;
+
+		status = dc_serial_iterator_new (&serial, context, NULL);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (context, "Failed to enumerate the serial ports.");
+			goto cleanup;
+		}
+
+		while (dc_iterator_next (serial, &port) == DC_STATUS_SUCCESS) {
+			dc_serial_device_t **array = (dc_serial_device_t **) realloc (ports, (nports + 1) * sizeof (dc_serial_device_t *));
+			if (array == NULL) {
+				ERROR (context, "Failed to allocate memory.");
+				dc_serial_device_free (port);
+				dc_iterator_free (serial);
+				status = DC_STATUS_NOMEMORY;
+				goto cleanup;
+			}
+			ports = array;
+			ports[nports++] = port;
+		}
+
+		dc_iterator_free (serial);
+	}
+
+	jobs = (dc_autodetect_job_t *) calloc (nports + 3, sizeof (dc_autodetect_job_t));
+	if (jobs == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto cleanup;
+	}
+
+	for (size_t i = 0; i < nports; ++i) {
+		jobs[njobs].func = dc_autodetect_serial;
+		jobs[njobs].port = ports[i];
+		ports[i] = NULL;
+		njobs++;
+	}
+	if (autodetect.transports & DC_TRANSPORT_USBHID)
+		jobs[njobs++].func = dc_autodetect_usbhid;
+	if (autodetect.transports & DC_TRANSPORT_BLUETOOTH)
+		jobs[njobs++].func = dc_autodetect_bluetooth;
+	if (autodetect.transports & DC_TRANSPORT_IRDA)
+		jobs[njobs++].func = dc_autodetect_irda;
+
+	// Start all jobs at once.
+	for (size_t i = 0; i < njobs; ++i) {
+		jobs[i].autodetect = &autodetect;
+		if (autodetect.mutex) {
+			dc_mutex_lock (autodetect.mutex);
+			autodetect.pending++;
+			dc_mutex_unlock (autodetect.mutex);
+			if (dc_thread_new (&jobs[i].thread, dc_autodetect_run, &jobs[i]) == DC_STATUS_SUCCESS)
+				continue;
+			dc_mutex_lock (autodetect.mutex);
+			autodetect.pending--;
+			dc_mutex_unlock (autodetect.mutex);
+		}
+		jobs[i].func (&jobs[i]);
+	}
+
+	// Wait for the jobs to finish, or for the timeout to expire. On
+	// timeout, the running probes are interrupted.
+	if (autodetect.mutex) {
+		dc_mutex_lock (autodetect.mutex);
+		unsigned int remaining = 0;
+		while (autodetect.pending) {
+			if (autodetect.timeout == 0) {
+				dc_cond_wait (autodetect.cond, autodetect.mutex);
+				continue;
+			}
+			if ((remaining = dc_autodetect_remaining (&autodetect)) == 0)
+				break;
+			dc_cond_timedwait (autodetect.cond, autodetect.mutex, remaining);
+		}
+		autodetect.cancelled = 1;
+		for (size_t i = 0; i < njobs; ++i) {
+			if (jobs[i].iostream)
+				dc_iostream_set_cancelled (jobs[i].iostream, 1);
+		}
+		dc_mutex_unlock (autodetect.mutex);
+	}
+
+	for (size_t i = 0; i < njobs; ++i) {
+		dc_thread_join (jobs[i].thread);
+		if (jobs[i].port)
+			dc_serial_device_free (jobs[i].port);
+	}
+
+	if (autodetect.count)
+		qsort (autodetect.matches, autodetect.count, sizeof (dc_autodetect_match_t *), dc_autodetect_compare);
+
+	iterator->matches = autodetect.matches;
+	iterator->count = autodetect.count;
+	iterator->current = 0;
+	autodetect.matches = NULL;
+	autodetect.count = 0;
+
+	status = DC_STATUS_SUCCESS;
+
+cleanup:
+	for (size_t i = 0; i < nports; ++i)
+		dc_serial_device_free (ports[i]);
+	free (ports);
+	free (jobs);
+	for (size_t i = 0; i < autodetect.count; ++i)
+		dc_autodetect_match_free (autodetect.matches[i]);
+	free (autodetect.matches);
+	dc_cond_free (autodetect.cond);
+	dc_mutex_free (autodetect.mutex);
+	dc_context_free (autodetect.quiet);
+cleanup_timer:
+	dc_timer_free (autodetect.timer);
+cleanup_iterator:
+	if (status != DC_STATUS_SUCCESS) {
+		dc_iterator_deallocate ((dc_iterator_t *) iterator);
+		return status;
+	}
+
+	*out = (dc_iterator_t *) iterator;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_autodetect_iterator_next (dc_iterator_t *abstract, void *out)
+{
+	dc_autodetect_iterator_t *iterator = (dc_autodetect_iterator_t *) abstract;
+	dc_autodetect_match_t **item = (dc_autodetect_match_t **) out;
+
+	if (iterator->current >= iterator->count)
+		return DC_STATUS_DONE;
+
+	// The ownership of the match is transferred to the caller.
+	*item = iterator->matches[iterator->current];
+	iterator->matches[iterator->current++] = NULL;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_autodetect_iterator_free (dc_iterator_t *abstract)
+{
+	dc_autodetect_iterator_t *iterator = (dc_autodetect_iterator_t *) abstract;
+
+	for (size_t i = iterator->current; i < iterator->count; ++i)
+		dc_autodetect_match_free (iterator->matches[i]);
+	free (iterator->matches);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_descriptor_t *
+dc_autodetect_match_get_descriptor (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return NULL;
+
+	return match->descriptor;
+}
+
+dc_transport_t
+dc_autodetect_match_get_transport (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return DC_TRANSPORT_NONE;
+
+	return match->transport;
+}
+
+dc_autodetect_rank_t
+dc_autodetect_match_get_rank (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return DC_AUTODETECT_NAME;
+
+	return match->rank;
+}
+
+const char *
+dc_autodetect_match_get_name (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return NULL;
+
+	switch (match->transport) {
+	case DC_TRANSPORT_SERIAL:
+		return dc_serial_device_get_name ((dc_serial_device_t *) match->device);
+	case DC_TRANSPORT_BLUETOOTH:
+		return dc_bluetooth_device_get_name ((dc_bluetooth_device_t *) match->device);
+	case DC_TRANSPORT_IRDA:
+		return dc_irda_device_get_name ((dc_irda_device_t *) match->device);
+	default:
+		return NULL;
+	}
+}
+
+void *
+dc_autodetect_match_get_device (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return NULL;
+
+	return match->device;
+}
+
+void
+dc_autodetect_match_free (dc_autodetect_match_t *match)
+{
+	if (match == NULL)
+		return;
+
+	dc_autodetect_device_free (match->transport, match->device);
+	free (match);
+}
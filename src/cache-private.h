@@ -0,0 +1,60 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_CACHE_PRIVATE_H
+#define DC_CACHE_PRIVATE_H
+
+#include <libdivecomputer/cache.h>
+#include <libdivecomputer/parser.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dc_cache_record_t dc_cache_record_t;
+
+dc_status_t
+dc_cache_lookup (dc_cache_t *cache, dc_parser_t *parser, const unsigned char data[], unsigned int size, dc_cache_record_t **record);
+
+/*
+ * Parse the dive and store the result in the cache. The (optional)
+ * record with the result is returned as well, even if writing the cache
+ * file failed, such that the dive doesn't need to be parsed again.
+ */
+dc_status_t
+dc_cache_insert (dc_cache_t *cache, dc_parser_t *parser, const unsigned char data[], unsigned int size, dc_cache_record_t **record);
+
+dc_status_t
+dc_cache_record_get_datetime (dc_cache_record_t *record, dc_datetime_t *datetime);
+
+dc_status_t
+dc_cache_record_get_field (dc_cache_record_t *record, dc_field_type_t type, unsigned int flags, void *value);
+
+dc_status_t
+dc_cache_record_samples_foreach (dc_cache_record_t *record, dc_sample_callback_t callback, void *userdata);
+
+void
+dc_cache_record_free (dc_cache_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_CACHE_PRIVATE_H */
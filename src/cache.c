@@ -0,0 +1,1063 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define USE_MMAP
+#endif
+
+#include <libdivecomputer/version.h>
+
+#include "cache-private.h"
+#include "store-private.h"
+#include "parser-private.h"
+#include "context-private.h"
+#include "checksum.h"
+#include "array.h"
+#include "platform.h"
+
+#define MAGIC DC_STORE_MAGIC_CACHE
+
+// Version of the record format, which is part of the key.
+#define FORMAT 2
+
+// Depth, temperature and pressure values are stored as the difference
+// with the previous value, in units of 1/SCALE. Values that can't be
+// represented exactly that way are stored as a double instead.
+#define SCALE    1000
+#define MAXSCALE 100000.0
+
+#define MAXSTRINGS  256
+
+struct dc_cache_t {
+	dc_context_t *context;
+	char *directory;
+};
+
+struct dc_cache_record_t {
+	// Either a mapping of the cache file, or the buffer the record was
+	// recorded into.
+	void *mapping;
+	size_t length;
+	dc_buffer_t *buffer;
+	dc_status_t status;
+	dc_datetime_t datetime;
+	const unsigned char *fields;
+	unsigned int nfields;
+	const unsigned char *fields_end;
+	const unsigned char *samples;
+	const unsigned char *samples_end;
+};
+
+typedef struct dc_cache_reader_t {
+	const unsigned char *data;
+	const unsigned char *end;
+	int error;
+} dc_cache_reader_t;
+
+// The previous values of the delta encoded samples.
+typedef struct dc_cache_state_t {
+	unsigned int time;
+	int depth;
+	int temperature;
+	int pressure;
+} dc_cache_state_t;
+
+typedef struct dc_cache_writer_t {
+	dc_buffer_t *buffer;
+	int error;
+	int unsupported;
+	dc_cache_state_t state;
+} dc_cache_writer_t;
+
+/*
+ * Encoding helpers.
+ */
+
+static void
+cache_put_bytes (dc_cache_writer_t *writer, const unsigned char data[], unsigned int size)
+{
+	if (!writer->error && !dc_buffer_append (writer->buffer, data, size))
+		writer->error = 1;
+}
+
+static void
+cache_put_u32 (dc_cache_writer_t *writer, unsigned int value)
+{
+	unsigned char data[4];
+	array_uint32_le_set (data, value);
+	cache_put_bytes (writer, data, sizeof (data));
+}
+
+static void
+cache_put_varint (dc_cache_writer_t *writer, unsigned int value)
+{
+	unsigned char data[5];
+	unsigned int n = 0;
+	while (value >= 0x80) {
+		data[n++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	data[n++] = value;
+	cache_put_bytes (writer, data, n);
+}
+
+static void
+cache_put_double (dc_cache_writer_t *writer, double value)
+{
+	unsigned long long bits = 0;
+	memcpy (&bits, &value, sizeof (bits));
+	cache_put_u32 (writer, bits & 0xFFFFFFFF);
+	cache_put_u32 (writer, (bits >> 32) & 0xFFFFFFFF);
+}
+
+static void
+cache_put_real (dc_cache_writer_t *writer, double value, int *previous)
+{
+	// The lowest bit indicates whether the value is stored as a (zigzag
+	// encoded) delta, or as a double.
+	if (value > -MAXSCALE && value < MAXSCALE) {
+		double scaled = value * SCALE;
+		int q = (int) (scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+		if ((double) q / SCALE == value) {
+			int delta = q - *previous;
+			unsigned int zigzag = delta < 0 ? ((unsigned int) -(delta + 1) << 1) | 1 : (unsigned int) delta << 1;
+			cache_put_varint (writer, zigzag << 1);
+			*previous = q;
+			return;
+		}
+	}
+
+	cache_put_varint (writer, 1);
+	cache_put_double (writer, value);
+}
+
+static void
+cache_put_string (dc_cache_writer_t *writer, const char *value)
+{
+	// The length is stored with an offset of one, to be able to
+	// distinguish between an empty and a NULL string. The string is
+	// stored null terminated, to be used directly from the file.
+	if (value == NULL) {
+		cache_put_varint (writer, 0);
+	} else {
+		size_t length = strlen (value);
+		cache_put_varint (writer, length + 1);
+		cache_put_bytes (writer, (const unsigned char *) value, length + 1);
+	}
+}
+
+static const unsigned char *
+cache_get_bytes (dc_cache_reader_t *reader, unsigned int size)
+{
+	if (reader->error || (size_t) (reader->end - reader->data) < size) {
+		reader->error = 1;
+		return NULL;
+	}
+
+	const unsigned char *data = reader->data;
+	reader->data += size;
+	return data;
+}
+
+static unsigned int
+cache_get_u32 (dc_cache_reader_t *reader)
+{
+	const unsigned char *data = cache_get_bytes (reader, 4);
+	if (data == NULL)
+		return 0;
+
+	return array_uint32_le (data);
+}
+
+static unsigned int
+cache_get_varint (dc_cache_reader_t *reader)
+{
+	unsigned int value = 0;
+	for (unsigned int shift = 0; shift < 35; shift += 7) {
+		const unsigned char *data = cache_get_bytes (reader, 1);
+		if (data == NULL)
+			return 0;
+		value |= (data[0] & 0x7F) << shift;
+		if ((data[0] & 0x80) == 0)
+			return value;
+	}
+
+	reader->error = 1;
+	return 0;
+}
+
+static double
+cache_get_double (dc_cache_reader_t *reader)
+{
+	unsigned long long lo = cache_get_u32 (reader);
+	unsigned long long hi = cache_get_u32 (reader);
+	unsigned long long bits = lo | (hi << 32);
+	double value = 0.0;
+	memcpy (&value, &bits, sizeof (value));
+	return value;
+}
+
+static double
+cache_get_real (dc_cache_reader_t *reader, int *previous)
+{
+	unsigned int value = cache_get_varint (reader);
+	if (value & 1)
+		return cache_get_double (reader);
+
+	unsigned int zigzag = value >> 1;
+	int delta = (zigzag & 1) ? -(int) (zigzag >> 1) - 1 : (int) (zigzag >> 1);
+	*previous += delta;
+
+	return (double) *previous / SCALE;
+}
+
+static const char *
+cache_get_string (dc_cache_reader_t *reader)
+{
+	unsigned int length = cache_get_varint (reader);
+	if (length == 0)
+		return NULL;
+
+	const unsigned char *data = cache_get_bytes (reader, length);
+	if (data == NULL || data[length - 1] != 0) {
+		reader->error = 1;
+		return NULL;
+	}
+
+	return (const char *) data;
+}
+
+/*
+ * Cache key.
+ */
+
+static unsigned long long
+dc_cache_key (dc_parser_t *parser, const unsigned char data[], unsigned int size)
+{
+	// The library version includes the git revision for development
+	// builds, so every change to a parser results in a different key.
+	const char *version = dc_version (NULL);
+
+	// The calibration of the parser changes the output as well.
+	unsigned long long atmospheric = 0, hydrostatic = 0;
+	memcpy (&atmospheric, &parser->atmospheric, sizeof (atmospheric));
+	memcpy (&hydrostatic, &parser->hydrostatic, sizeof (hydrostatic));
+
+	unsigned char header[48];
+	unsigned long long systime = (unsigned long long) parser->systime;
+	array_uint32_le_set (header +  0, parser->vtable->type);
+	array_uint32_le_set (header +  4, parser->model);
+	array_uint32_le_set (header +  8, parser->serial);
+	array_uint32_le_set (header + 12, parser->devtime);
+	array_uint32_le_set (header + 16, systime & 0xFFFFFFFF);
+	array_uint32_le_set (header + 20, (systime >> 32) & 0xFFFFFFFF);
+	array_uint32_le_set (header + 24, size);
+	array_uint32_le_set (header + 28, FORMAT);
+	array_uint32_le_set (header + 32, atmospheric & 0xFFFFFFFF);
+	array_uint32_le_set (header + 36, (atmospheric >> 32) & 0xFFFFFFFF);
+	array_uint32_le_set (header + 40, hydrostatic & 0xFFFFFFFF);
+	array_uint32_le_set (header + 44, (hydrostatic >> 32) & 0xFFFFFFFF);
+
+	unsigned long long hash = CHECKSUM_FNV1A64_INIT;
+	hash = checksum_fnv1a64 ((const unsigned char *) version, strlen (version), hash);
+	hash = checksum_fnv1a64 (header, sizeof (header), hash);
+	hash = checksum_fnv1a64 (data, size, hash);
+
+	return hash;
+}
+
+static int
+dc_cache_filename (dc_cache_t *cache, unsigned long long key, const char *extension, char filename[], size_t size)
+{
+	int n = snprintf (filename, size, "%s/%08X%08X.%s", cache->directory,
+		(unsigned int) ((key >> 32) & 0xFFFFFFFF),
+		(unsigned int) (key & 0xFFFFFFFF),
+		extension);
+	if (n < 0 || (size_t) n >= size)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Recording.
+ */
+
+static void
+dc_cache_sample_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dc_cache_writer_t *writer = (dc_cache_writer_t *) userdata;
+
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		// Sample times are stored relative to the previous time.
+		cache_put_varint (writer, type);
+		if (value.time >= writer->state.time) {
+			cache_put_varint (writer, (value.time - writer->state.time) << 1);
+		} else {
+			cache_put_varint (writer, ((writer->state.time - value.time) << 1) | 1);
+		}
+		writer->state.time = value.time;
+		break;
+	case DC_SAMPLE_DEPTH:
+		cache_put_varint (writer, type);
+		cache_put_real (writer, value.depth, &writer->state.depth);
+		break;
+	case DC_SAMPLE_PRESSURE:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.pressure.tank);
+		cache_put_real (writer, value.pressure.value, &writer->state.pressure);
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		cache_put_varint (writer, type);
+		cache_put_real (writer, value.temperature, &writer->state.temperature);
+		break;
+	case DC_SAMPLE_EVENT:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.event.type);
+		cache_put_varint (writer, value.event.time);
+		cache_put_varint (writer, value.event.flags);
+		cache_put_varint (writer, value.event.value);
+		cache_put_string (writer, value.event.name);
+		break;
+	case DC_SAMPLE_RBT:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.rbt);
+		break;
+	case DC_SAMPLE_HEARTBEAT:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.heartbeat);
+		break;
+	case DC_SAMPLE_BEARING:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.bearing);
+		break;
+	case DC_SAMPLE_VENDOR:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.vendor.type);
+		cache_put_varint (writer, value.vendor.size);
+		cache_put_bytes (writer, (const unsigned char *) value.vendor.data, value.vendor.size);
+		break;
+	case DC_SAMPLE_SETPOINT:
+		cache_put_varint (writer, type);
+		cache_put_double (writer, value.setpoint);
+		break;
+	case DC_SAMPLE_PPO2:
+		cache_put_varint (writer, type);
+		cache_put_double (writer, value.ppo2);
+		break;
+	case DC_SAMPLE_CNS:
+		cache_put_varint (writer, type);
+		cache_put_double (writer, value.cns);
+		break;
+	case DC_SAMPLE_DECO:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.deco.type);
+		cache_put_varint (writer, value.deco.time);
+		cache_put_double (writer, value.deco.depth);
+		break;
+	case DC_SAMPLE_GASMIX:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.gasmix);
+		break;
+	case DC_SAMPLE_TTS:
+		cache_put_varint (writer, type);
+		cache_put_varint (writer, value.time);
+		break;
+	default:
+		// Unknown sample types can't be stored, so the
+		// entire dive is excluded from the cache.
+		writer->unsupported = 1;
+		break;
+	}
+}
+
+static dc_status_t
+dc_cache_record_field (dc_cache_writer_t *writer, dc_parser_t *parser, dc_field_type_t type, unsigned int flags, unsigned int *nfields)
+{
+	dc_cache_writer_t payload = {NULL, 0, 0, {0, 0, 0, 0}};
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	union {
+		unsigned int number;
+		double value;
+		dc_gasmix_t gasmix;
+		dc_salinity_t salinity;
+		dc_tank_t tank;
+		dc_divemode_t divemode;
+		dc_field_string_t string;
+	} value;
+
+	memset (&value, 0, sizeof (value));
+
+	payload.buffer = dc_buffer_new (64);
+	if (payload.buffer == NULL) {
+		writer->error = 1;
+		return DC_STATUS_NOMEMORY;
+	}
+
+	rc = parser->vtable->field (parser, type, flags, &value);
+	if (rc == DC_STATUS_SUCCESS) {
+		switch (type) {
+		case DC_FIELD_DIVETIME:
+		case DC_FIELD_GASMIX_COUNT:
+		case DC_FIELD_TANK_COUNT:
+			cache_put_u32 (&payload, value.number);
+			break;
+		case DC_FIELD_MAXDEPTH:
+		case DC_FIELD_AVGDEPTH:
+		case DC_FIELD_ATMOSPHERIC:
+		case DC_FIELD_TEMPERATURE_SURFACE:
+		case DC_FIELD_TEMPERATURE_MINIMUM:
+		case DC_FIELD_TEMPERATURE_MAXIMUM:
+			cache_put_double (&payload, value.value);
+			break;
+		case DC_FIELD_GASMIX:
+			cache_put_double (&payload, value.gasmix.helium);
+			cache_put_double (&payload, value.gasmix.oxygen);
+			cache_put_double (&payload, value.gasmix.nitrogen);
+			break;
+		case DC_FIELD_SALINITY:
+			cache_put_u32 (&payload, value.salinity.type);
+			cache_put_double (&payload, value.salinity.density);
+			break;
+		case DC_FIELD_TANK:
+			cache_put_u32 (&payload, value.tank.gasmix);
+			cache_put_u32 (&payload, value.tank.type);
+			cache_put_double (&payload, value.tank.volume);
+			cache_put_double (&payload, value.tank.workpressure);
+			cache_put_double (&payload, value.tank.beginpressure);
+			cache_put_double (&payload, value.tank.endpressure);
+			break;
+		case DC_FIELD_DIVEMODE:
+			cache_put_u32 (&payload, value.divemode);
+			break;
+		case DC_FIELD_STRING:
+			cache_put_string (&payload, value.string.desc);
+			cache_put_string (&payload, value.string.value);
+			break;
+		default:
+			break;
+		}
+	}
+
+	cache_put_u32 (writer, type);
+	cache_put_u32 (writer, flags);
+	cache_put_u32 (writer, (unsigned int) rc);
+	cache_put_u32 (writer, dc_buffer_get_size (payload.buffer));
+	cache_put_bytes (writer, dc_buffer_get_data (payload.buffer), dc_buffer_get_size (payload.buffer));
+	if (payload.error)
+		writer->error = 1;
+	(*nfields)++;
+
+	dc_buffer_free (payload.buffer);
+
+	return rc;
+}
+
+static dc_status_t
+dc_cache_record (dc_parser_t *parser, dc_buffer_t *buffer)
+{
+	dc_cache_writer_t writer = {buffer, 0, 0, {0, 0, 0, 0}};
+	dc_datetime_t datetime;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	unsigned int nfields = 0;
+
+	// Date/time.
+	memset (&datetime, 0, sizeof (datetime));
+	if (parser->vtable->datetime) {
+		rc = parser->vtable->datetime (parser, &datetime);
+	} else {
+		rc = DC_STATUS_UNSUPPORTED;
+	}
+	cache_put_u32 (&writer, (unsigned int) rc);
+	cache_put_u32 (&writer, datetime.year);
+	cache_put_u32 (&writer, datetime.month);
+	cache_put_u32 (&writer, datetime.day);
+	cache_put_u32 (&writer, datetime.hour);
+	cache_put_u32 (&writer, datetime.minute);
+	cache_put_u32 (&writer, datetime.second);
+	cache_put_u32 (&writer, datetime.timezone);
+
+	// Fields. The number of fields is patched afterwards.
+	size_t offset = dc_buffer_get_size (buffer);
+	cache_put_u32 (&writer, 0);
+	if (parser->vtable->field) {
+		static const dc_field_type_t simple[] = {
+			DC_FIELD_DIVETIME,
+			DC_FIELD_MAXDEPTH,
+			DC_FIELD_AVGDEPTH,
+			DC_FIELD_SALINITY,
+			DC_FIELD_ATMOSPHERIC,
+			DC_FIELD_TEMPERATURE_SURFACE,
+			DC_FIELD_TEMPERATURE_MINIMUM,
+			DC_FIELD_TEMPERATURE_MAXIMUM,
+			DC_FIELD_DIVEMODE,
+		};
+		for (unsigned int i = 0; i < sizeof (simple) / sizeof (simple[0]); ++i) {
+			dc_cache_record_field (&writer, parser, simple[i], 0, &nfields);
+		}
+
+		unsigned int ngasmixes = 0;
+		if (parser->vtable->field (parser, DC_FIELD_GASMIX_COUNT, 0, &ngasmixes) != DC_STATUS_SUCCESS)
+			ngasmixes = 0;
+		dc_cache_record_field (&writer, parser, DC_FIELD_GASMIX_COUNT, 0, &nfields);
+		for (unsigned int i = 0; i < ngasmixes; ++i) {
+			dc_cache_record_field (&writer, parser, DC_FIELD_GASMIX, i, &nfields);
+		}
+
+		unsigned int ntanks = 0;
+		if (parser->vtable->field (parser, DC_FIELD_TANK_COUNT, 0, &ntanks) != DC_STATUS_SUCCESS)
+			ntanks = 0;
+		dc_cache_record_field (&writer, parser, DC_FIELD_TANK_COUNT, 0, &nfields);
+		for (unsigned int i = 0; i < ntanks; ++i) {
+			dc_cache_record_field (&writer, parser, DC_FIELD_TANK, i, &nfields);
+		}
+
+		// The number of strings is unknown, so they are recorded until
+		// the first failure. That failure is recorded as well.
+		for (unsigned int i = 0; i < MAXSTRINGS; ++i) {
+			if (dc_cache_record_field (&writer, parser, DC_FIELD_STRING, i, &nfields) != DC_STATUS_SUCCESS)
+				break;
+		}
+	}
+	if (!writer.error) {
+		array_uint32_le_set (dc_buffer_get_data (buffer) + offset, nfields);
+	}
+
+	// Samples.
+	if (parser->vtable->samples_foreach) {
+		rc = parser->vtable->samples_foreach (parser, dc_cache_sample_cb, &writer);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+	}
+
+	if (writer.error)
+		return DC_STATUS_NOMEMORY;
+
+	if (writer.unsupported)
+		return DC_STATUS_UNSUPPORTED;
+
+	return DC_STATUS_SUCCESS;
+}
+
+/*
+ * Public API.
+ */
+
+dc_status_t
+dc_cache_open (dc_cache_t **out, dc_context_t *context, const char *directory)
+{
+	dc_cache_t *cache = NULL;
+
+	if (out == NULL || directory == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	cache = (dc_cache_t *) malloc (sizeof (dc_cache_t));
+	if (cache == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	cache->context = context;
+	cache->directory = (char *) malloc (strlen (directory) + 1);
+	if (cache->directory == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		free (cache);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	strcpy (cache->directory, directory);
+
+	*out = cache;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_cache_close (dc_cache_t *cache)
+{
+	if (cache == NULL)
+		return DC_STATUS_SUCCESS;
+
+	free (cache->directory);
+	free (cache);
+
+	return DC_STATUS_SUCCESS;
+}
+
+/*
+ * Private API.
+ */
+
+static void *
+dc_cache_map (const char *filename, size_t *length)
+{
+#ifdef USE_MMAP
+	int fd = open (filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat (fd, &st) != 0 || st.st_size <= 0) {
+		close (fd);
+		return NULL;
+	}
+
+	void *mapping = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (mapping == MAP_FAILED)
+		return NULL;
+
+	*length = st.st_size;
+	return mapping;
+#else
+	FILE *fp = fopen (filename, "rb");
+	if (fp == NULL)
+		return NULL;
+
+	dc_buffer_t *buffer = dc_buffer_new (0);
+	unsigned char block[1024];
+	size_t nbytes = 0;
+	while (buffer && (nbytes = fread (block, 1, sizeof (block), fp)) > 0) {
+		if (!dc_buffer_append (buffer, block, nbytes)) {
+			dc_buffer_free (buffer);
+			buffer = NULL;
+		}
+	}
+	fclose (fp);
+
+	if (buffer == NULL || dc_buffer_get_size (buffer) == 0) {
+		dc_buffer_free (buffer);
+		return NULL;
+	}
+
+	*length = dc_buffer_get_size (buffer);
+	void *mapping = malloc (*length);
+	if (mapping)
+		memcpy (mapping, dc_buffer_get_data (buffer), *length);
+	dc_buffer_free (buffer);
+
+	return mapping;
+#endif
+}
+
+static void
+dc_cache_unmap (void *mapping, size_t length)
+{
+	if (mapping == NULL)
+		return;
+
+#ifdef USE_MMAP
+	munmap (mapping, length);
+#else
+	free (mapping);
+#endif
+}
+
+/*
+ * Verify the header of a cache file, and locate the fields and the
+ * samples. The size and the CRC32 of the raw data are stored as well,
+ * to protect against hash collisions.
+ */
+static int
+dc_cache_record_load (dc_cache_record_t *record, unsigned long long key, const unsigned char data[], unsigned int size)
+{
+	const unsigned char *begin = (const unsigned char *) record->mapping;
+	dc_cache_reader_t reader = {begin, begin + record->length, 0};
+
+	unsigned int magic = cache_get_u32 (&reader);
+	unsigned int lo = cache_get_u32 (&reader);
+	unsigned int hi = cache_get_u32 (&reader);
+	unsigned int rsize = cache_get_u32 (&reader);
+	unsigned int rcrc = cache_get_u32 (&reader);
+	if (reader.error || magic != MAGIC ||
+		lo != (key & 0xFFFFFFFF) || hi != ((key >> 32) & 0xFFFFFFFF) ||
+		rsize != size || rcrc != checksum_crc32 (data, size)) {
+		return -1;
+	}
+
+	record->status = (dc_status_t) (int) cache_get_u32 (&reader);
+	record->datetime.year = cache_get_u32 (&reader);
+	record->datetime.month = cache_get_u32 (&reader);
+	record->datetime.day = cache_get_u32 (&reader);
+	record->datetime.hour = cache_get_u32 (&reader);
+	record->datetime.minute = cache_get_u32 (&reader);
+	record->datetime.second = cache_get_u32 (&reader);
+	record->datetime.timezone = cache_get_u32 (&reader);
+
+	// Skip over the fields to locate the samples.
+	record->nfields = cache_get_u32 (&reader);
+	record->fields = reader.data;
+	for (unsigned int i = 0; i < record->nfields && !reader.error; ++i) {
+		cache_get_bytes (&reader, 12);
+		cache_get_bytes (&reader, cache_get_u32 (&reader));
+	}
+	record->fields_end = reader.data;
+	record->samples = reader.data;
+	record->samples_end = reader.end;
+
+	return reader.error ? -1 : 0;
+}
+
+dc_status_t
+dc_cache_lookup (dc_cache_t *cache, dc_parser_t *parser, const unsigned char data[], unsigned int size, dc_cache_record_t **out)
+{
+	char filename[1024];
+
+	if (cache == NULL || parser == NULL || out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned long long key = dc_cache_key (parser, data, size);
+	if (dc_cache_filename (cache, key, "dcc", filename, sizeof (filename)) != 0)
+		return DC_STATUS_INVALIDARGS;
+
+	size_t length = 0;
+	void *mapping = dc_cache_map (filename, &length);
+	if (mapping == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_cache_record_t *record = (dc_cache_record_t *) malloc (sizeof (dc_cache_record_t));
+	if (record == NULL) {
+		ERROR (cache->context, "Failed to allocate memory.");
+		dc_cache_unmap (mapping, length);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	record->mapping = mapping;
+	record->length = length;
+	record->buffer = NULL;
+
+	if (dc_cache_record_load (record, key, data, size) != 0) {
+		WARNING (cache->context, "Ignoring invalid cache file '%s'.", filename);
+		dc_cache_record_free (record);
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	*out = record;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_cache_insert (dc_cache_t *cache, dc_parser_t *parser, const unsigned char data[], unsigned int size, dc_cache_record_t **out)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_cache_record_t *record = NULL;
+	char filename[1024], tmpname[1024];
+
+	if (out)
+		*out = NULL;
+
+	if (cache == NULL || parser == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned long long key = dc_cache_key (parser, data, size);
+	if (dc_cache_filename (cache, key, "dcc", filename, sizeof (filename)) != 0 ||
+		dc_cache_filename (cache, key, "tmp", tmpname, sizeof (tmpname)) != 0) {
+		ERROR (cache->context, "Cache filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	dc_buffer_t *buffer = dc_buffer_new (1024);
+	if (buffer == NULL) {
+		ERROR (cache->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	dc_cache_writer_t writer = {buffer, 0, 0, {0, 0, 0, 0}};
+	cache_put_u32 (&writer, MAGIC);
+	cache_put_u32 (&writer, key & 0xFFFFFFFF);
+	cache_put_u32 (&writer, (key >> 32) & 0xFFFFFFFF);
+	cache_put_u32 (&writer, size);
+	cache_put_u32 (&writer, checksum_crc32 (data, size));
+	if (writer.error) {
+		rc = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	rc = dc_cache_record (parser, buffer);
+	if (rc == DC_STATUS_UNSUPPORTED) {
+		DEBUG (cache->context, "Dive with unsupported sample types not cached.");
+		goto error_free;
+	} else if (rc != DC_STATUS_SUCCESS) {
+		goto error_free;
+	}
+
+	// The record is returned to the caller, such that the dive doesn't
+	// need to be parsed again after a cache miss.
+	if (out) {
+		record = (dc_cache_record_t *) malloc (sizeof (dc_cache_record_t));
+		if (record == NULL) {
+			ERROR (cache->context, "Failed to allocate memory.");
+			rc = DC_STATUS_NOMEMORY;
+			goto error_free;
+		}
+
+		record->mapping = dc_buffer_get_data (buffer);
+		record->length = dc_buffer_get_size (buffer);
+		record->buffer = NULL;
+		if (dc_cache_record_load (record, key, data, size) != 0) {
+			free (record);
+			record = NULL;
+			rc = DC_STATUS_DATAFORMAT;
+			goto error_free;
+		}
+	}
+
+	// Write to a temporary file first, and rename it afterwards. Other
+	// processes will never see a partially written cache file.
+	FILE *fp = fopen (tmpname, "wb");
+	if (fp == NULL) {
+		SYSERROR (cache->context, errno);
+		rc = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	size_t n = fwrite (dc_buffer_get_data (buffer), 1, dc_buffer_get_size (buffer), fp);
+	if (fclose (fp) != 0 || n != dc_buffer_get_size (buffer)) {
+		SYSERROR (cache->context, errno);
+		remove (tmpname);
+		rc = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	if (rename (tmpname, filename) != 0) {
+		// On Windows, rename fails if the destination exists. That is
+		// not an error here, because the existing entry is identical.
+		remove (tmpname);
+	}
+
+error_free:
+	// A record remains valid, even if the cache file could not be
+	// written. It takes over the ownership of the buffer.
+	if (record) {
+		record->buffer = buffer;
+		*out = record;
+	} else {
+		dc_buffer_free (buffer);
+	}
+	return rc;
+}
+
+dc_status_t
+dc_cache_record_get_datetime (dc_cache_record_t *record, dc_datetime_t *datetime)
+{
+	if (record->status != DC_STATUS_SUCCESS)
+		return record->status;
+
+	if (datetime)
+		*datetime = record->datetime;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_cache_record_get_field (dc_cache_record_t *record, dc_field_type_t type, unsigned int flags, void *value)
+{
+	dc_cache_reader_t reader = {record->fields, record->fields_end, 0};
+
+	for (unsigned int i = 0; i < record->nfields; ++i) {
+		unsigned int ftype = cache_get_u32 (&reader);
+		unsigned int fflags = cache_get_u32 (&reader);
+		dc_status_t status = (dc_status_t) (int) cache_get_u32 (&reader);
+		unsigned int length = cache_get_u32 (&reader);
+		const unsigned char *payload = cache_get_bytes (&reader, length);
+		if (reader.error)
+			return DC_STATUS_DATAFORMAT;
+
+		if (ftype != type || fflags != flags)
+			continue;
+
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		if (value == NULL)
+			return DC_STATUS_SUCCESS;
+
+		dc_cache_reader_t p = {payload, payload + length, 0};
+		dc_gasmix_t *gasmix = (dc_gasmix_t *) value;
+		dc_salinity_t *salinity = (dc_salinity_t *) value;
+		dc_tank_t *tank = (dc_tank_t *) value;
+		dc_field_string_t *string = (dc_field_string_t *) value;
+
+		switch (type) {
+		case DC_FIELD_DIVETIME:
+		case DC_FIELD_GASMIX_COUNT:
+		case DC_FIELD_TANK_COUNT:
+			*((unsigned int *) value) = cache_get_u32 (&p);
+			break;
+		case DC_FIELD_MAXDEPTH:
+		case DC_FIELD_AVGDEPTH:
+		case DC_FIELD_ATMOSPHERIC:
+		case DC_FIELD_TEMPERATURE_SURFACE:
+		case DC_FIELD_TEMPERATURE_MINIMUM:
+		case DC_FIELD_TEMPERATURE_MAXIMUM:
+			*((double *) value) = cache_get_double (&p);
+			break;
+		case DC_FIELD_GASMIX:
+			gasmix->helium = cache_get_double (&p);
+			gasmix->oxygen = cache_get_double (&p);
+			gasmix->nitrogen = cache_get_double (&p);
+			break;
+		case DC_FIELD_SALINITY:
+			salinity->type = (dc_water_t) cache_get_u32 (&p);
+			salinity->density = cache_get_double (&p);
+			break;
+		case DC_FIELD_TANK:
+			tank->gasmix = cache_get_u32 (&p);
+			tank->type = cache_get_u32 (&p);
+			tank->volume = cache_get_double (&p);
+			tank->workpressure = cache_get_double (&p);
+			tank->beginpressure = cache_get_double (&p);
+			tank->endpressure = cache_get_double (&p);
+			break;
+		case DC_FIELD_DIVEMODE:
+			*((dc_divemode_t *) value) = (dc_divemode_t) cache_get_u32 (&p);
+			break;
+		case DC_FIELD_STRING:
+			string->desc = cache_get_string (&p);
+			string->value = cache_get_string (&p);
+			break;
+		default:
+			return DC_STATUS_UNSUPPORTED;
+		}
+
+		if (p.error)
+			return DC_STATUS_DATAFORMAT;
+
+		return DC_STATUS_SUCCESS;
+	}
+
+	return DC_STATUS_UNSUPPORTED;
+}
+
+dc_status_t
+dc_cache_record_samples_foreach (dc_cache_record_t *record, dc_sample_callback_t callback, void *userdata)
+{
+	dc_cache_reader_t reader = {record->samples, record->samples_end, 0};
+	dc_cache_state_t state = {0, 0, 0, 0};
+
+	while (reader.data < reader.end) {
+		dc_sample_value_t sample = {0};
+		dc_sample_type_t type = (dc_sample_type_t) cache_get_varint (&reader);
+		unsigned int delta = 0;
+
+		switch (type) {
+		case DC_SAMPLE_TIME:
+			delta = cache_get_varint (&reader);
+			if (delta & 1)
+				state.time -= delta >> 1;
+			else
+				state.time += delta >> 1;
+			sample.time = state.time;
+			break;
+		case DC_SAMPLE_DEPTH:
+			sample.depth = cache_get_real (&reader, &state.depth);
+			break;
+		case DC_SAMPLE_PRESSURE:
+			sample.pressure.tank = cache_get_varint (&reader);
+			sample.pressure.value = cache_get_real (&reader, &state.pressure);
+			break;
+		case DC_SAMPLE_TEMPERATURE:
+			sample.temperature = cache_get_real (&reader, &state.temperature);
+			break;
+		case DC_SAMPLE_EVENT:
+			sample.event.type = cache_get_varint (&reader);
+			sample.event.time = cache_get_varint (&reader);
+			sample.event.flags = cache_get_varint (&reader);
+			sample.event.value = cache_get_varint (&reader);
+			sample.event.name = cache_get_string (&reader);
+			break;
+		case DC_SAMPLE_RBT:
+			sample.rbt = cache_get_varint (&reader);
+			break;
+		case DC_SAMPLE_HEARTBEAT:
+			sample.heartbeat = cache_get_varint (&reader);
+			break;
+		case DC_SAMPLE_BEARING:
+			sample.bearing = cache_get_varint (&reader);
+			break;
+		case DC_SAMPLE_VENDOR:
+			sample.vendor.type = cache_get_varint (&reader);
+			sample.vendor.size = cache_get_varint (&reader);
+			sample.vendor.data = cache_get_bytes (&reader, sample.vendor.size);
+			break;
+		case DC_SAMPLE_SETPOINT:
+			sample.setpoint = cache_get_double (&reader);
+			break;
+		case DC_SAMPLE_PPO2:
+			sample.ppo2 = cache_get_double (&reader);
+			break;
+		case DC_SAMPLE_CNS:
+			sample.cns = cache_get_double (&reader);
+			break;
+		case DC_SAMPLE_DECO:
+			sample.deco.type = cache_get_varint (&reader);
+			sample.deco.time = cache_get_varint (&reader);
+			sample.deco.depth = cache_get_double (&reader);
+			break;
+		case DC_SAMPLE_GASMIX:
+			sample.gasmix = cache_get_varint (&reader);
+			break;
+		case DC_SAMPLE_TTS:
+			sample.time = cache_get_varint (&reader);
+			break;
+		default:
+			return DC_STATUS_DATAFORMAT;
+		}
+
+		if (reader.error)
+			return DC_STATUS_DATAFORMAT;
+
+		if (callback)
+			callback (type, sample, userdata);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+void
+dc_cache_record_free (dc_cache_record_t *record)
+{
+	if (record == NULL)
+		return;
+
+	if (record->buffer)
+		dc_buffer_free (record->buffer);
+	else
+		dc_cache_unmap (record->mapping, record->length);
+	free (record);
+}
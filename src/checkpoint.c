@@ -0,0 +1,171 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "store-private.h"
+#include "context-private.h"
+#include "device-private.h"
+
+struct dc_checkpoint_t {
+	dc_device_t *device;
+	unsigned int enabled;
+	unsigned int modified;
+	unsigned int address;
+	unsigned int size;
+	dc_buffer_t *key;
+	dc_buffer_t *data;
+};
+
+dc_status_t
+dc_checkpoint_new (dc_checkpoint_t **out, dc_device_t *device, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize)
+{
+	dc_checkpoint_t *checkpoint = NULL;
+
+	if (out == NULL || device == NULL || (key == NULL && ksize != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	checkpoint = (dc_checkpoint_t *) malloc (sizeof (*checkpoint));
+	if (checkpoint == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	checkpoint->device = device;
+	checkpoint->enabled = 0;
+	checkpoint->modified = 0;
+	checkpoint->address = address;
+	checkpoint->size = size;
+	checkpoint->key = dc_buffer_new (ksize);
+	checkpoint->data = dc_buffer_new (0);
+	if (checkpoint->key == NULL || checkpoint->data == NULL ||
+		!dc_buffer_append (checkpoint->key, key, ksize)) {
+		ERROR (device->context, "Failed to allocate memory.");
+		dc_buffer_free (checkpoint->data);
+		dc_buffer_free (checkpoint->key);
+		free (checkpoint);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Load the data of the previous attempt. Failing to load the
+	// checkpoint is not fatal, because the transfer is simply
+	// started from the beginning.
+	if (device->store) {
+		dc_status_t rc = dc_store_get_checkpoint (device->store, device->vtable->type,
+			device->devinfo.serial, address, size, key, ksize, checkpoint->data);
+		if (rc == DC_STATUS_SUCCESS) {
+			checkpoint->enabled = 1;
+		} else if (rc != DC_STATUS_UNSUPPORTED) {
+			WARNING (device->context, "Failed to load the checkpoint.");
+			dc_buffer_clear (checkpoint->data);
+		}
+	}
+
+	if (dc_buffer_get_size (checkpoint->data)) {
+		INFO (device->context, "Resuming the transfer at offset %u.",
+			(unsigned int) dc_buffer_get_size (checkpoint->data));
+	}
+
+	*out = checkpoint;
+
+	return DC_STATUS_SUCCESS;
+}
+
+unsigned int
+dc_checkpoint_available (dc_checkpoint_t *checkpoint)
+{
+	if (checkpoint == NULL)
+		return 0;
+
+	return dc_buffer_get_size (checkpoint->data);
+}
+
+dc_status_t
+dc_checkpoint_read (dc_checkpoint_t *checkpoint, unsigned int offset, unsigned char data[], unsigned int size)
+{
+	if (checkpoint == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned int available = dc_buffer_get_size (checkpoint->data);
+	if (offset > available || size > available - offset)
+		return DC_STATUS_UNSUPPORTED;
+
+	memcpy (data, dc_buffer_get_data (checkpoint->data) + offset, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_checkpoint_update (dc_checkpoint_t *checkpoint, unsigned int offset, const unsigned char data[], unsigned int size)
+{
+	if (checkpoint == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (!checkpoint->enabled)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int available = dc_buffer_get_size (checkpoint->data);
+	if (offset > available)
+		return DC_STATUS_INVALIDARGS;
+
+	// Data received again is normally identical. Only data that
+	// differs replaces the remainder of the recorded data.
+	if (size <= available - offset &&
+		memcmp (dc_buffer_get_data (checkpoint->data) + offset, data, size) == 0)
+		return DC_STATUS_SUCCESS;
+
+	if (!dc_buffer_resize (checkpoint->data, offset) ||
+		!dc_buffer_append (checkpoint->data, data, size)) {
+		ERROR (checkpoint->device->context, "Failed to allocate memory.");
+		checkpoint->enabled = 0;
+		return DC_STATUS_NOMEMORY;
+	}
+
+	checkpoint->modified = 1;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_checkpoint_free (dc_checkpoint_t *checkpoint)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (checkpoint == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_device_t *device = checkpoint->device;
+	if (checkpoint->enabled && checkpoint->modified) {
+		status = dc_store_set_checkpoint (device->store, device->vtable->type,
+			device->devinfo.serial, checkpoint->address, checkpoint->size,
+			dc_buffer_get_data (checkpoint->key), dc_buffer_get_size (checkpoint->key),
+			dc_buffer_get_data (checkpoint->data), dc_buffer_get_size (checkpoint->data));
+	}
+
+	dc_buffer_free (checkpoint->data);
+	dc_buffer_free (checkpoint->key);
+	free (checkpoint);
+
+	return status;
+}
@@ -0,0 +1,116 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_CHECKPOINT_H
+#define DC_CHECKPOINT_H
+
+#include <libdivecomputer/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Opaque object representing a transfer checkpoint.
+ *
+ * A checkpoint records the verified data of a transfer, in the order it
+ * was received, such that an interrupted transfer can be continued
+ * where it stopped. A transfer is identified by the device, an address
+ * range, and a key with a snapshot of the device state (e.g. the
+ * ringbuffer pointers). The data of a previous attempt is only resumed
+ * if all of them match.
+ *
+ * The data is kept in the store attached to the device, which must be
+ * opened with #DC_STORE_CHECKPOINT. Without such a store, the checkpoint
+ * is inactive and nothing is ever resumed.
+ */
+typedef struct dc_checkpoint_t dc_checkpoint_t;
+
+/**
+ * Create a new checkpoint, and load the data of a previous attempt.
+ *
+ * @param[out]  checkpoint  A location to store the checkpoint.
+ * @param[in]   device      A valid device object.
+ * @param[in]   address     The begin address of the transfer.
+ * @param[in]   size        The size of the transfer.
+ * @param[in]   key         The snapshot of the device state.
+ * @param[in]   ksize       The size of the snapshot.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_checkpoint_new (dc_checkpoint_t **checkpoint, dc_device_t *device, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize);
+
+/**
+ * Get the number of bytes that are available without downloading.
+ *
+ * @param[in]  checkpoint  A valid checkpoint.
+ * @returns The number of bytes.
+ */
+unsigned int
+dc_checkpoint_available (dc_checkpoint_t *checkpoint);
+
+/**
+ * Get previously received data, without downloading.
+ *
+ * @param[in]  checkpoint  A valid checkpoint.
+ * @param[in]  offset      The offset in the transfer.
+ * @param[out] data        The memory buffer to copy the data into.
+ * @param[in]  size        The number of bytes to copy.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if the
+ * data is not available, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_checkpoint_read (dc_checkpoint_t *checkpoint, unsigned int offset, unsigned char data[], unsigned int size);
+
+/**
+ * Record newly received data. The data must have been verified by the
+ * caller. Unless the data is identical to the data that is already
+ * recorded, any data recorded beyond the offset is discarded. Thus the
+ * offset can't be larger than the number of available bytes.
+ *
+ * @param[in]  checkpoint  A valid checkpoint.
+ * @param[in]  offset      The offset in the transfer.
+ * @param[in]  data        The received data.
+ * @param[in]  size        The number of bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_checkpoint_update (dc_checkpoint_t *checkpoint, unsigned int offset, const unsigned char data[], unsigned int size);
+
+/**
+ * Destroy the checkpoint. Newly recorded data is saved in the store
+ * attached to the device. The store only writes it to disk when the
+ * download fails, because a successful download removes all
+ * checkpoints of the device.
+ *
+ * @param[in]  checkpoint  A valid checkpoint.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_checkpoint_free (dc_checkpoint_t *checkpoint);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_CHECKPOINT_H */
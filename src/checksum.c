@@ -157,3 +157,15 @@ checksum_crc32 (const unsigned char data[], unsigned int size)
 
 	return crc ^ 0xffffffff;
 }
+
+unsigned long long
+checksum_fnv1a64 (const unsigned char data[], unsigned int size, unsigned long long init)
+{
+	unsigned long long hash = init;
+	for (unsigned int i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
@@ -44,6 +44,11 @@ checksum_crc_ccitt_uint16 (const unsigned char data[], unsigned int size);
 unsigned int
 checksum_crc32 (const unsigned char data[], unsigned int size);
 
+#define CHECKSUM_FNV1A64_INIT 0xCBF29CE484222325ULL
+
+unsigned long long
+checksum_fnv1a64 (const unsigned char data[], unsigned int size, unsigned long long init);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -49,6 +49,8 @@ static const dc_device_vtable_t citizen_aqualand_device_vtable = {
 	NULL, /* write */
 	citizen_aqualand_device_dump, /* dump */
 	citizen_aqualand_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -29,11 +29,16 @@
 #include "array.h"
 #include "ringbuffer.h"
 #include "rbstream.h"
+#include "timer.h"
 
 #define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
 
 #define MAXRETRIES 2
 
+// Minimum delay between the end of a high-speed read and the next
+// command, in milliseconds.
+#define HIGHSPEED_DELAY 550
+
 #define COCHRAN_MODEL_COMMANDER_TM 0
 #define COCHRAN_MODEL_COMMANDER_PRE21000 1
 #define COCHRAN_MODEL_COMMANDER_AIR_NITROX 2
@@ -95,6 +100,9 @@ typedef struct cochran_commander_device_t {
 	dc_device_t base;
 	dc_iostream_t *iostream;
 	const cochran_device_layout_t *layout;
+	dc_timer_t *timer;
+	unsigned int highspeed;
+	dc_usecs_t highspeed_end;
 	unsigned char id[67];
 	unsigned char fingerprint[6];
 } cochran_commander_device_t;
@@ -103,6 +111,7 @@ static dc_status_t cochran_commander_device_set_fingerprint (dc_device_t *device
 static dc_status_t cochran_commander_device_read (dc_device_t *device, unsigned int address, unsigned char data[], unsigned int size);
 static dc_status_t cochran_commander_device_dump (dc_device_t *device, dc_buffer_t *data);
 static dc_status_t cochran_commander_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+static dc_status_t cochran_commander_device_close (dc_device_t *device);
 
 static const dc_device_vtable_t cochran_commander_device_vtable = {
 	sizeof (cochran_commander_device_t),
@@ -112,8 +121,10 @@ static const dc_device_vtable_t cochran_commander_device_vtable = {
 	NULL, /* write */
 	cochran_commander_device_dump, /* dump */
 	cochran_commander_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
-	NULL /* close */
+	cochran_commander_device_close /* close */
 };
 
 // Cochran Commander TM, pre-dates pre-21000 s/n
@@ -344,11 +355,14 @@ cochran_commander_serial_setup (cochran_commander_device_t *device)
 static dc_status_t
 cochran_commander_packet (cochran_commander_device_t *device, dc_event_progress_t *progress,
 	const unsigned char command[], unsigned int csize,
-	unsigned char answer[], unsigned int asize, int high_speed)
+	unsigned char answer[], unsigned int asize, unsigned int *actual, int high_speed)
 {
 	dc_device_t *abstract = (dc_device_t *) device;
 	dc_status_t status = DC_STATUS_SUCCESS;
 
+	if (actual)
+		*actual = 0;
+
 	if (device_is_cancelled (abstract))
 		return DC_STATUS_CANCELLED;
 
@@ -393,6 +407,8 @@ cochran_commander_packet (cochran_commander_device_t *device, dc_event_progress_
 		}
 
 		nbytes += len;
+		if (actual)
+			*actual = nbytes;
 
 		if (progress) {
 			progress->current += len;
@@ -411,7 +427,7 @@ cochran_commander_read_id (cochran_commander_device_t *device, unsigned char id[
 
 	unsigned char command[6] = {0x05, 0x9D, 0xFF, 0x00, 0x43, 0x00};
 
-	rc = cochran_commander_packet(device, NULL, command, sizeof(command), id, size, 0);
+	rc = cochran_commander_packet(device, NULL, command, sizeof(command), id, size, NULL, 0);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
@@ -420,7 +436,7 @@ cochran_commander_read_id (cochran_commander_device_t *device, unsigned char id[
 		command[1] = 0xBD;
 		command[2] = 0x7F;
 
-		rc = cochran_commander_packet(device, NULL, command, sizeof(command), id, size, 0);
+		rc = cochran_commander_packet(device, NULL, command, sizeof(command), id, size, NULL, 0);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
 	}
@@ -446,7 +462,7 @@ cochran_commander_read_config (cochran_commander_device_t *device, dc_event_prog
 		if (device->layout->model == COCHRAN_MODEL_COMMANDER_TM)
 			command_size = 1;
 
-		rc = cochran_commander_packet(device, progress, command, command_size, data + i * 512, 512, 0);
+		rc = cochran_commander_packet(device, progress, command, command_size, data + i * 512, 512, NULL, 0);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
 
@@ -461,7 +477,7 @@ cochran_commander_read_config (cochran_commander_device_t *device, dc_event_prog
 
 
 static dc_status_t
-cochran_commander_read (cochran_commander_device_t *device, dc_event_progress_t *progress, unsigned int address, unsigned char data[], unsigned int size)
+cochran_commander_read (cochran_commander_device_t *device, dc_event_progress_t *progress, unsigned int address, unsigned char data[], unsigned int size, unsigned int *actual)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 
@@ -521,7 +537,18 @@ cochran_commander_read (cochran_commander_device_t *device, dc_event_progress_t
 		return DC_STATUS_UNSUPPORTED;
 	}
 
-	dc_iostream_sleep(device->iostream, 550);
+	// The device needs some time before it accepts a high-speed read
+	// command. After a previous high-speed read, the time spent since
+	// the end of that read (e.g. processing the data) counts towards
+	// that delay.
+	unsigned int elapsed = 0;
+	if (device->highspeed) {
+		dc_usecs_t now = 0;
+		if (dc_timer_now (device->timer, &now) == DC_STATUS_SUCCESS)
+			elapsed = (now - device->highspeed_end) / 1000;
+	}
+	if (elapsed < HIGHSPEED_DELAY)
+		dc_iostream_sleep(device->iostream, HIGHSPEED_DELAY - elapsed);
 
 	// set back to 9600 baud
 	rc = cochran_commander_serial_setup(device);
@@ -529,7 +556,9 @@ cochran_commander_read (cochran_commander_device_t *device, dc_event_progress_t
 		return rc;
 
 	// Read data at high speed
-	rc = cochran_commander_packet (device, progress, command, command_size, data, size, 1);
+	device->highspeed = 1;
+	rc = cochran_commander_packet (device, progress, command, command_size, data, size, actual, 1);
+	dc_timer_now (device->timer, &device->highspeed_end);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
@@ -546,9 +575,19 @@ cochran_commander_read_retry (cochran_commander_device_t *device, dc_event_progr
 		saved = progress->current;
 	}
 
+	// The serial protocol has no checksum, and the length of the answer
+	// is the only thing that can be verified. The data received before
+	// an incomplete answer is valid, so only the remaining part of the
+	// range is requested again.
+	unsigned int nbytes = 0;
 	unsigned int nretries = 0;
 	dc_status_t rc = DC_STATUS_SUCCESS;
-	while ((rc = cochran_commander_read (device, progress, address, data, size)) != DC_STATUS_SUCCESS) {
+	while (1) {
+		unsigned int len = 0;
+		rc = cochran_commander_read (device, progress, address + nbytes, data + nbytes, size - nbytes, &len);
+		if (rc == DC_STATUS_SUCCESS)
+			break;
+
 		// Automatically discard a corrupted packet,
 		// and request a new one.
 		if (rc != DC_STATUS_PROTOCOL && rc != DC_STATUS_TIMEOUT)
@@ -558,9 +597,11 @@ cochran_commander_read_retry (cochran_commander_device_t *device, dc_event_progr
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		nbytes += len;
+
 		// Restore the state of the progress events.
 		if (progress) {
-			progress->current = saved;
+			progress->current = saved + nbytes;
 		}
 	}
 
@@ -731,18 +772,28 @@ cochran_commander_device_open (dc_device_t **out, dc_context_t *context, dc_iost
 
 	// Set the default values.
 	device->iostream = iostream;
+	device->layout = NULL;
+	device->highspeed = 0;
+	device->highspeed_end = 0;
 	cochran_commander_device_set_fingerprint((dc_device_t *) device, NULL, 0);
 
-	status = cochran_commander_serial_setup(device);
+	// Create a high resolution timer.
+	status = dc_timer_new (&device->timer);
 	if (status != DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to create a high resolution timer.");
 		goto error_free;
 	}
 
+	status = cochran_commander_serial_setup(device);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_timer_free;
+	}
+
 	// Read ID from the device
 	status = cochran_commander_read_id (device, device->id, sizeof(device->id));
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (context, "Device not responding.");
-		goto error_free;
+		goto error_timer_free;
 	}
 
 	unsigned int model = cochran_commander_get_model(device);
@@ -768,13 +819,15 @@ cochran_commander_device_open (dc_device_t **out, dc_context_t *context, dc_iost
 	default:
 		ERROR (context, "Unknown model");
 		status = DC_STATUS_UNSUPPORTED;
-		goto error_free;
+		goto error_timer_free;
 	}
 
 	*out = (dc_device_t *) device;
 
 	return DC_STATUS_SUCCESS;
 
+error_timer_free:
+	dc_timer_free (device->timer);
 error_free:
 	dc_device_deallocate ((dc_device_t *) device);
 	return status;
@@ -797,6 +850,17 @@ cochran_commander_device_set_fingerprint (dc_device_t *abstract, const unsigned
 }
 
 
+static dc_status_t
+cochran_commander_device_close (dc_device_t *abstract)
+{
+	cochran_commander_device_t *device = (cochran_commander_device_t *) abstract;
+
+	dc_timer_free (device->timer);
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 static dc_status_t
 cochran_commander_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size)
 {
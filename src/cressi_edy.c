@@ -74,6 +74,8 @@ static const dc_device_vtable_t cressi_edy_device_vtable = {
 	NULL, /* write */
 	cressi_edy_device_dump, /* dump */
 	cressi_edy_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	cressi_edy_device_close /* close */
 };
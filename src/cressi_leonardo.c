@@ -65,6 +65,8 @@ static const dc_device_vtable_t cressi_leonardo_device_vtable = {
 	NULL, /* write */
 	cressi_leonardo_device_dump, /* dump */
 	cressi_leonardo_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
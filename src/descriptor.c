@@ -22,9 +22,11 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "descriptor-private.h"
 #include "iterator-private.h"
+#include "thread.h"
 #include "platform.h"
 
 #define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
@@ -47,6 +49,19 @@ struct dc_descriptor_t {
 	dc_filter_t filter;
 };
 
+typedef struct dc_usb_product_t {
+	dc_usb_desc_t desc;
+	dc_filter_t filter;
+	const char *product;
+} dc_usb_product_t;
+
+typedef struct dc_bluetooth_product_t {
+	const char *name;
+	unsigned int prefix;
+	dc_filter_t filter;
+	const char *product;
+} dc_bluetooth_product_t;
+
 typedef struct dc_descriptor_iterator_t {
 	dc_iterator_t base;
 	size_t current;
@@ -333,6 +348,36 @@ static const dc_descriptor_t g_descriptors[] = {
 	{"Garmin", "Descent Mk1", DC_FAMILY_GARMIN, 2859, DC_TRANSPORT_USBSTORAGE, dc_filter_garmin},
 };
 
+/*
+ * The USB and bluetooth identifiers accepted by the filters. Each entry also
+ * names the product it identifies, which is resolved to the first descriptor
+ * with the same filter and product name when the lookup index is built.
+ */
+
+static const dc_usb_product_t g_usb_products[] = {
+	{{0x2e6c, 0x3201}, dc_filter_uwatec, "G2"},
+	{{0x2e6c, 0x3211}, dc_filter_uwatec, "G2 Console"},
+	{{0xc251, 0x2006}, dc_filter_uwatec, "Aladin Square"},
+	{{0x1493, 0x0030}, dc_filter_suunto, "EON Steel"},
+	{{0x1493, 0x0033}, dc_filter_suunto, "EON Core"},
+	{{0x091e, 0x2b2b}, dc_filter_garmin, "Descent Mk1"},
+};
+
+/*
+ * The bluetooth names of the OSTC and Frog contain the serial number and
+ * are matched by prefix only. They identify the family, but not the exact
+ * model, which is reported by the device itself once connected.
+ */
+static const dc_bluetooth_product_t g_bluetooth_products[] = {
+	{"OSTC",         1, dc_filter_hw,         "OSTC 2"},
+	{"FROG",         1, dc_filter_hw,         "Frog"},
+	{"Predator",     0, dc_filter_shearwater, "Predator"},
+	{"Petrel",       0, dc_filter_shearwater, "Petrel"},
+	{"Nerd",         0, dc_filter_shearwater, "Nerd"},
+	{"Perdix",       0, dc_filter_shearwater, "Perdix"},
+	{"DiveComputer", 0, dc_filter_tecdiving,  "DiveComputer.eu"},
+};
+
 static int
 dc_filter_internal_name (const char *name, const char *values[], size_t count)
 {
@@ -349,14 +394,41 @@ dc_filter_internal_name (const char *name, const char *values[], size_t count)
 }
 
 static int
-dc_filter_internal_usb (const dc_usb_desc_t *desc, const dc_usb_desc_t values[], size_t count)
+dc_filter_internal_usb (const dc_usb_desc_t *desc, dc_filter_t filter)
 {
 	if (desc == NULL)
 		return 0;
 
-	for (size_t i = 0; i < count; ++i) {
-		if (desc->vid == values[i].vid &&
-			desc->pid == values[i].pid) {
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_usb_products); ++i) {
+		if (g_usb_products[i].filter == filter &&
+			desc->vid == g_usb_products[i].desc.vid &&
+			desc->pid == g_usb_products[i].desc.pid) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+dc_filter_internal_bluetooth_match (const char *name, const dc_bluetooth_product_t *product)
+{
+	if (product->prefix) {
+		return strncasecmp (name, product->name, strlen (product->name)) == 0;
+	} else {
+		return strcasecmp (name, product->name) == 0;
+	}
+}
+
+static int
+dc_filter_internal_bluetooth (const char *name, dc_filter_t filter)
+{
+	if (name == NULL)
+		return 0;
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_bluetooth_products); ++i) {
+		if (g_bluetooth_products[i].filter == filter &&
+			dc_filter_internal_bluetooth_match (name, &g_bluetooth_products[i])) {
 			return 1;
 		}
 	}
@@ -396,16 +468,11 @@ static int dc_filter_uwatec (dc_transport_t transport, const void *userdata)
 		"UWATEC Galileo",
 		"UWATEC Galileo Sol",
 	};
-	static const dc_usb_desc_t usbhid[] = {
-		{0x2e6c, 0x3201}, // G2
-		{0x2e6c, 0x3211}, // G2 Console
-		{0xc251, 0x2006}, // Aladin Square
-	};
 
 	if (transport == DC_TRANSPORT_IRDA) {
 		return dc_filter_internal_name ((const char *) userdata, irda, C_ARRAY_SIZE(irda));
 	} else if (transport == DC_TRANSPORT_USBHID) {
-		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, usbhid, C_ARRAY_SIZE(usbhid));
+		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, dc_filter_uwatec);
 	}
 
 	return 1;
@@ -413,13 +480,8 @@ static int dc_filter_uwatec (dc_transport_t transport, const void *userdata)
 
 static int dc_filter_suunto (dc_transport_t transport, const void *userdata)
 {
-	static const dc_usb_desc_t usbhid[] = {
-		{0x1493, 0x0030}, // Eon Steel
-		{0x1493, 0x0033}, // Eon Core
-	};
-
 	if (transport == DC_TRANSPORT_USBHID) {
-		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, usbhid, C_ARRAY_SIZE(usbhid));
+		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, dc_filter_suunto);
 	}
 
 	return 1;
@@ -428,8 +490,7 @@ static int dc_filter_suunto (dc_transport_t transport, const void *userdata)
 static int dc_filter_hw (dc_transport_t transport, const void *userdata)
 {
 	if (transport == DC_TRANSPORT_BLUETOOTH) {
-		return strncasecmp ((const char *) userdata, "OSTC", 4) == 0 ||
-			strncasecmp ((const char *) userdata, "FROG", 4) == 0;
+		return dc_filter_internal_bluetooth ((const char *) userdata, dc_filter_hw);
 	} else if (transport == DC_TRANSPORT_SERIAL) {
 		return dc_filter_internal_rfcomm ((const char *) userdata);
 	}
@@ -439,15 +500,8 @@ static int dc_filter_hw (dc_transport_t transport, const void *userdata)
 
 static int dc_filter_shearwater (dc_transport_t transport, const void *userdata)
 {
-	static const char *bluetooth[] = {
-		"Predator",
-		"Petrel",
-		"Nerd",
-		"Perdix",
-	};
-
 	if (transport == DC_TRANSPORT_BLUETOOTH) {
-		return dc_filter_internal_name ((const char *) userdata, bluetooth, C_ARRAY_SIZE(bluetooth));
+		return dc_filter_internal_bluetooth ((const char *) userdata, dc_filter_shearwater);
 	} else if (transport == DC_TRANSPORT_SERIAL) {
 		return dc_filter_internal_rfcomm ((const char *) userdata);
 	}
@@ -457,12 +511,8 @@ static int dc_filter_shearwater (dc_transport_t transport, const void *userdata)
 
 static int dc_filter_tecdiving (dc_transport_t transport, const void *userdata)
 {
-	static const char *bluetooth[] = {
-		"DiveComputer",
-	};
-
 	if (transport == DC_TRANSPORT_BLUETOOTH) {
-		return dc_filter_internal_name ((const char *) userdata, bluetooth, C_ARRAY_SIZE(bluetooth));
+		return dc_filter_internal_bluetooth ((const char *) userdata, dc_filter_tecdiving);
 	} else if (transport == DC_TRANSPORT_SERIAL) {
 		return dc_filter_internal_rfcomm ((const char *) userdata);
 	}
@@ -472,12 +522,8 @@ static int dc_filter_tecdiving (dc_transport_t transport, const void *userdata)
 
 static int dc_filter_garmin (dc_transport_t transport, const void *userdata)
 {
-	static const dc_usb_desc_t usbhid[] = {
-		{0x091e, 0x2b2b}, // Garmin Descent Mk1
-	};
-
 	if (transport == DC_TRANSPORT_USBSTORAGE) {
-		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, usbhid, C_ARRAY_SIZE(usbhid));
+		return dc_filter_internal_usb ((const dc_usb_desc_t *) userdata, dc_filter_garmin);
 	}
 
 	return 1;
@@ -582,3 +628,359 @@ dc_descriptor_get_filter (dc_descriptor_t *descriptor)
 
 	return descriptor->filter;
 }
+
+/*
+ * The lookup index consists of a few hash tables, which are built from the
+ * static tables above on first use. Each key maps to the first matching entry
+ * in table order, which is also the result of a linear search. The tables use
+ * open addressing with a load factor below one half, so the number of probes
+ * does not depend on the number of descriptors.
+ */
+
+#define NAMESIZE 64
+
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME  16777619U
+
+typedef struct dc_index_slot_t {
+	unsigned int hash;
+	unsigned int value;
+} dc_index_slot_t;
+
+typedef int (*dc_index_match_t) (size_t index, const void *key);
+
+static dc_index_slot_t g_index_model[2 * C_ARRAY_SIZE(g_descriptors)];
+static dc_index_slot_t g_index_family[2 * C_ARRAY_SIZE(g_descriptors)];
+static dc_index_slot_t g_index_name[4 * C_ARRAY_SIZE(g_descriptors)];
+static dc_index_slot_t g_index_usb[2 * C_ARRAY_SIZE(g_usb_products)];
+static dc_index_slot_t g_index_bluetooth[2 * C_ARRAY_SIZE(g_bluetooth_products)];
+static size_t g_usb_descriptors[C_ARRAY_SIZE(g_usb_products)];
+static size_t g_bluetooth_descriptors[C_ARRAY_SIZE(g_bluetooth_products)];
+static size_t g_bluetooth_prefixes[C_ARRAY_SIZE(g_bluetooth_products)];
+static size_t g_bluetooth_nprefixes = 0;
+static int g_index_initialized = 0;
+
+static unsigned int
+dc_index_hash_uint (unsigned int hash, unsigned int value)
+{
+	for (unsigned int i = 0; i < 4; ++i) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static unsigned int
+dc_index_hash_string (const char *string, size_t length)
+{
+	unsigned int hash = FNV_OFFSET;
+
+	for (size_t i = 0; i < length; ++i) {
+		hash ^= (unsigned char) tolower ((unsigned char) string[i]);
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static size_t
+dc_index_find (const dc_index_slot_t table[], size_t size, unsigned int hash, dc_index_match_t match, const void *key)
+{
+	size_t i = hash % size;
+	while (table[i].value) {
+		if (table[i].hash == hash && match (table[i].value - 1, key))
+			return table[i].value;
+		i = (i + 1) % size;
+	}
+
+	return 0;
+}
+
+static void
+dc_index_insert (dc_index_slot_t table[], size_t size, unsigned int hash, dc_index_match_t match, const void *key, size_t index)
+{
+	size_t i = hash % size;
+	while (table[i].value) {
+		// Keep the first entry for duplicate keys.
+		if (table[i].hash == hash && match (table[i].value - 1, key))
+			return;
+		i = (i + 1) % size;
+	}
+
+	table[i].hash = hash;
+	table[i].value = index + 1;
+}
+
+/*
+ * Normalize a name for comparison: lowercase, with leading and trailing
+ * whitespace removed and all other whitespace collapsed into a single space.
+ * Returns the length of the normalized name, or zero if the name is empty or
+ * does not fit into the buffer.
+ */
+static size_t
+dc_descriptor_normalize (char buffer[], size_t size, const char *vendor, const char *product)
+{
+	const char *strings[] = {vendor, product};
+	size_t n = 0;
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(strings); ++i) {
+		const char *p = strings[i];
+		if (p == NULL)
+			continue;
+
+		int space = 1;
+		while (*p) {
+			unsigned char c = (unsigned char) *p++;
+			if (isspace (c)) {
+				space = 1;
+				continue;
+			}
+
+			if (n + 2 >= size)
+				return 0;
+
+			if (space && n)
+				buffer[n++] = ' ';
+			buffer[n++] = tolower (c);
+			space = 0;
+		}
+	}
+
+	buffer[n] = 0;
+
+	return n;
+}
+
+static int
+dc_index_match_model (size_t index, const void *key)
+{
+	const dc_descriptor_t *descriptor = (const dc_descriptor_t *) key;
+
+	return g_descriptors[index].type == descriptor->type &&
+		g_descriptors[index].model == descriptor->model;
+}
+
+static int
+dc_index_match_family (size_t index, const void *key)
+{
+	const dc_descriptor_t *descriptor = (const dc_descriptor_t *) key;
+
+	return g_descriptors[index].type == descriptor->type;
+}
+
+static int
+dc_index_match_name (size_t index, const void *key)
+{
+	char name[NAMESIZE];
+
+	if (dc_descriptor_normalize (name, sizeof (name), g_descriptors[index].vendor, g_descriptors[index].product) &&
+		strcmp (name, (const char *) key) == 0)
+		return 1;
+
+	if (dc_descriptor_normalize (name, sizeof (name), NULL, g_descriptors[index].product) &&
+		strcmp (name, (const char *) key) == 0)
+		return 1;
+
+	return 0;
+}
+
+static int
+dc_index_match_usb (size_t index, const void *key)
+{
+	const dc_usb_desc_t *desc = (const dc_usb_desc_t *) key;
+
+	return g_usb_products[index].desc.vid == desc->vid &&
+		g_usb_products[index].desc.pid == desc->pid;
+}
+
+static int
+dc_index_match_bluetooth (size_t index, const void *key)
+{
+	return dc_filter_internal_bluetooth_match ((const char *) key, &g_bluetooth_products[index]);
+}
+
+static size_t
+dc_descriptor_resolve (dc_filter_t filter, const char *product)
+{
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_descriptors); ++i) {
+		if (g_descriptors[i].filter == filter &&
+			strcasecmp (g_descriptors[i].product, product) == 0)
+			return i + 1;
+	}
+
+	return 0;
+}
+
+static void
+dc_descriptor_index_build (void)
+{
+	char name[NAMESIZE];
+	size_t length = 0;
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_descriptors); ++i) {
+		const dc_descriptor_t *descriptor = &g_descriptors[i];
+
+		dc_index_insert (g_index_model, C_ARRAY_SIZE(g_index_model),
+			dc_index_hash_uint (dc_index_hash_uint (FNV_OFFSET, descriptor->type), descriptor->model),
+			dc_index_match_model, descriptor, i);
+		dc_index_insert (g_index_family, C_ARRAY_SIZE(g_index_family),
+			dc_index_hash_uint (FNV_OFFSET, descriptor->type),
+			dc_index_match_family, descriptor, i);
+
+		length = dc_descriptor_normalize (name, sizeof (name), descriptor->vendor, descriptor->product);
+		if (length) {
+			dc_index_insert (g_index_name, C_ARRAY_SIZE(g_index_name),
+				dc_index_hash_string (name, length),
+				dc_index_match_name, name, i);
+		}
+
+		length = dc_descriptor_normalize (name, sizeof (name), NULL, descriptor->product);
+		if (length) {
+			dc_index_insert (g_index_name, C_ARRAY_SIZE(g_index_name),
+				dc_index_hash_string (name, length),
+				dc_index_match_name, name, i);
+		}
+	}
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_usb_products); ++i) {
+		const dc_usb_product_t *product = &g_usb_products[i];
+
+		g_usb_descriptors[i] = dc_descriptor_resolve (product->filter, product->product);
+		if (g_usb_descriptors[i] == 0)
+			continue;
+
+		dc_index_insert (g_index_usb, C_ARRAY_SIZE(g_index_usb),
+			dc_index_hash_uint (dc_index_hash_uint (FNV_OFFSET, product->desc.vid), product->desc.pid),
+			dc_index_match_usb, &product->desc, i);
+	}
+
+	for (size_t i = 0; i < C_ARRAY_SIZE(g_bluetooth_products); ++i) {
+		const dc_bluetooth_product_t *product = &g_bluetooth_products[i];
+
+		g_bluetooth_descriptors[i] = dc_descriptor_resolve (product->filter, product->product);
+		if (g_bluetooth_descriptors[i] == 0)
+			continue;
+
+		length = strlen (product->name);
+		dc_index_insert (g_index_bluetooth, C_ARRAY_SIZE(g_index_bluetooth),
+			dc_index_hash_string (product->name, length),
+			dc_index_match_bluetooth, product->name, i);
+
+		// Keep track of the distinct prefix lengths.
+		if (product->prefix) {
+			size_t j = 0;
+			while (j < g_bluetooth_nprefixes && g_bluetooth_prefixes[j] != length)
+				j++;
+			if (j == g_bluetooth_nprefixes)
+				g_bluetooth_prefixes[g_bluetooth_nprefixes++] = length;
+		}
+	}
+}
+
+static dc_status_t
+dc_descriptor_lookup_result (dc_descriptor_t **out, size_t index)
+{
+	if (index == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	// See dc_descriptor_iterator_next for the const cast.
+	*out = (dc_descriptor_t *) &g_descriptors[index - 1];
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_descriptor_lookup_model (dc_descriptor_t **out, dc_family_t family, unsigned int model)
+{
+	dc_descriptor_t key = {NULL, NULL, family, model, 0, NULL};
+	size_t index = 0;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_once (&g_index_initialized, dc_descriptor_index_build);
+
+	index = dc_index_find (g_index_model, C_ARRAY_SIZE(g_index_model),
+		dc_index_hash_uint (dc_index_hash_uint (FNV_OFFSET, family), model),
+		dc_index_match_model, &key);
+	if (index == 0) {
+		// Fall back to the first descriptor of the family.
+		index = dc_index_find (g_index_family, C_ARRAY_SIZE(g_index_family),
+			dc_index_hash_uint (FNV_OFFSET, family),
+			dc_index_match_family, &key);
+	}
+
+	return dc_descriptor_lookup_result (out, index);
+}
+
+dc_status_t
+dc_descriptor_lookup_name (dc_descriptor_t **out, const char *name)
+{
+	char buffer[NAMESIZE];
+	size_t length = 0;
+
+	if (out == NULL || name == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_once (&g_index_initialized, dc_descriptor_index_build);
+
+	length = dc_descriptor_normalize (buffer, sizeof (buffer), NULL, name);
+	if (length == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	return dc_descriptor_lookup_result (out,
+		dc_index_find (g_index_name, C_ARRAY_SIZE(g_index_name),
+			dc_index_hash_string (buffer, length),
+			dc_index_match_name, buffer));
+}
+
+dc_status_t
+dc_descriptor_lookup_usb (dc_descriptor_t **out, unsigned int vid, unsigned int pid)
+{
+	dc_usb_desc_t desc = {vid, pid};
+	size_t index = 0;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_once (&g_index_initialized, dc_descriptor_index_build);
+
+	index = dc_index_find (g_index_usb, C_ARRAY_SIZE(g_index_usb),
+		dc_index_hash_uint (dc_index_hash_uint (FNV_OFFSET, vid), pid),
+		dc_index_match_usb, &desc);
+	if (index == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	return dc_descriptor_lookup_result (out, g_usb_descriptors[index - 1]);
+}
+
+dc_status_t
+dc_descriptor_lookup_bluetooth (dc_descriptor_t **out, const char *name)
+{
+	size_t length = 0, index = 0;
+
+	if (out == NULL || name == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_once (&g_index_initialized, dc_descriptor_index_build);
+
+	length = strlen (name);
+
+	// Try an exact match first, and then each of the prefix lengths.
+	index = dc_index_find (g_index_bluetooth, C_ARRAY_SIZE(g_index_bluetooth),
+		dc_index_hash_string (name, length),
+		dc_index_match_bluetooth, name);
+	for (size_t i = 0; index == 0 && i < g_bluetooth_nprefixes; ++i) {
+		if (g_bluetooth_prefixes[i] > length)
+			continue;
+
+		index = dc_index_find (g_index_bluetooth, C_ARRAY_SIZE(g_index_bluetooth),
+			dc_index_hash_string (name, g_bluetooth_prefixes[i]),
+			dc_index_match_bluetooth, name);
+	}
+	if (index == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	return dc_descriptor_lookup_result (out, g_bluetooth_descriptors[index - 1]);
+}
@@ -28,6 +28,7 @@
 #include <libdivecomputer/device.h>
 
 #include "common-private.h"
+#include "timer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,9 +49,20 @@ struct dc_device_t {
 	unsigned int event_mask;
 	dc_event_callback_t event_callback;
 	void *event_userdata;
+	// Progress event rate limit.
+	unsigned int progress_interval;
+	unsigned int progress_delta;
+	dc_timer_t *progress_timer;
+	dc_usecs_t progress_time;
+	dc_event_progress_t progress_last;
+	dc_event_progress_t progress_pending;
+	unsigned int progress_state;
 	// Cancellation support.
 	dc_cancel_callback_t cancel_callback;
 	void *cancel_userdata;
+	dc_iostream_t *iostream;
+	// Download state store.
+	dc_store_t *store;
 	// Cached events for the parsers.
 	dc_event_devinfo_t devinfo;
 	dc_event_clock_t clock;
@@ -71,6 +83,10 @@ struct dc_device_vtable_t {
 
 	dc_status_t (*foreach) (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+	dc_status_t (*headers) (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+	dc_status_t (*read_dive) (dc_device_t *device, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
+
 	dc_status_t (*timesync) (dc_device_t *device, const dc_datetime_t *datetime);
 
 	dc_status_t (*close) (dc_device_t *device);
@@ -85,6 +101,14 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable);
 void
 dc_device_deallocate (dc_device_t *device);
 
+/*
+ * Close the device without resuming a cancelled I/O stream. The close
+ * function of the backend still runs and releases its resources, but
+ * the commands of its shutdown handshake fail immediately.
+ */
+dc_status_t
+dc_device_abort (dc_device_t *device);
+
 void
 device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data);
 
@@ -57,9 +57,18 @@
 #include "cochran_commander.h"
 #include "tecdiving_divecomputereu.h"
 #include "garmin.h"
+#include "thread.h"
 
 #include "device-private.h"
+#include "store-private.h"
 #include "context-private.h"
+#include "iostream-private.h"
+
+// Progress event rate limit state.
+#define PROGRESS_DELIVERED 0x01
+#define PROGRESS_PENDING   0x02
+
+static void device_event_flush (dc_device_t *device);
 
 dc_device_t *
 dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
@@ -84,8 +93,17 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 	device->event_callback = NULL;
 	device->event_userdata = NULL;
 
+	device->progress_interval = 0;
+	device->progress_delta = 0;
+	device->progress_timer = NULL;
+	device->progress_time = 0;
+	device->progress_state = 0;
+
 	device->cancel_callback = NULL;
 	device->cancel_userdata = NULL;
+	device->iostream = NULL;
+
+	device->store = NULL;
 
 	memset (&device->devinfo, 0, sizeof (device->devinfo));
 	memset (&device->clock, 0, sizeof (device->clock));
@@ -96,6 +114,10 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 void
 dc_device_deallocate (dc_device_t *device)
 {
+	if (device == NULL)
+		return;
+
+	dc_timer_free (device->progress_timer);
 	free (device);
 }
 
@@ -215,6 +237,12 @@ dc_device_open (dc_device_t **out, dc_context_t *context, dc_descriptor_t *descr
 		return DC_STATUS_INVALIDARGS;
 	}
 
+	// Keep a reference to the I/O stream, to be able to interrupt
+	// blocking I/O operations.
+	if (device) {
+		device->iostream = iostream;
+	}
+
 	*out = device;
 
 	return rc;
@@ -254,6 +282,19 @@ dc_device_set_cancel (dc_device_t *device, dc_cancel_callback_t callback, void *
 }
 
 
+dc_status_t
+dc_device_cancel (dc_device_t *device)
+{
+	if (device == NULL || device->iostream == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Cancel the I/O stream. A blocking I/O operation is interrupted
+	// immediately, and all further operations fail, until the device
+	// is closed.
+	return dc_iostream_set_cancelled (device->iostream, 1);
+}
+
+
 dc_status_t
 dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callback_t callback, void *userdata)
 {
@@ -268,6 +309,40 @@ dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callbac
 }
 
 
+dc_status_t
+dc_device_set_progress (dc_device_t *device, unsigned int interval, unsigned int delta)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (interval && device->progress_timer == NULL) {
+		dc_status_t status = dc_timer_new (&device->progress_timer);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (device->context, "Failed to create a high resolution timer.");
+			return status;
+		}
+	}
+
+	device->progress_interval = interval;
+	device->progress_delta = delta;
+	device->progress_state = 0;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_device_set_store (dc_device_t *device, dc_store_t *store)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	device->store = store;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 dc_status_t
 dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size)
 {
@@ -321,7 +396,18 @@ dc_device_dump (dc_device_t *device, dc_buffer_t *buffer)
 
 	dc_buffer_clear (buffer);
 
-	return device->vtable->dump (device, buffer);
+	dc_status_t status = device->vtable->dump (device, buffer);
+	device_event_flush (device);
+
+	// Remove the transfer checkpoints after a successful dump, or
+	// write them to disk to resume after a failure.
+	if (device->store) {
+		if (status == DC_STATUS_SUCCESS)
+			dc_store_clear_checkpoints (device->store, device->vtable->type, device->devinfo.serial);
+		dc_store_sync (device->store);
+	}
+
+	return status;
 }
 
 
@@ -339,6 +425,9 @@ device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size,
 	progress.maximum = size;
 	device_event_emit (device, DC_EVENT_PROGRESS, &progress);
 
+	// A memory dump is not resumed from a checkpoint. The layout of the
+	// memory is only known to the backend, so there is no generic way to
+	// detect that the device logged a new dive in the meantime.
 	unsigned int nbytes = 0;
 	while (nbytes < size) {
 		// Calculate the packet size.
@@ -362,16 +451,329 @@ device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size,
 }
 
 
+typedef struct device_store_data_t {
+	dc_device_t *device;
+	dc_dive_callback_t callback;
+	void *userdata;
+	dc_buffer_t *fingerprint;
+	unsigned int ndives;
+} device_store_data_t;
+
+static int
+device_store_cb (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	device_store_data_t *storedata = (device_store_data_t *) userdata;
+	dc_device_t *device = storedata->device;
+	dc_family_t family = device->vtable->type;
+	unsigned int serial = device->devinfo.serial;
+
+	// Stop at the first dive that has been downloaded before. This
+	// provides incremental downloads, even for drivers without
+	// fingerprint support.
+	if (dc_store_has_dive (device->store, family, serial, data, size))
+		return 0;
+
+	// Keep a copy of the most recent fingerprint. Because dives are
+	// guaranteed to be downloaded in reverse order, the most recent
+	// dive is always the first dive.
+	if (storedata->ndives++ == 0 && fingerprint && fsize) {
+		dc_buffer_append (storedata->fingerprint, fingerprint, fsize);
+	}
+
+	dc_store_add_dive (device->store, family, serial, data, size);
+
+	if (storedata->callback == NULL)
+		return 1;
+
+	return storedata->callback (data, size, fingerprint, fsize, storedata->userdata);
+}
+
+
+#define PIPELINE_DEPTH 4
+
+typedef struct device_pipeline_t {
+	dc_device_t *device;
+	dc_dive_callback_t callback;
+	void *userdata;
+	dc_mutex_t *mutex;
+	dc_cond_t *notempty;
+	dc_cond_t *notfull;
+	// Bounded queue with the downloaded dives.
+	dc_buffer_t *data[PIPELINE_DEPTH];
+	dc_buffer_t *fingerprint[PIPELINE_DEPTH];
+	unsigned int head, count;
+	unsigned int done, stop;
+	dc_status_t status;
+} device_pipeline_t;
+
+static int
+device_pipeline_push (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	device_pipeline_t *pipeline = (device_pipeline_t *) userdata;
+
+	// Wait for a free slot. This limits the amount of memory when the
+	// dives are downloaded faster than they can be processed.
+	dc_mutex_lock (pipeline->mutex);
+	while (pipeline->count == PIPELINE_DEPTH && !pipeline->stop)
+		dc_cond_wait (pipeline->notfull, pipeline->mutex);
+	unsigned int stop = pipeline->stop;
+	unsigned int slot = (pipeline->head + pipeline->count) % PIPELINE_DEPTH;
+	dc_mutex_unlock (pipeline->mutex);
+
+	if (stop)
+		return 0;
+
+	// The free slot is not accessed by the worker thread, so the data
+	// can be copied without holding the lock.
+	dc_buffer_clear (pipeline->data[slot]);
+	dc_buffer_clear (pipeline->fingerprint[slot]);
+	if (!dc_buffer_append (pipeline->data[slot], data, size) ||
+		!dc_buffer_append (pipeline->fingerprint[slot], fingerprint, fsize)) {
+		ERROR (pipeline->device->context, "Failed to allocate memory.");
+		pipeline->status = DC_STATUS_NOMEMORY;
+		return 0;
+	}
+
+	dc_mutex_lock (pipeline->mutex);
+	pipeline->count++;
+	dc_cond_signal (pipeline->notempty);
+	dc_mutex_unlock (pipeline->mutex);
+
+	return 1;
+}
+
+static void
+device_pipeline_worker (void *userdata)
+{
+	device_pipeline_t *pipeline = (device_pipeline_t *) userdata;
+
+	dc_mutex_lock (pipeline->mutex);
+	while (1) {
+		while (pipeline->count == 0 && !pipeline->done)
+			dc_cond_wait (pipeline->notempty, pipeline->mutex);
+		if (pipeline->count == 0)
+			break;
+
+		unsigned int stop = pipeline->stop;
+		unsigned int slot = pipeline->head;
+		dc_mutex_unlock (pipeline->mutex);
+
+		// Once the application has stopped the download, the remaining
+		// dives are discarded.
+		int proceed = !stop;
+		if (proceed && pipeline->callback) {
+			proceed = pipeline->callback (
+				dc_buffer_get_data (pipeline->data[slot]),
+				dc_buffer_get_size (pipeline->data[slot]),
+				dc_buffer_get_data (pipeline->fingerprint[slot]),
+				dc_buffer_get_size (pipeline->fingerprint[slot]),
+				pipeline->userdata);
+		}
+
+		dc_mutex_lock (pipeline->mutex);
+		if (!proceed)
+			pipeline->stop = 1;
+		pipeline->head = (pipeline->head + 1) % PIPELINE_DEPTH;
+		pipeline->count--;
+		dc_cond_signal (pipeline->notfull);
+	}
+	dc_mutex_unlock (pipeline->mutex);
+}
+
+static dc_status_t
+device_pipeline_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_thread_t *thread = NULL;
+	device_pipeline_t pipeline;
+	unsigned int i = 0;
+
+	memset (&pipeline, 0, sizeof (pipeline));
+	pipeline.device = device;
+	pipeline.callback = callback;
+	pipeline.userdata = userdata;
+	pipeline.status = DC_STATUS_SUCCESS;
+
+	status = dc_mutex_new (&pipeline.mutex);
+	if (status == DC_STATUS_UNSUPPORTED) {
+		// Fall back to a synchronous download.
+		return device->vtable->foreach (device, callback, userdata);
+	} else if (status != DC_STATUS_SUCCESS) {
+		goto error_exit;
+	}
+
+	status = dc_cond_new (&pipeline.notempty);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_exit;
+
+	status = dc_cond_new (&pipeline.notfull);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_exit;
+
+	for (i = 0; i < PIPELINE_DEPTH; ++i) {
+		pipeline.data[i] = dc_buffer_new (0);
+		pipeline.fingerprint[i] = dc_buffer_new (0);
+		if (pipeline.data[i] == NULL || pipeline.fingerprint[i] == NULL) {
+			ERROR (device->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_exit;
+		}
+	}
+
+	status = dc_thread_new (&thread, device_pipeline_worker, &pipeline);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (device->context, "Failed to create the worker thread.");
+		goto error_exit;
+	}
+
+	status = device->vtable->foreach (device, device_pipeline_push, &pipeline);
+
+	// Let the worker thread process the remaining dives.
+	dc_mutex_lock (pipeline.mutex);
+	pipeline.done = 1;
+	dc_cond_signal (pipeline.notempty);
+	dc_mutex_unlock (pipeline.mutex);
+
+	dc_thread_join (thread);
+
+	if (status == DC_STATUS_SUCCESS)
+		status = pipeline.status;
+
+error_exit:
+	for (i = 0; i < PIPELINE_DEPTH; ++i) {
+		dc_buffer_free (pipeline.fingerprint[i]);
+		dc_buffer_free (pipeline.data[i]);
+	}
+	dc_cond_free (pipeline.notfull);
+	dc_cond_free (pipeline.notempty);
+	dc_mutex_free (pipeline.mutex);
+	return status;
+}
+
+
+static dc_status_t
+device_foreach (dc_device_t *device, unsigned int pipelined, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (device->vtable->foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (device->store == NULL) {
+		if (pipelined)
+			return device_pipeline_foreach (device, callback, userdata);
+		return device->vtable->foreach (device, callback, userdata);
+	}
+
+	device_store_data_t storedata;
+	storedata.device = device;
+	storedata.callback = callback;
+	storedata.userdata = userdata;
+	storedata.fingerprint = dc_buffer_new (0);
+	storedata.ndives = 0;
+	if (storedata.fingerprint == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// In pipelined mode, the store is updated from the worker thread,
+	// so it only records the dives that were passed to the application.
+	if (pipelined)
+		status = device_pipeline_foreach (device, device_store_cb, &storedata);
+	else
+		status = device->vtable->foreach (device, device_store_cb, &storedata);
+
+	// Update the download state, but only after a successful download.
+	// Otherwise the next download could miss some dives.
+	if (status == DC_STATUS_SUCCESS) {
+		dc_family_t family = device->vtable->type;
+		unsigned int serial = device->devinfo.serial;
+
+		// The transfer checkpoints are no longer needed.
+		dc_store_clear_checkpoints (device->store, family, serial);
+
+		if (dc_buffer_get_size (storedata.fingerprint)) {
+			dc_store_set_fingerprint (device->store, family, serial,
+				dc_buffer_get_data (storedata.fingerprint),
+				dc_buffer_get_size (storedata.fingerprint));
+		}
+
+		if (device->clock.systime) {
+			dc_store_set_clock (device->store, family, serial,
+				device->clock.devtime, device->clock.systime);
+		}
+
+		status = dc_store_sync (device->store);
+	} else {
+		// Write the transfer checkpoints to disk right away, such that
+		// the next attempt can resume the download.
+		dc_store_sync (device->store);
+	}
+
+	dc_buffer_free (storedata.fingerprint);
+
+	return status;
+}
+
+
 dc_status_t
 dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = device_foreach (device, 0, callback, userdata);
+	device_event_flush (device);
+	return status;
+}
+
+
+dc_status_t
+dc_device_foreach_pipelined (dc_device_t *device, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = device_foreach (device, 1, callback, userdata);
+	device_event_flush (device);
+	return status;
+}
+
+
+dc_status_t
+dc_device_foreach_headers (dc_device_t *device, dc_dive_callback_t callback, void *userdata)
 {
 	if (device == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
-	if (device->vtable->foreach == NULL)
+	if (device->vtable->headers == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
-	return device->vtable->foreach (device, callback, userdata);
+	// The download state is not updated, because the dives themselves
+	// are not downloaded yet.
+	dc_status_t status = device->vtable->headers (device, callback, userdata);
+	device_event_flush (device);
+	return status;
+}
+
+
+dc_status_t
+dc_device_read_dive (dc_device_t *device, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (device->vtable->read_dive == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (fingerprint == NULL || size == 0 || buffer == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_buffer_clear (buffer);
+
+	// The dive data is returned in exactly the same format as with the
+	// dc_device_foreach() function. An unknown fingerprint is reported
+	// as an invalid argument.
+	dc_status_t status = device->vtable->read_dive (device, fingerprint, size, buffer);
+	device_event_flush (device);
+	return status;
 }
 
 
@@ -388,18 +790,27 @@ dc_device_timesync (dc_device_t *device, const dc_datetime_t *datetime)
 }
 
 
-dc_status_t
-dc_device_close (dc_device_t *device)
+static dc_status_t
+device_close (dc_device_t *device, int resume)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 
 	if (device == NULL)
 		return DC_STATUS_SUCCESS;
 
+	// Deliver the last progress event of a backend specific operation,
+	// such as a firmware update.
+	device_event_flush (device);
+
 	// Disable the cancellation callback.
 	device->cancel_callback = NULL;
 	device->cancel_userdata = NULL;
 
+	// Resume the I/O stream, to be able to shut down the device cleanly.
+	if (resume && device->iostream) {
+		dc_iostream_set_cancelled (device->iostream, 0);
+	}
+
 	if (device->vtable->close) {
 		status = device->vtable->close (device);
 	}
@@ -409,6 +820,93 @@ dc_device_close (dc_device_t *device)
 	return status;
 }
 
+dc_status_t
+dc_device_close (dc_device_t *device)
+{
+	return device_close (device, 1);
+}
+
+dc_status_t
+dc_device_abort (dc_device_t *device)
+{
+	return device_close (device, 0);
+}
+
+
+static void
+device_store_load (dc_device_t *device)
+{
+	if (device->store == NULL || device->vtable->set_fingerprint == NULL)
+		return;
+
+	// Load the fingerprint from the store. If there is no fingerprint
+	// present in the store, an empty buffer is returned, and the
+	// registered fingerprint will be cleared.
+	dc_buffer_t *fingerprint = dc_buffer_new (0);
+	if (fingerprint == NULL)
+		return;
+
+	if (dc_store_get_fingerprint (device->store, device->vtable->type,
+		device->devinfo.serial, fingerprint) == DC_STATUS_SUCCESS) {
+		device->vtable->set_fingerprint (device,
+			dc_buffer_get_data (fingerprint),
+			dc_buffer_get_size (fingerprint));
+	}
+
+	dc_buffer_free (fingerprint);
+}
+
+
+static int
+device_progress_due (dc_device_t *device, const dc_event_progress_t *progress)
+{
+	const dc_event_progress_t *last = &device->progress_last;
+	dc_usecs_t now = 0;
+
+	if (device->progress_interval == 0 && device->progress_delta == 0)
+		return 1;
+
+	if (device->progress_timer)
+		dc_timer_now (device->progress_timer, &now);
+
+	// The first and the final event are always passed on, and so is a
+	// restart of the progress, for example when the next dive starts.
+	int due = !(device->progress_state & PROGRESS_DELIVERED) ||
+		progress->current < last->current ||
+		progress->current == progress->maximum;
+	if (!due) {
+		due = (device->progress_interval == 0 ||
+			now - device->progress_time >= (dc_usecs_t) device->progress_interval * 1000) &&
+			(device->progress_delta == 0 ||
+			(unsigned long long) (progress->current - last->current) * 1000 >=
+			(unsigned long long) device->progress_delta * progress->maximum);
+	}
+
+	if (due) {
+		device->progress_last = *progress;
+		device->progress_time = now;
+		device->progress_state = PROGRESS_DELIVERED;
+	} else {
+		// Keep the latest state, to pass it on if no other event follows.
+		device->progress_pending = *progress;
+		device->progress_state |= PROGRESS_PENDING;
+	}
+
+	return due;
+}
+
+static void
+device_event_flush (dc_device_t *device)
+{
+	if (device == NULL || (device->progress_state & PROGRESS_PENDING) == 0)
+		return;
+
+	device->progress_last = device->progress_pending;
+	device->progress_state &= ~PROGRESS_PENDING;
+
+	if (device->event_callback && (device->event_mask & DC_EVENT_PROGRESS))
+		device->event_callback (device, DC_EVENT_PROGRESS, &device->progress_last, device->event_userdata);
+}
 
 void
 device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
@@ -442,6 +940,7 @@ device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
 	switch (event) {
 	case DC_EVENT_DEVINFO:
 		device->devinfo = *(const dc_event_devinfo_t *) data;
+		device_store_load (device);
 		break;
 	case DC_EVENT_CLOCK:
 		device->clock = *(const dc_event_clock_t *) data;
@@ -458,6 +957,14 @@ device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
 	if ((event & device->event_mask) == 0)
 		return;
 
+	if (event == DC_EVENT_PROGRESS) {
+		if (!device_progress_due (device, progress))
+			return;
+	} else {
+		// Keep the events in order.
+		device_event_flush (device);
+	}
+
 	device->event_callback (device, event, data, device->event_userdata);
 }
 
@@ -468,6 +975,9 @@ device_is_cancelled (dc_device_t *device)
 	if (device == NULL)
 		return 0;
 
+	if (dc_iostream_is_cancelled (device->iostream))
+		return 1;
+
 	if (device->cancel_callback == NULL)
 		return 0;
 
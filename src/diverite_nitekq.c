@@ -68,6 +68,8 @@ static const dc_device_vtable_t diverite_nitekq_device_vtable = {
 	NULL, /* write */
 	diverite_nitekq_device_dump, /* dump */
 	diverite_nitekq_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	diverite_nitekq_device_close /* close */
 };
@@ -75,6 +75,7 @@ typedef struct divesystem_idive_device_t {
 
 static dc_status_t divesystem_idive_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size);
 static dc_status_t divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t divesystem_idive_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
 
 static const dc_device_vtable_t divesystem_idive_device_vtable = {
 	sizeof(divesystem_idive_device_t),
@@ -84,6 +85,8 @@ static const dc_device_vtable_t divesystem_idive_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	divesystem_idive_device_foreach, /* foreach */
+	NULL, /* headers */
+	divesystem_idive_device_read_dive, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -366,10 +369,10 @@ divesystem_idive_transfer (divesystem_idive_device_t *device, const unsigned cha
 }
 
 static dc_status_t
-divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+divesystem_idive_device_range (divesystem_idive_device_t *device, const divesystem_idive_commands_t **result, unsigned int *first, unsigned int *last)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
-	divesystem_idive_device_t *device = (divesystem_idive_device_t *) abstract;
+	dc_device_t *abstract = (dc_device_t *) device;
 	unsigned char packet[MAXPACKET - 2];
 	unsigned int errcode = 0;
 
@@ -378,10 +381,6 @@ divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callb
 		commands = &ix3m;
 	}
 
-	// Enable progress notifications.
-	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
-	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
 	unsigned char cmd_id[] = {commands->id.cmd, 0xED};
 	rc = divesystem_idive_transfer (device, cmd_id, sizeof(cmd_id), packet, commands->id.size, &errcode);
 	if (rc != DC_STATUS_SUCCESS)
@@ -408,24 +407,103 @@ divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callb
 		}
 	}
 
+	*result = commands;
+
 	unsigned char cmd_range[] = {commands->range.cmd, 0x8D};
 	rc = divesystem_idive_transfer (device, cmd_range, sizeof(cmd_range), packet, commands->range.size, &errcode);
 	if (rc != DC_STATUS_SUCCESS) {
 		if (errcode == ERR_UNAVAILABLE) {
-			return DC_STATUS_SUCCESS; // No dives found.
+			// No dives found.
+			*first = 1;
+			*last = 0;
+			return DC_STATUS_SUCCESS;
 		} else {
 			return rc;
 		}
 	}
 
 	// Get the range of the available dive numbers.
-	unsigned int first = array_uint16_le (packet + 0);
-	unsigned int last  = array_uint16_le (packet + 2);
-	if (first > last) {
+	*first = array_uint16_le (packet + 0);
+	*last  = array_uint16_le (packet + 2);
+	if (*first > *last) {
 		ERROR(abstract->context, "Invalid dive numbers.");
 		return DC_STATUS_DATAFORMAT;
 	}
 
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+divesystem_idive_device_samples (divesystem_idive_device_t *device, const divesystem_idive_commands_t *commands, dc_event_progress_t *progress, unsigned int step, const unsigned char header[], dc_buffer_t *buffer)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_device_t *abstract = (dc_device_t *) device;
+	unsigned char packet[MAXPACKET - 2];
+	unsigned int errcode = 0;
+
+	unsigned int nsamples = array_uint16_le (header + 1);
+
+	// Update and emit a progress event.
+	progress->current = step * NSTEPS + STEP(1, nsamples + 1);
+	device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
+
+	dc_buffer_clear(buffer);
+	dc_buffer_reserve(buffer, commands->header.size + commands->sample.size * nsamples);
+
+	if (!dc_buffer_append(buffer, header, commands->header.size)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	for (unsigned int j = 0; j < nsamples; j += commands->nsamples) {
+		unsigned int idx = j + 1;
+		unsigned char cmd_sample[] = {commands->sample.cmd,
+			(idx     ) & 0xFF,
+			(idx >> 8) & 0xFF};
+		rc = divesystem_idive_transfer (device, cmd_sample, sizeof(cmd_sample), packet, commands->sample.size * commands->nsamples, &errcode);
+		if (rc != DC_STATUS_SUCCESS) {
+			return rc;
+		}
+
+		// If the number of samples is not an exact multiple of the
+		// number of samples per packet, then the last packet
+		// appears to contain garbage data. Ignore those samples.
+		unsigned int n = commands->nsamples;
+		if (j + n > nsamples) {
+			n = nsamples - j;
+		}
+
+		// Update and emit a progress event.
+		progress->current = step * NSTEPS + STEP(j + n + 1, nsamples + 1);
+		device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
+
+		if (!dc_buffer_append(buffer, packet, commands->sample.size * n)) {
+			ERROR (abstract->context, "Insufficient buffer space available.");
+			return DC_STATUS_NOMEMORY;
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	divesystem_idive_device_t *device = (divesystem_idive_device_t *) abstract;
+	const divesystem_idive_commands_t *commands = NULL;
+	unsigned char packet[MAXPACKET - 2];
+	unsigned int errcode = 0;
+	unsigned int first = 0, last = 0;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	rc = divesystem_idive_device_range (device, &commands, &first, &last);
+	if (rc != DC_STATUS_SUCCESS || first > last)
+		return rc;
+
 	// Calculate the number of dives.
 	unsigned int ndives = last - first + 1;
 
@@ -457,51 +535,12 @@ divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callb
 		if (memcmp(packet + 7, device->fingerprint, sizeof(device->fingerprint)) == 0)
 			break;
 
-		unsigned int nsamples = array_uint16_le (packet + 1);
-
-		// Update and emit a progress event.
-		progress.current = i * NSTEPS + STEP(1, nsamples + 1);
-		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
-		dc_buffer_clear(buffer);
-		dc_buffer_reserve(buffer, commands->header.size + commands->sample.size * nsamples);
-
-		if (!dc_buffer_append(buffer, packet, commands->header.size)) {
-			ERROR (abstract->context, "Insufficient buffer space available.");
+		rc = divesystem_idive_device_samples (device, commands, &progress, i, packet, buffer);
+		if (rc != DC_STATUS_SUCCESS) {
 			dc_buffer_free(buffer);
 			return rc;
 		}
 
-		for (unsigned int j = 0; j < nsamples; j += commands->nsamples) {
-			unsigned int idx = j + 1;
-			unsigned char cmd_sample[] = {commands->sample.cmd,
-				(idx     ) & 0xFF,
-				(idx >> 8) & 0xFF};
-			rc = divesystem_idive_transfer (device, cmd_sample, sizeof(cmd_sample), packet, commands->sample.size * commands->nsamples, &errcode);
-			if (rc != DC_STATUS_SUCCESS) {
-				dc_buffer_free(buffer);
-				return rc;
-			}
-
-			// If the number of samples is not an exact multiple of the
-			// number of samples per packet, then the last packet
-			// appears to contain garbage data. Ignore those samples.
-			unsigned int n = commands->nsamples;
-			if (j + n > nsamples) {
-				n = nsamples - j;
-			}
-
-			// Update and emit a progress event.
-			progress.current = i * NSTEPS + STEP(j + n + 1, nsamples + 1);
-			device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
-			if (!dc_buffer_append(buffer, packet, commands->sample.size * n)) {
-				ERROR (abstract->context, "Insufficient buffer space available.");
-				dc_buffer_free(buffer);
-				return rc;
-			}
-		}
-
 		unsigned char *data = dc_buffer_get_data(buffer);
 		unsigned int   size = dc_buffer_get_size(buffer);
 		if (callback && !callback (data, size, data + 7, sizeof(device->fingerprint), userdata)) {
@@ -514,3 +553,57 @@ divesystem_idive_device_foreach (dc_device_t *abstract, dc_dive_callback_t callb
 
 	return DC_STATUS_SUCCESS;
 }
+
+static dc_status_t
+divesystem_idive_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	divesystem_idive_device_t *device = (divesystem_idive_device_t *) abstract;
+	const divesystem_idive_commands_t *commands = NULL;
+	unsigned char packet[MAXPACKET - 2];
+	unsigned int errcode = 0;
+	unsigned int first = 0, last = 0;
+
+	if (size != sizeof(device->fingerprint))
+		return DC_STATUS_INVALIDARGS;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	rc = divesystem_idive_device_range (device, &commands, &first, &last);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Only the header of each dive is needed to locate the requested
+	// dive. Start with the most recent dive, which is the most likely
+	// one to be requested.
+	unsigned int ndives = first > last ? 0 : last - first + 1;
+	for (unsigned int i = 0; i < ndives; ++i) {
+		unsigned int number = last - i;
+		unsigned char cmd_header[] = {commands->header.cmd,
+			(number     ) & 0xFF,
+			(number >> 8) & 0xFF};
+		rc = divesystem_idive_transfer (device, cmd_header, sizeof(cmd_header), packet, commands->header.size, &errcode);
+		if (rc != DC_STATUS_SUCCESS) {
+			if (errcode == ERR_UNREADABLE) {
+				WARNING(abstract->context, "Skipped unreadable dive!");
+				continue;
+			} else {
+				return rc;
+			}
+		}
+
+		if (memcmp(packet + 7, fingerprint, size) != 0)
+			continue;
+
+		// Update and emit a progress event.
+		progress.maximum = NSTEPS;
+		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+		return divesystem_idive_device_samples (device, commands, &progress, 0, packet, buffer);
+	}
+
+	ERROR (abstract->context, "No dive with the requested fingerprint.");
+	return DC_STATUS_INVALIDARGS;
+}
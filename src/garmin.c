@@ -43,6 +43,7 @@ typedef struct garmin_device_t {
 
 static dc_status_t garmin_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size);
 static dc_status_t garmin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t garmin_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
 static dc_status_t garmin_device_close (dc_device_t *abstract);
 
 static const dc_device_vtable_t garmin_device_vtable = {
@@ -53,6 +54,8 @@ static const dc_device_vtable_t garmin_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	garmin_device_foreach, /* foreach */
+	NULL, /* headers */
+	garmin_device_read_dive, /* read_dive */
 	NULL, /* timesync */
 	garmin_device_close, /* close */
 };
@@ -189,42 +192,59 @@ read_file(char *pathname, int pathlen, const char *name, dc_buffer_t *file)
 	return rc;
 }
 
+/*
+ * Get the sorted list of FIT files in the activity directory. The
+ * pathname buffer (of PATH_MAX bytes) receives the directory name.
+ */
 static dc_status_t
-garmin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+get_activity_list(garmin_device_t *device, char *pathname, size_t *pathlen, struct file_list *files)
 {
-	dc_status_t status = DC_STATUS_SUCCESS;
-	garmin_device_t *device = (garmin_device_t *) abstract;
-	dc_parser_t *parser;
-	char pathname[PATH_MAX];
-	size_t pathlen;
-	struct file_list files = { 0, 0, NULL };
-	dc_buffer_t *file;
+	dc_status_t rc;
+	size_t len;
 	DIR *dir;
-	int rc;
 
 	// Read the directory name from the iostream
-	rc = dc_iostream_read(device->iostream, &pathname, sizeof(pathname), &pathlen);
+	rc = dc_iostream_read(device->iostream, pathname, PATH_MAX, &len);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
 	// The actual dives are under the "Garmin/Activity/" directory
 	// as FIT files, with names like "2018-08-20-10-23-30.fit".
 	// Make sure our buffer is big enough.
-	if (pathlen + strlen("/Garmin/Activity/") + FIT_NAME_SIZE + 2 > PATH_MAX)
+	if (len + strlen("/Garmin/Activity/") + FIT_NAME_SIZE + 2 > PATH_MAX)
 		return DC_STATUS_IO;
 
-	if (pathlen && pathname[pathlen-1] != '/')
-		pathname[pathlen++] = '/';
-	strcpy(pathname + pathlen, "Garmin/Activity");
-	pathlen += strlen("Garmin/Activity");
+	if (len && pathname[len-1] != '/')
+		pathname[len++] = '/';
+	strcpy(pathname + len, "Garmin/Activity");
+	len += strlen("Garmin/Activity");
 
 	dir = opendir(pathname);
 	if (!dir)
 		return DC_STATUS_IO;
 
-	// Get the list of FIT files
-	rc = get_file_list(dir, &files);
+	rc = get_file_list(dir, files);
 	closedir(dir);
+
+	*pathlen = len;
+
+	return rc;
+}
+
+static dc_status_t
+garmin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	garmin_device_t *device = (garmin_device_t *) abstract;
+	dc_parser_t *parser;
+	char pathname[PATH_MAX];
+	size_t pathlen;
+	struct file_list files = { 0, 0, NULL };
+	dc_buffer_t *file;
+	int rc;
+
+	// Get the list of FIT files
+	rc = get_activity_list(device, pathname, &pathlen, &files);
 	if (rc != DC_STATUS_SUCCESS || !files.nr) {
 		free(files.array);
 		return rc;
@@ -307,3 +327,69 @@ garmin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void
 	dc_parser_destroy(parser);
 	return status;
 }
+
+static dc_status_t
+garmin_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	garmin_device_t *device = (garmin_device_t *) abstract;
+	dc_parser_t *parser;
+	char pathname[PATH_MAX];
+	size_t pathlen;
+	struct file_list files = { 0, 0, NULL };
+	const char *name = NULL;
+	int rc;
+
+	if (size != sizeof (device->fingerprint))
+		return DC_STATUS_INVALIDARGS;
+
+	// Get the list of FIT files
+	rc = get_activity_list(device, pathname, &pathlen, &files);
+	if (rc != DC_STATUS_SUCCESS) {
+		free(files.array);
+		return rc;
+	}
+
+	// The fingerprint is the name of the FIT file.
+	for (int i = 0; i < files.nr; i++) {
+		if (memcmp(files.array[i].name, fingerprint, size) == 0) {
+			name = files.array[i].name;
+			break;
+		}
+	}
+
+	if (name == NULL) {
+		ERROR (abstract->context, "No dive with the requested fingerprint.");
+		free(files.array);
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Put the name at the head, followed by the file contents.
+	dc_buffer_append(buffer, name, FIT_NAME_SIZE);
+
+	status = read_file(pathname, pathlen, name, buffer);
+	free(files.array);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	status = garmin_parser_create(&parser, abstract->context);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to create parser for dive verification.");
+		return status;
+	}
+
+	// Emit the devinfo event.
+	dc_event_devinfo_t devinfo;
+	const unsigned char *data = dc_buffer_get_data(buffer);
+	unsigned int length = dc_buffer_get_size(buffer);
+	short is_dive = garmin_parser_is_dive(parser, data, length, &devinfo);
+	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
+	dc_parser_destroy(parser);
+
+	if (!is_dive) {
+		ERROR (abstract->context, "The file %s isn't a dive.", name);
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
@@ -31,16 +31,17 @@
 
 #define C_ARRAY_SIZE(a) (sizeof(a) / sizeof(*(a)))
 
-#define MAXFIELDS 128
-
 struct msg_desc;
 
 // Local types
+//
+// The field definitions are not copied, but point directly
+// into the definition record of the dive data.
 struct type_desc {
 	const char *msg_name;
 	const struct msg_desc *msg_desc;
 	unsigned char nrfields;
-	unsigned char fields[MAXFIELDS][3];
+	const unsigned char *fields;
 };
 
 // Positions are signed 32-bit values, turning
@@ -272,32 +273,32 @@ garmin_parser_create (dc_parser_t **out, dc_context_t *context)
 	return DC_STATUS_SUCCESS;
 }
 
-static void add_string(garmin_parser_t *garmin, const char *desc, const char *value)
+static void add_string_value(garmin_parser_t *garmin, const char *desc, const char *value)
 {
 	int i;
 
+	if (!value)
+		return;
+
 	garmin->cache.initialized |= 1 << DC_FIELD_STRING;
 	for (i = 0; i < MAXSTRINGS; i++) {
 		dc_field_string_t *str = garmin->cache.strings+i;
 		if (str->desc)
 			continue;
 		str->desc = desc;
-		str->value = strdup(value);
+		str->value = value;
 		break;
 	}
 }
 
 static void add_string_fmt(garmin_parser_t *garmin, const char *desc, const char *fmt, ...)
 {
-	char buffer[256];
 	va_list ap;
 
+	// The string is formatted directly into the parser string arena.
 	va_start(ap, fmt);
-	buffer[sizeof(buffer)-1] = 0;
-	(void) vsnprintf(buffer, sizeof(buffer)-1, fmt, ap);
+	add_string_value(garmin, desc, dc_parser_vprintf(&garmin->base, fmt, ap));
 	va_end(ap);
-
-	add_string(garmin, desc, buffer);
 }
 
 #define DECLARE_FIT_TYPE(name, ctype, inval) \
@@ -803,7 +804,7 @@ static int traverse_regular(struct garmin_parser_t *garmin,
 	}
 
 	for (int i = 0; i < desc->nrfields; i++) {
-		const unsigned char *field = desc->fields[i];
+		const unsigned char *field = desc->fields + i * 3;
 		unsigned int field_nr = field[0];
 		unsigned int len = field[1];
 		unsigned int base_type = field[2] & 0x7f;
@@ -910,6 +911,11 @@ static int traverse_definition(struct garmin_parser_t *garmin,
 	struct type_desc *desc = garmin->type_desc + type;
 	int fields, devfields, len;
 
+	if (size < 5) {
+		ERROR(garmin->base.context, "Definition record too short\n");
+		return -1;
+	}
+
 	msg = array_uint16_le(data+2);
 	desc->msg_desc = lookup_msg_desc(msg, type, &desc->msg_name);
 	fields = data[4];
@@ -922,12 +928,13 @@ static int traverse_definition(struct garmin_parser_t *garmin,
 		return -1;
 	}
 
-	if (fields > MAXFIELDS) {
-		ERROR(garmin->base.context, "Too many fields in description: %d (max %d)\n", fields, MAXFIELDS);
+	len = 5 + fields*3;
+	if (size < len) {
+		ERROR(garmin->base.context, "Definition record too short for %d fields\n", fields);
 		return -1;
 	}
 	desc->nrfields = fields;
-	len = 5 + fields*3;
+	desc->fields = data + 5;
 	devfields = 0;
 	if (record & 0x20) {
 		devfields = data[len];
@@ -937,8 +944,7 @@ static int traverse_definition(struct garmin_parser_t *garmin,
 	}
 
 	for (int i = 0; i < fields; i++) {
-		unsigned char *field = desc->fields[i];
-		memcpy(field, data + (5+i*3), 3);
+		const unsigned char *field = desc->fields + i * 3;
 		DEBUG(garmin->base.context, "  %d: %02x %02x %02x", i, field[0], field[1], field[2]);
 	}
 
@@ -71,6 +71,8 @@ static const dc_device_vtable_t hw_frog_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	hw_frog_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	hw_frog_device_timesync, /* timesync */
 	hw_frog_device_close /* close */
 };
@@ -79,6 +79,8 @@ static const dc_device_vtable_t hw_ostc_device_vtable = {
 	NULL, /* write */
 	hw_ostc_device_dump, /* dump */
 	hw_ostc_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	hw_ostc_device_timesync, /* timesync */
 	NULL /* close */
 };
@@ -285,6 +287,9 @@ hw_ostc_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
+	// There is no command to read only part of the profile memory. The
+	// entire memory is always received, in address order. The dives are
+	// extracted afterwards, by scanning backwards from the end.
 	dc_status_t rc = hw_ostc_device_dump (abstract, buffer);
 	if (rc != DC_STATUS_SUCCESS) {
 		dc_buffer_free (buffer);
@@ -27,6 +27,8 @@
 #include "hw_ostc3.h"
 #include "context-private.h"
 #include "device-private.h"
+#include "checkpoint.h"
+#include "timer.h"
 #include "array.h"
 #include "aes.h"
 #include "platform.h"
@@ -128,6 +130,8 @@ static dc_status_t hw_ostc3_device_read (dc_device_t *abstract, unsigned int add
 static dc_status_t hw_ostc3_device_write (dc_device_t *abstract, unsigned int address, const unsigned char data[], unsigned int size);
 static dc_status_t hw_ostc3_device_dump (dc_device_t *abstract, dc_buffer_t *buffer);
 static dc_status_t hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t hw_ostc3_device_headers (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t hw_ostc3_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
 static dc_status_t hw_ostc3_device_timesync (dc_device_t *abstract, const dc_datetime_t *datetime);
 static dc_status_t hw_ostc3_device_close (dc_device_t *abstract);
 
@@ -139,6 +143,8 @@ static const dc_device_vtable_t hw_ostc3_device_vtable = {
 	hw_ostc3_device_write, /* write */
 	hw_ostc3_device_dump, /* dump */
 	hw_ostc3_device_foreach, /* foreach */
+	hw_ostc3_device_headers, /* headers */
+	hw_ostc3_device_read_dive, /* read_dive */
 	hw_ostc3_device_timesync, /* timesync */
 	hw_ostc3_device_close /* close */
 };
@@ -640,22 +646,13 @@ hw_ostc3_device_hardware (dc_device_t *abstract, unsigned char data[], unsigned
 
 
 static dc_status_t
-hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+hw_ostc3_device_devinfo (dc_device_t *abstract)
 {
 	hw_ostc3_device_t *device = (hw_ostc3_device_t *) abstract;
 
-	// Enable progress notifications.
-	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
-	progress.maximum = SZ_MEMORY;
-	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
-	dc_status_t rc = hw_ostc3_device_init (device, DOWNLOAD);
-	if (rc != DC_STATUS_SUCCESS)
-		return rc;
-
 	// Download the version data.
 	unsigned char id[SZ_VERSION] = {0};
-	rc = hw_ostc3_device_version (abstract, id, sizeof (id));
+	dc_status_t rc = hw_ostc3_device_version (abstract, id, sizeof (id));
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to read the version.");
 		return rc;
@@ -680,36 +677,146 @@ hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, voi
 	}
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
-	// Allocate memory.
-	unsigned char *header = (unsigned char *) malloc (RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT);
-	if (header == NULL) {
-		ERROR (abstract->context, "Failed to allocate memory.");
-		return DC_STATUS_NOMEMORY;
-	}
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+hw_ostc3_device_logbook (hw_ostc3_device_t *device, dc_event_progress_t *progress, unsigned char header[], unsigned int full, const hw_ostc3_logbook_t **logbook)
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_status_t rc = DC_STATUS_UNSUPPORTED;
 
 	// Download the compact logbook headers. If the firmware doesn't support
 	// compact headers yet, fallback to downloading the full logbook headers.
 	// This is slower, but also works for older firmware versions.
-	unsigned int compact = 1;
-	rc = hw_ostc3_transfer (device, &progress, COMPACT,
-              NULL, 0, header, RB_LOGBOOK_SIZE_COMPACT * RB_LOGBOOK_COUNT, NODELAY);
+	*logbook = &hw_ostc3_logbook_compact;
+	if (!full) {
+		rc = hw_ostc3_transfer (device, progress, COMPACT,
+			NULL, 0, header, RB_LOGBOOK_SIZE_COMPACT * RB_LOGBOOK_COUNT, NODELAY);
+	}
 	if (rc == DC_STATUS_UNSUPPORTED) {
-		compact = 0;
-		rc = hw_ostc3_transfer (device, &progress, HEADER,
-		          NULL, 0, header, RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT, NODELAY);
+		*logbook = &hw_ostc3_logbook_full;
+		rc = hw_ostc3_transfer (device, progress, HEADER,
+			NULL, 0, header, RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT, NODELAY);
 	}
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to read the header.");
-		free (header);
 		return rc;
 	}
 
-	// Get the correct logbook layout.
-	const hw_ostc3_logbook_t *logbook = NULL;
-	if (compact) {
-		logbook = &hw_ostc3_logbook_compact;
+	return DC_STATUS_SUCCESS;
+}
+
+
+static unsigned int
+hw_ostc3_device_length (const unsigned char entry[], const hw_ostc3_logbook_t *logbook)
+{
+	// Calculate the profile length.
+	unsigned int length = RB_LOGBOOK_SIZE_FULL + array_uint24_le (entry + logbook->profile) - 3;
+	if (logbook == &hw_ostc3_logbook_full) {
+		// Workaround for a bug in older firmware versions.
+		unsigned int firmware = array_uint16_be (entry + 0x30);
+		if (firmware < 93)
+			length -= 3;
+	}
+
+	return length;
+}
+
+
+static dc_status_t
+hw_ostc3_device_dive (hw_ostc3_device_t *device, dc_event_progress_t *progress, dc_checkpoint_t *checkpoint, unsigned int offset, unsigned int idx, const unsigned char entry[], const hw_ostc3_logbook_t *logbook, unsigned char profile[], unsigned int *length)
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	if (dc_checkpoint_read (checkpoint, offset, profile, *length) == DC_STATUS_SUCCESS) {
+		// Use the dive from the previous attempt.
+		if (progress) {
+			progress->current += *length + 1;
+			device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
+		}
 	} else {
-		logbook = &hw_ostc3_logbook_full;
+		// Download the dive.
+		unsigned char number[1] = {idx};
+		rc = hw_ostc3_transfer (device, progress, DIVE,
+			number, sizeof (number), profile, *length, NODELAY);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to read the dive.");
+			return rc;
+		}
+
+		dc_checkpoint_update (checkpoint, offset, profile, *length);
+	}
+
+	// Verify the header in the logbook and profile are identical.
+	if (logbook == &hw_ostc3_logbook_full && memcmp (profile, entry, logbook->size) != 0) {
+		ERROR (abstract->context, "Unexpected profile header.");
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	// Detect invalid profile data.
+	unsigned int delta = device->hardware == OSTC4 ? 3 : 0;
+	if (*length < RB_LOGBOOK_SIZE_FULL + 2 ||
+		profile[*length - 2] != 0xFD || profile[*length - 1] != 0xFD) {
+		// A valid profile should have at least a correct 2 byte
+		// end-of-profile marker.
+		WARNING (abstract->context, "Invalid profile end marker detected!");
+		*length = RB_LOGBOOK_SIZE_FULL;
+	} else if (*length == RB_LOGBOOK_SIZE_FULL + 2) {
+		// A profile containing only the 2 byte end-of-profile
+		// marker is considered a valid empty profile.
+	} else if (*length < RB_LOGBOOK_SIZE_FULL + 5 + 2 ||
+		array_uint24_le (profile + RB_LOGBOOK_SIZE_FULL) + delta != array_uint24_le (profile + 9)) {
+		// If there is more data available, then there should be a
+		// valid profile header containing a length matching the
+		// length in the dive header.
+		WARNING (abstract->context, "Invalid profile header detected.");
+		*length = RB_LOGBOOK_SIZE_FULL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+hw_ostc3_device_download (dc_device_t *abstract, unsigned int headers, dc_dive_callback_t callback, void *userdata)
+{
+	hw_ostc3_device_t *device = (hw_ostc3_device_t *) abstract;
+	dc_checkpoint_t *checkpoint = NULL;
+	unsigned char *profile = NULL;
+	unsigned char *key = NULL;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = SZ_MEMORY;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	dc_status_t rc = hw_ostc3_device_init (device, DOWNLOAD);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Emit a device info event.
+	rc = hw_ostc3_device_devinfo (abstract);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Allocate memory.
+	unsigned char *header = (unsigned char *) malloc (RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT);
+	if (header == NULL) {
+		ERROR (abstract->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Download the logbook headers. In header only mode, the full
+	// logbook headers are always needed, because the parser can't
+	// handle the compact headers.
+	const hw_ostc3_logbook_t *logbook = NULL;
+	rc = hw_ostc3_device_logbook (device, &progress, header, headers, &logbook);
+	if (rc != DC_STATUS_SUCCESS) {
+		free (header);
+		return rc;
 	}
 
 	// Locate the most recent dive.
@@ -753,13 +860,7 @@ hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, voi
 		}
 
 		// Calculate the profile length.
-		unsigned int length = RB_LOGBOOK_SIZE_FULL + array_uint24_le (header + offset + logbook->profile) - 3;
-		if (!compact) {
-			// Workaround for a bug in older firmware versions.
-			unsigned int firmware = array_uint16_be (header + offset + 0x30);
-			if (firmware < 93)
-				length -= 3;
-		}
+		unsigned int length = hw_ostc3_device_length (header + offset, logbook);
 		if (length < RB_LOGBOOK_SIZE_FULL) {
 			ERROR (abstract->context, "Invalid profile length (%u bytes).", length);
 			free (header);
@@ -777,7 +878,10 @@ hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, voi
 	}
 
 	// Update and emit a progress event.
-	progress.maximum = (logbook->size * RB_LOGBOOK_COUNT) + size + ndives;
+	progress.maximum = (logbook->size * RB_LOGBOOK_COUNT);
+	if (!headers) {
+		progress.maximum += size + ndives;
+	}
 	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 
 	// Finish immediately if there are no dives available.
@@ -786,78 +890,178 @@ hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, voi
 		return DC_STATUS_SUCCESS;
 	}
 
-	// Allocate enough memory for the largest dive.
-	unsigned char *profile = (unsigned char *) malloc (maxsize);
-	if (profile == NULL) {
-		ERROR (abstract->context, "Failed to allocate memory.");
+	// Pass the full logbook headers, without the profile data. This
+	// is the same data as for a dive with an invalid profile.
+	if (headers) {
+		for (unsigned int i = 0; i < ndives; ++i) {
+			unsigned int idx = (latest + RB_LOGBOOK_COUNT - i) % RB_LOGBOOK_COUNT;
+			unsigned char *p = header + idx * logbook->size;
+
+			if (callback && !callback (p, logbook->size, p + logbook->fingerprint, sizeof (device->fingerprint), userdata))
+				break;
+		}
+
 		free (header);
-		return DC_STATUS_NOMEMORY;
+		return DC_STATUS_SUCCESS;
 	}
 
+	// Allocate enough memory for the largest dive, and for the logbook
+	// headers of all dives.
+	profile = (unsigned char *) malloc (maxsize);
+	key = (unsigned char *) malloc (ndives * logbook->size);
+	if (profile == NULL || key == NULL) {
+		ERROR (abstract->context, "Failed to allocate memory.");
+		rc = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	// The dives are downloaded as one transfer, with the logbook headers
+	// of the dives as the snapshot of the device state.
+	for (unsigned int i = 0; i < ndives; ++i) {
+		unsigned int idx = (latest + RB_LOGBOOK_COUNT - i) % RB_LOGBOOK_COUNT;
+		memcpy (key + i * logbook->size, header + idx * logbook->size, logbook->size);
+	}
+
+	rc = dc_checkpoint_new (&checkpoint, abstract, 0, size, key, ndives * logbook->size);
+	if (rc != DC_STATUS_SUCCESS)
+		goto error_free;
+
 	// Download the dives.
+	unsigned int position = 0;
 	for (unsigned int i = 0; i < ndives; ++i) {
 		unsigned int idx = (latest + RB_LOGBOOK_COUNT - i) % RB_LOGBOOK_COUNT;
 		unsigned int offset = idx * logbook->size;
 
-		// Calculate the profile length.
-		unsigned int length = RB_LOGBOOK_SIZE_FULL + array_uint24_le (header + offset + logbook->profile) - 3;
-		if (!compact) {
-			// Workaround for a bug in older firmware versions.
-			unsigned int firmware = array_uint16_be (header + offset + 0x30);
-			if (firmware < 93)
-				length -= 3;
-		}
-
 		// Download the dive.
-		unsigned char number[1] = {idx};
-		rc = hw_ostc3_transfer (device, &progress, DIVE,
-			number, sizeof (number), profile, length, NODELAY);
-		if (rc != DC_STATUS_SUCCESS) {
-			ERROR (abstract->context, "Failed to read the dive.");
-			free (profile);
-			free (header);
-			return rc;
-		}
-
-		// Verify the header in the logbook and profile are identical.
-		if (!compact && memcmp (profile, header + offset, logbook->size) != 0) {
-			ERROR (abstract->context, "Unexpected profile header.");
-			free (profile);
-			free (header);
-			return rc;
-		}
+		unsigned int length = hw_ostc3_device_length (header + offset, logbook);
+		unsigned int next = position + length;
+		rc = hw_ostc3_device_dive (device, &progress, checkpoint, position, idx, header + offset, logbook, profile, &length);
+		if (rc != DC_STATUS_SUCCESS)
+			goto error_free;
 
-		// Detect invalid profile data.
-		unsigned int delta = device->hardware == OSTC4 ? 3 : 0;
-		if (length < RB_LOGBOOK_SIZE_FULL + 2 ||
-			profile[length - 2] != 0xFD || profile[length - 1] != 0xFD) {
-			// A valid profile should have at least a correct 2 byte
-			// end-of-profile marker.
-			WARNING (abstract->context, "Invalid profile end marker detected!");
-			length = RB_LOGBOOK_SIZE_FULL;
-		} else if (length == RB_LOGBOOK_SIZE_FULL + 2) {
-			// A profile containing only the 2 byte end-of-profile
-			// marker is considered a valid empty profile.
-		} else if (length < RB_LOGBOOK_SIZE_FULL + 5 + 2 ||
-			array_uint24_le (profile + RB_LOGBOOK_SIZE_FULL) + delta != array_uint24_le (profile + 9)) {
-			// If there is more data available, then there should be a
-			// valid profile header containing a length matching the
-			// length in the dive header.
-			WARNING (abstract->context, "Invalid profile header detected.");
-			length = RB_LOGBOOK_SIZE_FULL;
-		}
+		position = next;
 
 		if (callback && !callback (profile, length, profile + 12, sizeof (device->fingerprint), userdata))
 			break;
 	}
 
+error_free:
+	dc_checkpoint_free (checkpoint);
+	free (key);
 	free (profile);
 	free (header);
 
-	return DC_STATUS_SUCCESS;
+	return rc;
+}
+
+
+static dc_status_t
+hw_ostc3_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return hw_ostc3_device_download (abstract, 0, callback, userdata);
+}
+
+
+static dc_status_t
+hw_ostc3_device_headers (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return hw_ostc3_device_download (abstract, 1, callback, userdata);
 }
 
 
+
+static dc_status_t
+hw_ostc3_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	hw_ostc3_device_t *device = (hw_ostc3_device_t *) abstract;
+
+	if (size != sizeof (device->fingerprint))
+		return DC_STATUS_INVALIDARGS;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	dc_status_t rc = hw_ostc3_device_init (device, DOWNLOAD);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Emit a device info event.
+	rc = hw_ostc3_device_devinfo (abstract);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Allocate memory.
+	unsigned char *header = (unsigned char *) malloc (RB_LOGBOOK_SIZE_FULL * RB_LOGBOOK_COUNT);
+	if (header == NULL) {
+		ERROR (abstract->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Download the logbook headers.
+	const hw_ostc3_logbook_t *logbook = NULL;
+	rc = hw_ostc3_device_logbook (device, &progress, header, 0, &logbook);
+	if (rc != DC_STATUS_SUCCESS) {
+		free (header);
+		return rc;
+	}
+
+	// Locate the logbook entry with the matching fingerprint. The
+	// position in the logbook is also the dive number.
+	unsigned int idx = 0;
+	for (idx = 0; idx < RB_LOGBOOK_COUNT; ++idx) {
+		unsigned int offset = idx * logbook->size;
+
+		// Ignore uninitialized header entries.
+		if (array_isequal (header + offset, logbook->size, 0xFF))
+			continue;
+
+		if (memcmp (header + offset + logbook->fingerprint, fingerprint, size) == 0)
+			break;
+	}
+
+	if (idx == RB_LOGBOOK_COUNT) {
+		ERROR (abstract->context, "No dive with the requested fingerprint.");
+		free (header);
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Calculate the profile length.
+	const unsigned char *entry = header + idx * logbook->size;
+	unsigned int length = hw_ostc3_device_length (entry, logbook);
+	if (length < RB_LOGBOOK_SIZE_FULL) {
+		ERROR (abstract->context, "Invalid profile length (%u bytes).", length);
+		free (header);
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	// Update and emit a progress event.
+	progress.maximum = (logbook->size * RB_LOGBOOK_COUNT) + length + 1;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Allocate memory for the dive.
+	if (!dc_buffer_resize (buffer, length)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		free (header);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Download the dive.
+	rc = hw_ostc3_device_dive (device, &progress, NULL, 0, idx, entry, logbook, dc_buffer_get_data (buffer), &length);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_buffer_clear (buffer);
+		free (header);
+		return rc;
+	}
+
+	dc_buffer_resize (buffer, length);
+
+	free (header);
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 hw_ostc3_device_timesync (dc_device_t *abstract, const dc_datetime_t *datetime)
 {
@@ -1284,12 +1488,81 @@ hw_ostc3_firmware_upgrade (dc_device_t *abstract, unsigned int checksum)
 }
 
 
+static unsigned int
+hw_ostc3_firmware_elapsed (dc_timer_t *timer, dc_usecs_t begin)
+{
+	dc_usecs_t now = 0;
+	if (timer == NULL || dc_timer_now (timer, &now) != DC_STATUS_SUCCESS)
+		return 0;
+
+	return (now - begin) / 1000;
+}
+
+static void
+hw_ostc3_firmware_report (dc_context_t *context, const char *phase, unsigned int size, dc_timer_t *timer, dc_usecs_t begin)
+{
+	unsigned int msecs = hw_ostc3_firmware_elapsed (timer, begin);
+	if (msecs) {
+		INFO (context, "%s: %u bytes in %u ms (%u bytes/s).",
+			phase, size, msecs, (unsigned int) (size * 1000ULL / msecs));
+	} else {
+		INFO (context, "%s: %u bytes.", phase, size);
+	}
+}
+
+static dc_status_t
+hw_ostc3_firmware_block_verify (hw_ostc3_device_t *device, unsigned int addr, const unsigned char data[])
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	unsigned char block[SZ_FIRMWARE_BLOCK];
+
+	rc = hw_ostc3_firmware_block_read (device, addr, block, sizeof (block));
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read block.");
+		return rc;
+	}
+
+	if (memcmp (data, block, sizeof (block)) == 0)
+		return DC_STATUS_SUCCESS;
+
+	// Erase and write the block once more. Every block is a separate
+	// flash page, so a single bad write doesn't require starting over.
+	WARNING (abstract->context, "Rewriting block at address 0x%06x.", addr);
+	rc = hw_ostc3_firmware_erase (device, addr, sizeof (block));
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to erase block.");
+		return rc;
+	}
+
+	rc = hw_ostc3_firmware_block_write (device, addr, data, sizeof (block));
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to write block to device");
+		return rc;
+	}
+
+	rc = hw_ostc3_firmware_block_read (device, addr, block, sizeof (block));
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read block.");
+		return rc;
+	}
+
+	if (memcmp (data, block, sizeof (block)) != 0) {
+		ERROR (abstract->context, "Failed verify.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 hw_ostc3_device_fwupdate3 (dc_device_t *abstract, const char *filename)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	hw_ostc3_device_t *device = (hw_ostc3_device_t *) abstract;
 	dc_context_t *context = (abstract ? abstract->context : NULL);
+	dc_timer_t *timer = NULL;
+	dc_usecs_t start = 0;
 
 	// Enable progress notifications.
 	// load, erase, upload FZ, verify FZ, reprogram
@@ -1297,18 +1570,23 @@ hw_ostc3_device_fwupdate3 (dc_device_t *abstract, const char *filename)
 	progress.maximum = 3 + SZ_FIRMWARE * 2 / SZ_FIRMWARE_BLOCK;
 	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 
+	// The timer is only used for reporting the duration of each phase.
+	// It starts counting at zero when created.
+	if (dc_timer_new (&timer) != DC_STATUS_SUCCESS)
+		timer = NULL;
+
 	// Allocate memory for the firmware data.
 	hw_ostc3_firmware_t *firmware = (hw_ostc3_firmware_t *) malloc (sizeof (hw_ostc3_firmware_t));
 	if (firmware == NULL) {
 		ERROR (context, "Failed to allocate memory.");
-		return DC_STATUS_NOMEMORY;
+		rc = DC_STATUS_NOMEMORY;
+		goto error_timer_free;
 	}
 
 	// Read the hex file.
 	rc = hw_ostc3_firmware_readfile3 (firmware, context, filename);
 	if (rc != DC_STATUS_SUCCESS) {
-		free (firmware);
-		return rc;
+		goto error_free;
 	}
 
 	// Device open and firmware loaded
@@ -1317,19 +1595,24 @@ hw_ostc3_device_fwupdate3 (dc_device_t *abstract, const char *filename)
 
 	hw_ostc3_device_display (abstract, " Erasing FW...");
 
+	if (timer)
+		dc_timer_now (timer, &start);
 	rc = hw_ostc3_firmware_erase (device, FIRMWARE_AREA, SZ_FIRMWARE);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to erase old firmware");
-		free (firmware);
-		return rc;
+		goto error_free;
 	}
 
+	hw_ostc3_firmware_report (context, "Erase", SZ_FIRMWARE, timer, start);
+
 	// Memory erased
 	progress.current++;
 	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 
 	hw_ostc3_device_display (abstract, " Uploading...");
 
+	if (timer)
+		dc_timer_now (timer, &start);
 	for (unsigned int len = 0; len < SZ_FIRMWARE; len += SZ_FIRMWARE_BLOCK) {
 		char status[SZ_DISPLAY + 1]; // Status message on the display
 		snprintf (status, sizeof(status), " Uploading %2d%%", (100 * len) / SZ_FIRMWARE);
@@ -1338,56 +1621,55 @@ hw_ostc3_device_fwupdate3 (dc_device_t *abstract, const char *filename)
 		rc = hw_ostc3_firmware_block_write (device, FIRMWARE_AREA + len, firmware->data + len, SZ_FIRMWARE_BLOCK);
 		if (rc != DC_STATUS_SUCCESS) {
 			ERROR (context, "Failed to write block to device");
-			free(firmware);
-			return rc;
+			goto error_free;
 		}
 		// One block uploaded
 		progress.current++;
 		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 	}
 
+	hw_ostc3_firmware_report (context, "Upload", SZ_FIRMWARE, timer, start);
+
 	hw_ostc3_device_display (abstract, " Verifying...");
 
+	if (timer)
+		dc_timer_now (timer, &start);
 	for (unsigned int len = 0; len < SZ_FIRMWARE; len += SZ_FIRMWARE_BLOCK) {
-		unsigned char block[SZ_FIRMWARE_BLOCK];
 		char status[SZ_DISPLAY + 1]; // Status message on the display
 		snprintf (status, sizeof(status), " Verifying %2d%%", (100 * len) / SZ_FIRMWARE);
 		hw_ostc3_device_display (abstract, status);
 
-		rc = hw_ostc3_firmware_block_read (device, FIRMWARE_AREA + len, block, sizeof (block));
+		rc = hw_ostc3_firmware_block_verify (device, FIRMWARE_AREA + len, firmware->data + len);
 		if (rc != DC_STATUS_SUCCESS) {
-			ERROR (context, "Failed to read block.");
-			free (firmware);
-			return rc;
-		}
-		if (memcmp (firmware->data + len, block, sizeof (block)) != 0) {
-			ERROR (context, "Failed verify.");
 			hw_ostc3_device_display (abstract, " Verify FAILED");
-			free (firmware);
-			return DC_STATUS_PROTOCOL;
+			goto error_free;
 		}
 		// One block verified
 		progress.current++;
 		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 	}
 
+	hw_ostc3_firmware_report (context, "Verify", SZ_FIRMWARE, timer, start);
+
 	hw_ostc3_device_display (abstract, " Programming...");
 
 	rc = hw_ostc3_firmware_upgrade (abstract, firmware->checksum);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (context, "Failed to start programing");
-		free (firmware);
-		return rc;
+		goto error_free;
 	}
 
 	// Programing done!
 	progress.current++;
 	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
 
-	free (firmware);
+	INFO (context, "Firmware update completed in %u ms.", hw_ostc3_firmware_elapsed (timer, 0));
 
-	// Finished!
-	return DC_STATUS_SUCCESS;
+error_free:
+	free (firmware);
+error_timer_free:
+	dc_timer_free (timer);
+	return rc;
 }
 
 static dc_status_t
@@ -1396,6 +1678,12 @@ hw_ostc3_device_fwupdate4 (dc_device_t *abstract, const char *filename)
 	dc_status_t status = DC_STATUS_SUCCESS;
 	hw_ostc3_device_t *device = (hw_ostc3_device_t *) abstract;
 	dc_context_t *context = (abstract ? abstract->context : NULL);
+	dc_timer_t *timer = NULL;
+	dc_usecs_t start = 0;
+
+	// The timer is only used for reporting the duration of each blob.
+	if (dc_timer_new (&timer) != DC_STATUS_SUCCESS)
+		timer = NULL;
 
 	// Allocate memory for the firmware data.
 	dc_buffer_t *buffer = dc_buffer_new (0);
@@ -1465,11 +1753,16 @@ hw_ostc3_device_fwupdate4 (dc_device_t *abstract, const char *filename)
 		if (memcmp(data + offset + 12, fwinfo, sizeof(fwinfo)) != 0 &&
 			!array_isequal(fwinfo, sizeof(fwinfo), 0xFF))
 		{
+			if (timer)
+				dc_timer_now (timer, &start);
+
 			status = hw_ostc3_transfer (device, &progress, S_UPLOAD,
 				data + offset, length, NULL, 0, usecs / 1000);
 			if (status != DC_STATUS_SUCCESS) {
 				goto error;
 			}
+
+			hw_ostc3_firmware_report (context, "Upload", length, timer, start);
 		} else {
 			// Update and emit a progress event.
 			progress.current += length;
@@ -1479,8 +1772,11 @@ hw_ostc3_device_fwupdate4 (dc_device_t *abstract, const char *filename)
 		offset += length;
 	}
 
+	INFO (context, "Firmware update completed in %u ms.", hw_ostc3_firmware_elapsed (timer, 0));
+
 error:
 	dc_buffer_free (buffer);
+	dc_timer_free (timer);
 	return status;
 }
 
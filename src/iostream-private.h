@@ -36,6 +36,12 @@ struct dc_iostream_t {
 	const dc_iostream_vtable_t *vtable;
 	dc_context_t *context;
 	dc_transport_t transport;
+	// Cancellation support. The flag is checked before every operation,
+	// and the pipe only by the backends that wait on it.
+	volatile long cancelled;
+#ifndef _WIN32
+	int cancel[2];
+#endif
 };
 
 struct dc_iostream_vtable_t {
@@ -79,6 +85,19 @@ dc_iostream_deallocate (dc_iostream_t *iostream);
 int
 dc_iostream_isinstance (dc_iostream_t *iostream, const dc_iostream_vtable_t *vtable);
 
+/*
+ * The file descriptor becomes readable when the I/O stream is cancelled.
+ * Backends include it in every blocking wait, or -1 if not supported.
+ */
+int
+dc_iostream_get_cancel_fd (dc_iostream_t *iostream);
+
+int
+dc_iostream_is_cancelled (dc_iostream_t *iostream);
+
+dc_status_t
+dc_iostream_sleep_cancellable (dc_iostream_t *iostream, unsigned int milliseconds);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
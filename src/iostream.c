@@ -19,14 +19,37 @@
  * MA 02110-1301 USA
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stddef.h>
 #include <stdlib.h>
 #include <assert.h>
 
+#ifdef _WIN32
+#define NOGDI
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#endif
+
 #include "iostream-private.h"
 #include "context-private.h"
+#include "timer.h"
 #include "platform.h"
 
+#ifdef _WIN32
+#define ATOMIC_LOAD(x)            InterlockedCompareExchange ((x), 0, 0)
+#define ATOMIC_EXCHANGE(x,value)  InterlockedExchange ((x), (value))
+#else
+#define ATOMIC_LOAD(x)            __atomic_load_n ((x), __ATOMIC_SEQ_CST)
+#define ATOMIC_EXCHANGE(x,value)  __atomic_exchange_n ((x), (value), __ATOMIC_SEQ_CST)
+#endif
+
 dc_iostream_t *
 dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable, dc_transport_t transport)
 {
@@ -47,12 +70,44 @@ dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable,
 	iostream->context = context;
 	iostream->transport = transport;
 
+	// Create the self-pipe for the cancellation. Both ends are
+	// non-blocking, such that cancelling never blocks, and the pipe can
+	// be drained without knowing the number of bytes.
+	iostream->cancelled = 0;
+#ifndef _WIN32
+	if (pipe (iostream->cancel) != 0) {
+		SYSERROR (context, errno);
+		free (iostream);
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < 2; ++i) {
+		int flags = fcntl (iostream->cancel[i], F_GETFL);
+		if (flags < 0 || fcntl (iostream->cancel[i], F_SETFL, flags | O_NONBLOCK) != 0 ||
+			fcntl (iostream->cancel[i], F_SETFD, FD_CLOEXEC) != 0) {
+			SYSERROR (context, errno);
+			close (iostream->cancel[0]);
+			close (iostream->cancel[1]);
+			free (iostream);
+			return NULL;
+		}
+	}
+#endif
+
 	return iostream;
 }
 
 void
 dc_iostream_deallocate (dc_iostream_t *iostream)
 {
+	if (iostream == NULL)
+		return;
+
+#ifndef _WIN32
+	close (iostream->cancel[0]);
+	close (iostream->cancel[1]);
+#endif
+
 	free (iostream);
 }
 
@@ -65,6 +120,105 @@ dc_iostream_isinstance (dc_iostream_t *iostream, const dc_iostream_vtable_t *vta
 	return iostream->vtable == vtable;
 }
 
+int
+dc_iostream_get_cancel_fd (dc_iostream_t *iostream)
+{
+#ifdef _WIN32
+	return -1;
+#else
+	if (iostream == NULL)
+		return -1;
+
+	return iostream->cancel[0];
+#endif
+}
+
+int
+dc_iostream_is_cancelled (dc_iostream_t *iostream)
+{
+	if (iostream == NULL)
+		return 0;
+
+	// Only the flag is checked here, to avoid a system call for every
+	// operation. The pipe is for the backends that block in a wait.
+	return ATOMIC_LOAD (&iostream->cancelled) != 0;
+}
+
+dc_status_t
+dc_iostream_sleep_cancellable (dc_iostream_t *iostream, unsigned int milliseconds)
+{
+#ifdef _WIN32
+	Sleep (milliseconds);
+	if (dc_iostream_is_cancelled (iostream))
+		return DC_STATUS_CANCELLED;
+
+	return DC_STATUS_SUCCESS;
+#else
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_timer_t *timer = NULL;
+	dc_usecs_t now = 0;
+
+	status = dc_timer_new (&timer);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	// Wait on the cancellation pipe, instead of sleeping. The remaining
+	// time is recalculated after an interrupted system call.
+	dc_usecs_t target = (dc_usecs_t) milliseconds * 1000;
+	while ((status = dc_timer_now (timer, &now)) == DC_STATUS_SUCCESS && now < target) {
+		struct pollfd pfd;
+		pfd.fd = iostream->cancel[0];
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		int rc = poll (&pfd, 1, (target - now + 999) / 1000);
+		if (rc < 0) {
+			int errcode = errno;
+			if (errcode == EINTR)
+				continue; // Retry.
+			SYSERROR (iostream->context, errcode);
+			status = DC_STATUS_IO;
+			break;
+		} else if (rc > 0) {
+			status = DC_STATUS_CANCELLED;
+			break;
+		}
+	}
+
+	dc_timer_free (timer);
+
+	return status;
+#endif
+}
+
+dc_status_t
+dc_iostream_set_cancelled (dc_iostream_t *iostream, unsigned int value)
+{
+	if (iostream == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+#ifdef _WIN32
+	ATOMIC_EXCHANGE (&iostream->cancelled, value ? 1 : 0);
+#else
+	long previous = ATOMIC_EXCHANGE (&iostream->cancelled, value ? 1 : 0);
+	if (value) {
+		// A single byte is sufficient to make the pipe readable.
+		if (!previous) {
+			unsigned char byte = 0;
+			if (write (iostream->cancel[1], &byte, 1) != 1) {
+				ATOMIC_EXCHANGE (&iostream->cancelled, 0);
+				return DC_STATUS_IO;
+			}
+		}
+	} else if (previous) {
+		unsigned char buffer[16];
+		while (read (iostream->cancel[0], buffer, sizeof (buffer)) > 0);
+	}
+#endif
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_transport_t
 dc_iostream_get_transport (dc_iostream_t *iostream)
 {
@@ -193,6 +347,11 @@ dc_iostream_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actu
 		goto out;
 	}
 
+	if (dc_iostream_is_cancelled (iostream)) {
+		status = DC_STATUS_CANCELLED;
+		goto out;
+	}
+
 	status = iostream->vtable->read (iostream, data, size, &nbytes);
 
 	HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Read", (unsigned char *) data, nbytes);
@@ -214,6 +373,11 @@ dc_iostream_write (dc_iostream_t *iostream, const void *data, size_t size, size_
 		goto out;
 	}
 
+	if (dc_iostream_is_cancelled (iostream)) {
+		status = DC_STATUS_CANCELLED;
+		goto out;
+	}
+
 	status = iostream->vtable->write (iostream, data, size, &nbytes);
 
 	HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Write", (const unsigned char *) data, nbytes);
@@ -255,6 +419,9 @@ dc_iostream_sleep (dc_iostream_t *iostream, unsigned int milliseconds)
 
 	INFO (iostream->context, "Sleep: value=%u", milliseconds);
 
+	if (dc_iostream_is_cancelled (iostream))
+		return DC_STATUS_CANCELLED;
+
 	return iostream->vtable->sleep (iostream, milliseconds);
 }
 
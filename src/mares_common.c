@@ -360,3 +360,90 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 
 	return DC_STATUS_SUCCESS;
 }
+
+
+/*
+ * Verify that the profile ringbuffer between the previous and the current
+ * end of profile pointer contains nothing but complete dives. If the
+ * device logged more data than fits in the ringbuffer in the meantime,
+ * the ringbuffer pointers can no longer be trusted to locate the changes.
+ */
+int
+mares_common_check_profiles (const mares_common_layout_t *layout, const unsigned char data[], unsigned int previous)
+{
+	assert (layout != NULL);
+
+	// Get the freedive mode for this model.
+	unsigned int model = data[1];
+	unsigned int freedive = FREEDIVE;
+	if (model == NEMOWIDE || model == NEMOAIR || model == PUCK || model == PUCKAIR)
+		freedive = GAUGE;
+
+	// Get the end of the profile ring buffer.
+	unsigned int eop = array_uint16_le (data + 0x6B);
+	if (eop < layout->rb_profile_begin || eop >= layout->rb_profile_end ||
+		previous < layout->rb_profile_begin || previous >= layout->rb_profile_end)
+		return 0;
+
+	// Make the new part of the ringbuffer linear.
+	unsigned int rb_size = layout->rb_profile_end - layout->rb_profile_begin;
+	unsigned int size = (eop + rb_size - previous) % rb_size;
+	if (size == 0)
+		return 1;
+
+	unsigned char *buffer = (unsigned char *) malloc (size);
+	if (buffer == NULL)
+		return 0;
+
+	if (previous < eop) {
+		memcpy (buffer, data + previous, size);
+	} else {
+		memcpy (buffer, data + previous, layout->rb_profile_end - previous);
+		memcpy (buffer + layout->rb_profile_end - previous, data + layout->rb_profile_begin, eop - layout->rb_profile_begin);
+	}
+
+	// Walk backwards over the new dives, exactly as during the extraction,
+	// until the previous end of profile pointer is reached.
+	unsigned int offset = size;
+	while (offset) {
+		unsigned int extra = 0;
+		const unsigned char marker[3] = {0xAA, 0xBB, 0xCC};
+		if (offset >= 3 && memcmp (buffer + offset - 3, marker, sizeof (marker)) == 0) {
+			if (model == PUCKAIR)
+				extra = 7;
+			else
+				extra = 12;
+		}
+
+		if (offset < extra + 3)
+			break;
+
+		unsigned int mode = buffer[offset - extra - 1];
+		if (mode == 0xFF)
+			break;
+
+		unsigned int header_size = 53;
+		unsigned int sample_size = 2;
+		if (extra) {
+			if (model == PUCKAIR)
+				sample_size = 3;
+			else
+				sample_size = 5;
+		}
+		if (mode == freedive) {
+			header_size = 28;
+			sample_size = 6;
+		}
+
+		unsigned int nsamples = array_uint16_le (buffer + offset - extra - 3);
+		unsigned int nbytes = 2 + nsamples * sample_size + header_size + extra;
+		if (offset < nbytes || array_uint16_le (buffer + offset - nbytes) != nbytes)
+			break;
+
+		offset -= nbytes;
+	}
+
+	free (buffer);
+
+	return offset == 0;
+}
@@ -56,6 +56,9 @@ mares_common_device_read (dc_device_t *abstract, unsigned int address, unsigned
 dc_status_t
 mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *layout, const unsigned char fingerprint[], const unsigned char data[], dc_dive_callback_t callback, void *userdata);
 
+int
+mares_common_check_profiles (const mares_common_layout_t *layout, const unsigned char data[], unsigned int previous);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -29,6 +29,8 @@
 #include "mares_common.h"
 #include "context-private.h"
 #include "device-private.h"
+#include "mirror.h"
+#include "store-private.h"
 #include "array.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &mares_darwin_device_vtable)
@@ -69,6 +71,8 @@ static const dc_device_vtable_t mares_darwin_device_vtable = {
 	NULL, /* write */
 	mares_darwin_device_dump, /* dump */
 	mares_darwin_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -204,6 +208,127 @@ mares_darwin_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 }
 
 
+/*
+ * Verify that the profile data between the previous and the current end of
+ * profile pointer matches the size of the dives logged in the meantime. If
+ * the device logged more data than fits in the ringbuffer, the ringbuffer
+ * pointers can no longer be trusted to locate the changes.
+ */
+static int
+mares_darwin_check_profiles (const mares_darwin_layout_t *layout, const unsigned char data[], unsigned int previous, unsigned int plast)
+{
+	unsigned int eop = array_uint16_be (data + 0x8A);
+	unsigned int last = data[0x8C];
+	if (last >= layout->rb_logbook_count)
+		return 0;
+
+	unsigned int rb_size = layout->rb_profile_end - layout->rb_profile_begin;
+	unsigned int distance = (eop + rb_size - previous) % rb_size;
+
+	// Add up the profile size of all the new logbook entries.
+	unsigned int length = 0;
+	unsigned int ndives = (layout->rb_logbook_count + last - plast) % layout->rb_logbook_count;
+	for (unsigned int i = 1; i <= ndives; ++i) {
+		unsigned int idx = (plast + i) % layout->rb_logbook_count;
+		unsigned int offset = layout->rb_logbook_offset + idx * layout->rb_logbook_size;
+		unsigned int nsamples = array_uint16_be (data + offset + 6);
+		if (nsamples == 0xFFFF)
+			return 0;
+
+		length += nsamples * layout->samplesize;
+		if (length >= rb_size)
+			return 0;
+	}
+
+	return length == distance;
+}
+
+
+static dc_status_t
+mares_darwin_device_delta (dc_device_t *abstract, dc_buffer_t *buffer)
+{
+	mares_darwin_device_t *device = (mares_darwin_device_t *) abstract;
+	const mares_darwin_layout_t *layout = device->layout;
+	dc_mirror_t *mirror = NULL;
+
+	// Allocate the required amount of memory.
+	if (!dc_buffer_resize (buffer, layout->memsize)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data (buffer);
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = layout->rb_logbook_offset + layout->memsize;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Read the header with the serial number and the pointers.
+	dc_status_t rc = dc_device_read (abstract, 0, data, layout->rb_logbook_offset);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	progress.current += layout->rb_logbook_offset;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	rc = dc_mirror_new (&mirror, abstract, array_uint16_be (data + 8), layout->memsize, PACKETSIZE);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Only the profile data between the previous and the current end of
+	// profile pointer can have changed. The header and the (small)
+	// logbook area are always downloaded again.
+	unsigned char previous[3] = {0};
+	unsigned int eop = array_uint16_be (data + 0x8A);
+	unsigned int delta =
+		dc_mirror_peek (mirror, 0x8A, previous, sizeof (previous)) == DC_STATUS_SUCCESS &&
+		array_uint16_be (previous) >= layout->rb_profile_begin &&
+		array_uint16_be (previous) < layout->rb_profile_end &&
+		previous[2] < layout->rb_logbook_count &&
+		eop >= layout->rb_profile_begin && eop < layout->rb_profile_end;
+	if (delta) {
+		dc_mirror_invalidate (mirror, 0, layout->rb_profile_begin);
+		dc_mirror_invalidate_ringbuffer (mirror, layout->rb_profile_begin, layout->rb_profile_end,
+			array_uint16_be (previous), eop);
+	} else {
+		dc_mirror_invalidate (mirror, 0, layout->memsize);
+	}
+
+	// There is no need to download the header again.
+	dc_mirror_update (mirror, 0, data, layout->rb_logbook_offset);
+
+	rc = dc_mirror_read (mirror, &progress, 0, data, layout->memsize);
+	if (rc != DC_STATUS_SUCCESS)
+		goto error_free;
+
+	// If the ringbuffer has been overrun since the previous download,
+	// fall back to downloading the entire memory.
+	if (delta && !mares_darwin_check_profiles (layout, data, array_uint16_be (previous), previous[2])) {
+		WARNING (abstract->context, "Profile ringbuffer overrun since the last download.");
+		progress.maximum += layout->memsize;
+		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+		dc_mirror_invalidate (mirror, 0, layout->memsize);
+		dc_mirror_update (mirror, 0, data, layout->rb_logbook_offset);
+
+		rc = dc_mirror_read (mirror, &progress, 0, data, layout->memsize);
+		if (rc != DC_STATUS_SUCCESS)
+			goto error_free;
+	}
+
+	rc = dc_mirror_commit (mirror);
+	if (rc != DC_STATUS_SUCCESS) {
+		WARNING (abstract->context, "Failed to save the memory mirror.");
+		rc = DC_STATUS_SUCCESS;
+	}
+
+error_free:
+	dc_mirror_free (mirror);
+	return rc;
+}
+
+
 static dc_status_t
 mares_darwin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
@@ -215,7 +340,13 @@ mares_darwin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback,
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
-	dc_status_t rc = mares_darwin_device_dump (abstract, buffer);
+	// With a memory mirror in the store, only the changed memory is
+	// downloaded.
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	if (dc_store_get_flags (abstract->store) & DC_STORE_MIRROR)
+		rc = mares_darwin_device_delta (abstract, buffer);
+	else
+		rc = mares_darwin_device_dump (abstract, buffer);
 	if (rc != DC_STATUS_SUCCESS) {
 		dc_buffer_free (buffer);
 		return rc;
@@ -60,6 +60,8 @@ static const dc_device_vtable_t mares_nemo_device_vtable = {
 	NULL, /* write */
 	mares_nemo_device_dump, /* dump */
 	mares_nemo_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
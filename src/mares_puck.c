@@ -27,6 +27,8 @@
 #include "mares_common.h"
 #include "context-private.h"
 #include "device-private.h"
+#include "mirror.h"
+#include "store-private.h"
 #include "checksum.h"
 #include "array.h"
 
@@ -55,6 +57,8 @@ static const dc_device_vtable_t mares_puck_device_vtable = {
 	NULL, /* write */
 	mares_puck_device_dump, /* dump */
 	mares_puck_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -207,6 +211,91 @@ mares_puck_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 }
 
 
+static dc_status_t
+mares_puck_device_delta (dc_device_t *abstract, dc_buffer_t *buffer)
+{
+	mares_puck_device_t *device = (mares_puck_device_t *) abstract;
+	const mares_common_layout_t *layout = device->layout;
+	dc_mirror_t *mirror = NULL;
+
+	// Allocate the required amount of memory.
+	if (!dc_buffer_resize (buffer, layout->memsize)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data (buffer);
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = layout->rb_profile_begin + layout->memsize;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Read the header with the serial number and the pointers.
+	dc_status_t rc = dc_device_read (abstract, 0, data, layout->rb_profile_begin);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	progress.current += layout->rb_profile_begin;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	rc = dc_mirror_new (&mirror, abstract, array_uint16_be (data + 8), layout->memsize, PACKETSIZE);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Only the profile data between the previous and the current end of
+	// profile pointer can have changed. The header and the freedive
+	// profile area are always downloaded again.
+	unsigned char previous[2] = {0};
+	unsigned int eop = array_uint16_le (data + 0x6B);
+	unsigned int delta =
+		dc_mirror_peek (mirror, 0x6B, previous, sizeof (previous)) == DC_STATUS_SUCCESS &&
+		array_uint16_le (previous) >= layout->rb_profile_begin &&
+		array_uint16_le (previous) < layout->rb_profile_end &&
+		eop >= layout->rb_profile_begin && eop < layout->rb_profile_end;
+	if (delta) {
+		dc_mirror_invalidate (mirror, 0, layout->rb_profile_begin);
+		dc_mirror_invalidate (mirror, layout->rb_freedives_begin, layout->rb_freedives_end);
+		dc_mirror_invalidate_ringbuffer (mirror, layout->rb_profile_begin, layout->rb_profile_end,
+			array_uint16_le (previous), eop);
+	} else {
+		dc_mirror_invalidate (mirror, 0, layout->memsize);
+	}
+
+	// There is no need to download the header again.
+	dc_mirror_update (mirror, 0, data, layout->rb_profile_begin);
+
+	rc = dc_mirror_read (mirror, &progress, 0, data, layout->memsize);
+	if (rc != DC_STATUS_SUCCESS)
+		goto error_free;
+
+	// If the ringbuffer has been overrun since the previous download,
+	// fall back to downloading the entire memory.
+	if (delta && !mares_common_check_profiles (layout, data, array_uint16_le (previous))) {
+		WARNING (abstract->context, "Profile ringbuffer overrun since the last download.");
+		progress.maximum += layout->memsize;
+		device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+		dc_mirror_invalidate (mirror, 0, layout->memsize);
+		dc_mirror_update (mirror, 0, data, layout->rb_profile_begin);
+
+		rc = dc_mirror_read (mirror, &progress, 0, data, layout->memsize);
+		if (rc != DC_STATUS_SUCCESS)
+			goto error_free;
+	}
+
+	rc = dc_mirror_commit (mirror);
+	if (rc != DC_STATUS_SUCCESS) {
+		WARNING (abstract->context, "Failed to save the memory mirror.");
+		rc = DC_STATUS_SUCCESS;
+	}
+
+error_free:
+	dc_mirror_free (mirror);
+	return rc;
+}
+
+
 static dc_status_t
 mares_puck_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
@@ -218,7 +307,13 @@ mares_puck_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, v
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
-	dc_status_t rc = mares_puck_device_dump (abstract, buffer);
+	// With a memory mirror in the store, only the changed memory is
+	// downloaded.
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	if (dc_store_get_flags (abstract->store) & DC_STORE_MIRROR)
+		rc = mares_puck_device_delta (abstract, buffer);
+	else
+		rc = mares_puck_device_dump (abstract, buffer);
 	if (rc != DC_STATUS_SUCCESS) {
 		dc_buffer_free (buffer);
 		return rc;
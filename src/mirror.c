@@ -0,0 +1,258 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mirror.h"
+#include "store-private.h"
+#include "context-private.h"
+#include "device-private.h"
+
+#define INVALID 0
+#define VALID   1
+
+struct dc_mirror_t {
+	dc_device_t *device;
+	unsigned int serial;
+	unsigned int size;
+	unsigned int blocksize;
+	unsigned int nblocks;
+	unsigned char *valid;
+	unsigned char *data;
+};
+
+dc_status_t
+dc_mirror_new (dc_mirror_t **out, dc_device_t *device, unsigned int serial, unsigned int size, unsigned int blocksize)
+{
+	dc_mirror_t *mirror = NULL;
+
+	if (out == NULL || device == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (blocksize == 0) {
+		ERROR (device->context, "Zero length block size!");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Allocate memory.
+	mirror = (dc_mirror_t *) malloc (sizeof (*mirror));
+	if (mirror == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	mirror->device = device;
+	mirror->serial = serial;
+	mirror->size = size;
+	mirror->blocksize = blocksize;
+	mirror->nblocks = (size + blocksize - 1) / blocksize;
+	mirror->valid = (unsigned char *) calloc (mirror->nblocks ? mirror->nblocks : 1, 1);
+	mirror->data = (unsigned char *) malloc (size ? size : 1);
+	if (mirror->valid == NULL || mirror->data == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		free (mirror->data);
+		free (mirror->valid);
+		free (mirror);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Load the previous contents. Failing to load the mirror is not
+	// fatal, because all missing blocks are simply downloaded again.
+	if (device->store) {
+		dc_status_t rc = dc_store_get_mirror (device->store, device->vtable->type,
+			serial, mirror->data, size, blocksize, mirror->valid);
+		if (rc != DC_STATUS_SUCCESS && rc != DC_STATUS_UNSUPPORTED) {
+			WARNING (device->context, "Failed to load the memory mirror.");
+			memset (mirror->valid, INVALID, mirror->nblocks);
+		}
+	}
+
+	*out = mirror;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_mirror_peek (dc_mirror_t *mirror, unsigned int address, unsigned char data[], unsigned int size)
+{
+	if (mirror == NULL || address > mirror->size || size > mirror->size - address)
+		return DC_STATUS_INVALIDARGS;
+
+	if (size == 0)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int first = address / mirror->blocksize;
+	unsigned int last = (address + size - 1) / mirror->blocksize;
+	for (unsigned int i = first; i <= last; ++i) {
+		if (mirror->valid[i] != VALID)
+			return DC_STATUS_UNSUPPORTED;
+	}
+
+	memcpy (data, mirror->data + address, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_mirror_invalidate (dc_mirror_t *mirror, unsigned int begin, unsigned int end)
+{
+	if (mirror == NULL || begin > end || end > mirror->size)
+		return DC_STATUS_INVALIDARGS;
+
+	if (begin == end)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int first = begin / mirror->blocksize;
+	unsigned int last = (end - 1) / mirror->blocksize;
+	for (unsigned int i = first; i <= last; ++i) {
+		mirror->valid[i] = INVALID;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_mirror_invalidate_ringbuffer (dc_mirror_t *mirror, unsigned int begin, unsigned int end, unsigned int first, unsigned int last)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	if (mirror == NULL || begin > end ||
+		first < begin || first > end ||
+		last < begin || last > end)
+		return DC_STATUS_INVALIDARGS;
+
+	if (first <= last) {
+		rc = dc_mirror_invalidate (mirror, first, last);
+	} else {
+		rc = dc_mirror_invalidate (mirror, first, end);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+
+		rc = dc_mirror_invalidate (mirror, begin, last);
+	}
+
+	return rc;
+}
+
+dc_status_t
+dc_mirror_update (dc_mirror_t *mirror, unsigned int address, const unsigned char data[], unsigned int size)
+{
+	if (mirror == NULL || address > mirror->size || size > mirror->size - address)
+		return DC_STATUS_INVALIDARGS;
+
+	memcpy (mirror->data + address, data, size);
+
+	unsigned int first = (address + mirror->blocksize - 1) / mirror->blocksize;
+	for (unsigned int i = first; i < mirror->nblocks; ++i) {
+		unsigned int offset = i * mirror->blocksize;
+		unsigned int len = mirror->size - offset;
+		if (len > mirror->blocksize)
+			len = mirror->blocksize;
+		if (offset + len > address + size)
+			break;
+		mirror->valid[i] = VALID;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_mirror_read (dc_mirror_t *mirror, dc_event_progress_t *progress, unsigned int address, unsigned char data[], unsigned int size)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	if (mirror == NULL || address > mirror->size || size > mirror->size - address)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned int nbytes = 0;
+	while (nbytes < size) {
+		unsigned int idx = (address + nbytes) / mirror->blocksize;
+		unsigned int offset = idx * mirror->blocksize;
+		unsigned int len = mirror->size - offset;
+		if (len > mirror->blocksize)
+			len = mirror->blocksize;
+
+		// Download the block, unless the mirror already contains
+		// an up-to-date copy.
+		if (mirror->valid[idx] != VALID) {
+			rc = dc_device_read (mirror->device, offset, mirror->data + offset, len);
+			if (rc != DC_STATUS_SUCCESS)
+				return rc;
+
+			mirror->valid[idx] = VALID;
+		}
+
+		unsigned int skip = address + nbytes - offset;
+		unsigned int length = len - skip;
+		if (nbytes + length > size)
+			length = size - nbytes;
+
+		memcpy (data + nbytes, mirror->data + address + nbytes, length);
+
+		// Update and emit a progress event.
+		if (progress) {
+			progress->current += length;
+			device_event_emit (mirror->device, DC_EVENT_PROGRESS, progress);
+		}
+
+		nbytes += length;
+	}
+
+	return rc;
+}
+
+dc_status_t
+dc_mirror_commit (dc_mirror_t *mirror)
+{
+	if (mirror == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_device_t *device = mirror->device;
+	if (device->store == NULL)
+		return DC_STATUS_SUCCESS;
+
+	// Only a complete memory image is saved.
+	for (unsigned int i = 0; i < mirror->nblocks; ++i) {
+		if (mirror->valid[i] != VALID)
+			return DC_STATUS_SUCCESS;
+	}
+
+	dc_status_t rc = dc_store_set_mirror (device->store, device->vtable->type,
+		mirror->serial, mirror->data, mirror->size, mirror->blocksize);
+	if (rc == DC_STATUS_UNSUPPORTED)
+		return DC_STATUS_SUCCESS;
+
+	return rc;
+}
+
+dc_status_t
+dc_mirror_free (dc_mirror_t *mirror)
+{
+	if (mirror == NULL)
+		return DC_STATUS_SUCCESS;
+
+	free (mirror->data);
+	free (mirror->valid);
+	free (mirror);
+
+	return DC_STATUS_SUCCESS;
+}
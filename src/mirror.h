@@ -0,0 +1,148 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_MIRROR_H
+#define DC_MIRROR_H
+
+#include <libdivecomputer/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Opaque object representing a memory mirror.
+ *
+ * A memory mirror provides cached access to the memory of a device. The
+ * contents of the previous download are loaded from the store attached
+ * to the device (if any), and only the blocks that are invalidated, or
+ * missing from the mirror, are downloaded again. Without a store, every
+ * block is downloaded, exactly like a regular memory dump.
+ */
+typedef struct dc_mirror_t dc_mirror_t;
+
+/**
+ * Create a new memory mirror.
+ *
+ * @param[out]  mirror     A location to store the memory mirror.
+ * @param[in]   device     A valid device object.
+ * @param[in]   serial     The serial number of the device.
+ * @param[in]   size       The memory size in bytes.
+ * @param[in]   blocksize  The block size in bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_new (dc_mirror_t **mirror, dc_device_t *device, unsigned int serial, unsigned int size, unsigned int blocksize);
+
+/**
+ * Get the previous contents of the memory, without downloading.
+ *
+ * @param[in]  mirror   A valid memory mirror.
+ * @param[in]  address  The memory address.
+ * @param[out] data     The memory buffer to copy the data into.
+ * @param[in]  size     The number of bytes to copy.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if the
+ * data is not available in the mirror, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_peek (dc_mirror_t *mirror, unsigned int address, unsigned char data[], unsigned int size);
+
+/**
+ * Mark a memory range as changed, to force a new download.
+ *
+ * @param[in]  mirror  A valid memory mirror.
+ * @param[in]  begin   The begin address.
+ * @param[in]  end     The end address.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_invalidate (dc_mirror_t *mirror, unsigned int begin, unsigned int end);
+
+/**
+ * Mark a memory range inside a ringbuffer as changed, to force a new
+ * download. The range is allowed to cross the ringbuffer wrap point.
+ *
+ * @param[in]  mirror  A valid memory mirror.
+ * @param[in]  begin   The ringbuffer begin address.
+ * @param[in]  end     The ringbuffer end address.
+ * @param[in]  first   The first address of the range.
+ * @param[in]  last    The last address of the range (exclusive).
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_invalidate_ringbuffer (dc_mirror_t *mirror, unsigned int begin, unsigned int end, unsigned int first, unsigned int last);
+
+/**
+ * Update the memory mirror with data downloaded by the caller. Only the
+ * blocks that are completely covered by the data are updated.
+ *
+ * @param[in]  mirror   A valid memory mirror.
+ * @param[in]  address  The memory address.
+ * @param[in]  data     The downloaded data.
+ * @param[in]  size     The number of bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_update (dc_mirror_t *mirror, unsigned int address, const unsigned char data[], unsigned int size);
+
+/**
+ * Read data through the memory mirror.
+ *
+ * @param[in]  mirror    A valid memory mirror.
+ * @param[in]  progress  An (optional) progress event structure.
+ * @param[in]  address   The memory address.
+ * @param[out] data      The memory buffer to read the data into.
+ * @param[in]  size      The number of bytes to read.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_read (dc_mirror_t *mirror, dc_event_progress_t *progress, unsigned int address, unsigned char data[], unsigned int size);
+
+/**
+ * Save the memory mirror in the store attached to the device.
+ *
+ * @param[in]  mirror  A valid memory mirror.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_commit (dc_mirror_t *mirror);
+
+/**
+ * Destroy the memory mirror.
+ *
+ * @param[in]  mirror  A valid memory mirror.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_mirror_free (dc_mirror_t *mirror);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_MIRROR_H */
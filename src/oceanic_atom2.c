@@ -76,6 +76,8 @@ static const oceanic_common_device_vtable_t oceanic_atom2_device_vtable = {
 		oceanic_atom2_device_write, /* write */
 		oceanic_common_device_dump, /* dump */
 		oceanic_common_device_foreach, /* foreach */
+		oceanic_common_device_headers, /* headers */
+		oceanic_common_device_read_dive, /* read_dive */
 		NULL, /* timesync */
 		oceanic_atom2_device_close /* close */
 	},
@@ -386,6 +386,9 @@ oceanic_atom2_parser_cache (oceanic_atom2_parser_t *parser)
 		return DC_STATUS_SUCCESS;
 	}
 
+	if (LOGBOOK_ONLY (size))
+		return DC_STATUS_UNSUPPORTED;
+
 	// Get the total amount of bytes before and after the profile data.
 	unsigned int headersize = parser->headersize;
 	unsigned int footersize = parser->footersize;
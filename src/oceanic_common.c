@@ -515,23 +515,13 @@ oceanic_common_device_profile (dc_device_t *abstract, dc_event_progress_t *progr
 }
 
 
-dc_status_t
-oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+static dc_status_t
+oceanic_common_device_devinfo (dc_device_t *abstract, dc_event_progress_t *progress)
 {
 	oceanic_common_device_t *device = (oceanic_common_device_t *) abstract;
 
-	assert (device != NULL);
-	assert (device->layout != NULL);
-
 	const oceanic_common_layout_t *layout = device->layout;
 
-	// Enable progress notifications.
-	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
-	progress.maximum = PAGESIZE +
-		(layout->rb_logbook_end - layout->rb_logbook_begin) +
-		(layout->rb_profile_end - layout->rb_profile_begin);
-	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
 	// Emit a vendor event.
 	dc_event_vendor_t vendor;
 	vendor.data = device->version;
@@ -547,8 +537,8 @@ oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 	}
 
 	// Update and emit a progress event.
-	progress.current += PAGESIZE;
-	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+	progress->current += PAGESIZE;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
 
 	// Emit a device info event.
 	dc_event_devinfo_t devinfo;
@@ -565,6 +555,62 @@ oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 			(id[13] & 0x0F) * 10     + ((id[13] & 0xF0) >> 4) * 1;
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+oceanic_common_device_headers_cb (dc_device_t *abstract, dc_buffer_t *logbook, dc_dive_callback_t callback, void *userdata)
+{
+	oceanic_common_device_t *device = (oceanic_common_device_t *) abstract;
+
+	const oceanic_common_layout_t *layout = device->layout;
+
+	// Cache the logbook pointer and size.
+	const unsigned char *logbooks = dc_buffer_get_data (logbook);
+	unsigned int rb_logbook_size = dc_buffer_get_size (logbook);
+
+	// Pass the logbook entries, most recent dives first. The logbook
+	// entry is also used as the fingerprint.
+	unsigned int entry = rb_logbook_size;
+	while (entry) {
+		entry -= layout->rb_logbook_entry_size;
+
+		const unsigned char *p = logbooks + entry;
+		if (callback && !callback (p, layout->rb_logbook_entry_size, p, layout->rb_logbook_entry_size, userdata)) {
+			break;
+		}
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+oceanic_common_device_download (dc_device_t *abstract, unsigned int headers, dc_dive_callback_t callback, void *userdata)
+{
+	oceanic_common_device_t *device = (oceanic_common_device_t *) abstract;
+
+	assert (device != NULL);
+	assert (device->layout != NULL);
+
+	const oceanic_common_layout_t *layout = device->layout;
+
+	// Enable progress notifications. In header only mode, the profile
+	// ringbuffer is not downloaded at all.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = PAGESIZE +
+		(layout->rb_logbook_end - layout->rb_logbook_begin);
+	if (!headers) {
+		progress.maximum += layout->rb_profile_end - layout->rb_profile_begin;
+	}
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Emit the vendor and device info events.
+	dc_status_t rc = oceanic_common_device_devinfo (abstract, &progress);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
 	// Memory buffer for the logbook data.
 	dc_buffer_t *logbook = dc_buffer_new (0);
 	if (logbook == NULL) {
@@ -585,13 +631,193 @@ oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 	}
 
 	// Download the profile ringbuffer.
-	rc = VTABLE(abstract)->profile (abstract, &progress, logbook, callback, userdata);
+	if (headers) {
+		rc = oceanic_common_device_headers_cb (abstract, logbook, callback, userdata);
+	} else {
+		rc = VTABLE(abstract)->profile (abstract, &progress, logbook, callback, userdata);
+	}
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_buffer_free (logbook);
+		return rc;
+	}
+
+	dc_buffer_free (logbook);
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return oceanic_common_device_download (abstract, 0, callback, userdata);
+}
+
+
+dc_status_t
+oceanic_common_device_headers (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return oceanic_common_device_download (abstract, 1, callback, userdata);
+}
+
+
+dc_status_t
+oceanic_common_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	oceanic_common_device_t *device = (oceanic_common_device_t *) abstract;
+
+	assert (device != NULL);
+	assert (device->layout != NULL);
+
+	const oceanic_common_layout_t *layout = device->layout;
+
+	if (size != layout->rb_logbook_entry_size)
+		return DC_STATUS_INVALIDARGS;
+
+	// Enable progress notifications. The size of the profile is only
+	// known after the logbook entry has been located.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = PAGESIZE +
+		(layout->rb_logbook_end - layout->rb_logbook_begin);
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Emit the vendor and device info events.
+	dc_status_t rc = oceanic_common_device_devinfo (abstract, &progress);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Memory buffer for the logbook data.
+	dc_buffer_t *logbook = dc_buffer_new (0);
+	if (logbook == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Download the entire logbook ringbuffer. The fingerprint is
+	// disabled temporarily, because the requested dive can be older
+	// than the most recently downloaded one.
+	unsigned char saved[FPMAXSIZE];
+	memcpy (saved, device->fingerprint, sizeof (saved));
+	memset (device->fingerprint, 0, sizeof (device->fingerprint));
+	rc = VTABLE(abstract)->logbook (abstract, &progress, logbook);
+	memcpy (device->fingerprint, saved, sizeof (saved));
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_buffer_free (logbook);
+		return rc;
+	}
+
+	// Cache the logbook pointer and size.
+	const unsigned char *logbooks = dc_buffer_get_data (logbook);
+	unsigned int rb_logbook_size = dc_buffer_get_size (logbook);
+
+	// Get the pagesize
+	unsigned int pagesize = layout->highmem ? 16 * PAGESIZE : PAGESIZE;
+
+	// Locate the logbook entry. The logbook ringbuffer is traversed
+	// backwards, exactly as during a full download, to verify the
+	// profile of the requested dive has not been overwritten by the
+	// more recent dives yet.
+	unsigned int rb_entry_end = 0, rb_entry_size = 0;
+	unsigned int remaining = layout->rb_profile_end - layout->rb_profile_begin;
+	unsigned int previous = INVALID;
+	unsigned int found = 0;
+	unsigned int entry = rb_logbook_size;
+	while (entry) {
+		// Move to the start of the current entry.
+		entry -= layout->rb_logbook_entry_size;
+
+		// Get the profile pointers.
+		unsigned int rb_entry_first = get_profile_first (logbooks + entry, layout, pagesize);
+		unsigned int rb_entry_last  = get_profile_last (logbooks + entry, layout, pagesize);
+		if (rb_entry_first < layout->rb_profile_begin ||
+			rb_entry_first >= layout->rb_profile_end ||
+			rb_entry_last < layout->rb_profile_begin ||
+			rb_entry_last >= layout->rb_profile_end)
+		{
+			ERROR (abstract->context, "Invalid ringbuffer pointer detected (0x%06x 0x%06x).",
+				rb_entry_first, rb_entry_last);
+			dc_buffer_free (logbook);
+			return DC_STATUS_DATAFORMAT;
+		}
+
+		// Calculate the end pointer and the number of bytes.
+		rb_entry_end   = RB_PROFILE_INCR (rb_entry_last, pagesize, layout);
+		rb_entry_size  = RB_PROFILE_DISTANCE (rb_entry_first, rb_entry_last, layout) + pagesize;
+
+		// Skip gaps between the profiles.
+		unsigned int gap = 0;
+		if (previous != INVALID && rb_entry_end != previous) {
+			WARNING (abstract->context, "Profiles are not continuous.");
+			gap = RB_PROFILE_DISTANCE (rb_entry_end, previous, layout);
+		}
+
+		// Make sure the profile size is valid.
+		if (rb_entry_size + gap > remaining) {
+			ERROR (abstract->context, "Unexpected profile size.");
+			dc_buffer_free (logbook);
+			return DC_STATUS_DATAFORMAT;
+		}
+
+		remaining -= rb_entry_size + gap;
+		previous = rb_entry_first;
+
+		if (memcmp (logbooks + entry, fingerprint, size) == 0) {
+			found = 1;
+			break;
+		}
+	}
+
+	if (!found) {
+		ERROR (abstract->context, "No dive with the requested fingerprint.");
+		dc_buffer_free (logbook);
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Update and emit a progress event.
+	progress.maximum += rb_entry_size;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Create the ringbuffer stream.
+	dc_rbstream_t *rbstream = NULL;
+	rc = dc_rbstream_new (&rbstream, abstract, PAGESIZE, PAGESIZE * device->multipage, layout->rb_profile_begin, layout->rb_profile_end, rb_entry_end);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to create the ringbuffer stream.");
+		dc_buffer_free (logbook);
+		return rc;
+	}
+
+	// Allocate the memory for the logbook entry and the profile.
+	if (!dc_buffer_resize (buffer, layout->rb_logbook_entry_size + rb_entry_size)) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		dc_rbstream_free (rbstream);
+		dc_buffer_free (logbook);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Prepend the logbook entry to the profile data.
+	unsigned char *data = dc_buffer_get_data (buffer);
+	memcpy (data, logbooks + entry, layout->rb_logbook_entry_size);
+
+	// Read the dive.
+	unsigned char *profile = data + layout->rb_logbook_entry_size;
+	rc = dc_rbstream_read (rbstream, &progress, profile, rb_entry_size);
 	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the dive.");
+		dc_rbstream_free (rbstream);
 		dc_buffer_free (logbook);
 		return rc;
 	}
 
+	dc_rbstream_free (rbstream);
 	dc_buffer_free (logbook);
 
+	// Remove padding from the profile.
+	if (layout->highmem) {
+		while (rb_entry_size >= PAGESIZE && array_isequal (profile + rb_entry_size - PAGESIZE, PAGESIZE, 0xFF)) {
+			rb_entry_size -= PAGESIZE;
+		}
+	}
+
+	dc_buffer_slice (buffer, 0, layout->rb_logbook_entry_size + rb_entry_size);
+
 	return DC_STATUS_SUCCESS;
 }
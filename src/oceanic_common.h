@@ -29,6 +29,10 @@ extern "C" {
 #endif /* __cplusplus */
 
 #define PAGESIZE 0x10
+
+// A header only download contains just the logbook entry, which is
+// smaller than the smallest possible dive.
+#define LOGBOOK_ONLY(size) ((size) <= 2 * PAGESIZE)
 #define FPMAXSIZE 0x20
 
 #define OCEANIC_COMMON_MATCH(version,patterns) \
@@ -96,6 +100,12 @@ oceanic_common_device_dump (dc_device_t *abstract, dc_buffer_t *buffer);
 dc_status_t
 oceanic_common_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+dc_status_t
+oceanic_common_device_headers (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+dc_status_t
+oceanic_common_device_read_dive (dc_device_t *device, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -142,6 +142,9 @@ oceanic_veo250_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, un
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
+	if (LOGBOOK_ONLY (size))
+		return DC_STATUS_UNSUPPORTED;
+
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
@@ -196,6 +199,9 @@ oceanic_veo250_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
+	if (LOGBOOK_ONLY (size))
+		return DC_STATUS_UNSUPPORTED;
+
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
@@ -67,6 +67,8 @@ static const oceanic_common_device_vtable_t oceanic_vtpro_device_vtable = {
 		NULL, /* write */
 		oceanic_common_device_dump, /* dump */
 		oceanic_common_device_foreach, /* foreach */
+		oceanic_common_device_headers, /* headers */
+		oceanic_common_device_read_dive, /* read_dive */
 		NULL, /* timesync */
 		oceanic_vtpro_device_close /* close */
 	},
@@ -155,6 +155,9 @@ oceanic_vtpro_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
+	if (LOGBOOK_ONLY (size))
+		return DC_STATUS_UNSUPPORTED;
+
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
@@ -237,6 +240,9 @@ oceanic_vtpro_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
+	if (LOGBOOK_ONLY (size))
+		return DC_STATUS_UNSUPPORTED;
+
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
@@ -22,23 +22,40 @@
 #ifndef PARSER_PRIVATE_H
 #define PARSER_PRIVATE_H
 
+#include <stdarg.h>
+
 #include <libdivecomputer/context.h>
 #include <libdivecomputer/parser.h>
 
+#include "cache-private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
 struct dc_parser_t;
 struct dc_parser_vtable_t;
+struct dc_parser_chunk_t;
 
 typedef struct dc_parser_vtable_t dc_parser_vtable_t;
+typedef struct dc_parser_chunk_t dc_parser_chunk_t;
 
 struct dc_parser_t {
 	const dc_parser_vtable_t *vtable;
 	dc_context_t *context;
 	const unsigned char *data;
 	unsigned int size;
+	/* Parser cache */
+	unsigned int model;
+	unsigned int serial;
+	unsigned int devtime;
+	dc_ticks_t systime;
+	double atmospheric;
+	double hydrostatic;
+	dc_cache_t *cache;
+	dc_cache_record_t *record;
+	/* String arena */
+	dc_parser_chunk_t *arena;
 };
 
 struct dc_parser_vtable_t {
@@ -66,6 +83,36 @@ dc_parser_deallocate (dc_parser_t *parser);
 int
 dc_parser_isinstance (dc_parser_t *parser, const dc_parser_vtable_t *vtable);
 
+/*
+ * Record the calibration of the parser, which is part of the cache key.
+ * A record of the previous calibration is dropped, and the dive data is
+ * passed to the backend again.
+ */
+dc_status_t
+dc_parser_calibrate (dc_parser_t *parser, double atmospheric, double hydrostatic);
+
+/*
+ * String arena
+ *
+ * Strings returned by the parser (e.g. the DC_FIELD_STRING values) are
+ * allocated from a per-parser arena. They remain valid until the next
+ * dc_parser_set_data() call, or until the parser is destroyed. The
+ * arena memory is re-used for the next dive, so in the steady state no
+ * memory is allocated at all.
+ */
+
+const char *
+dc_parser_strdup (dc_parser_t *parser, const char *value);
+
+const char *
+dc_parser_strndup (dc_parser_t *parser, const char *value, size_t length);
+
+const char *
+dc_parser_printf (dc_parser_t *parser, const char *format, ...);
+
+const char *
+dc_parser_vprintf (dc_parser_t *parser, const char *format, va_list ap);
+
 typedef struct sample_statistics_t {
 	unsigned int divetime;
 	double maxdepth;
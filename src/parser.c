@@ -20,6 +20,9 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <assert.h>
 
 #include "suunto_d9.h"
@@ -61,9 +64,21 @@
 #include "context-private.h"
 #include "parser-private.h"
 #include "device-private.h"
+#include "platform.h"
 
 #define REACTPROWHITE 0x4354
 
+#define ARENA_MINSIZE 1024
+#define ARENA_FMTSIZE 256
+
+struct dc_parser_chunk_t {
+	dc_parser_chunk_t *next;
+	size_t size;
+	size_t used;
+};
+
+#define CHUNK_DATA(chunk) ((char *) ((chunk) + 1))
+
 static dc_status_t
 dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t family, unsigned int model, unsigned int serial, unsigned int devtime, dc_ticks_t systime)
 {
@@ -176,6 +191,13 @@ dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t fa
 		return DC_STATUS_INVALIDARGS;
 	}
 
+	if (rc == DC_STATUS_SUCCESS) {
+		parser->model = model;
+		parser->serial = serial;
+		parser->devtime = devtime;
+		parser->systime = systime;
+	}
+
 	*out = parser;
 
 	return rc;
@@ -224,13 +246,99 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 	parser->context = context;
 	parser->data = NULL;
 	parser->size = 0;
+	parser->model = 0;
+	parser->serial = 0;
+	parser->devtime = 0;
+	parser->systime = 0;
+	parser->atmospheric = 0.0;
+	parser->hydrostatic = 0.0;
+	parser->cache = NULL;
+	parser->record = NULL;
+	parser->arena = NULL;
 
 	return parser;
 }
 
+static void
+dc_parser_arena_free (dc_parser_chunk_t *chunk, dc_parser_chunk_t *until)
+{
+	while (chunk != until) {
+		dc_parser_chunk_t *next = chunk->next;
+		free (chunk);
+		chunk = next;
+	}
+}
+
+static dc_parser_chunk_t *
+dc_parser_arena_push (dc_parser_t *parser, size_t size)
+{
+	dc_parser_chunk_t *chunk = (dc_parser_chunk_t *) malloc (sizeof (dc_parser_chunk_t) + size);
+	if (chunk == NULL) {
+		ERROR (parser->context, "Failed to allocate memory.");
+		return NULL;
+	}
+
+	chunk->next = parser->arena;
+	chunk->size = size;
+	chunk->used = 0;
+
+	parser->arena = chunk;
+
+	return chunk;
+}
+
+static void
+dc_parser_arena_reset (dc_parser_t *parser)
+{
+	dc_parser_chunk_t *chunk = parser->arena;
+	size_t size = 0;
+
+	if (chunk == NULL)
+		return;
+
+	if (chunk->next == NULL) {
+		chunk->used = 0;
+		return;
+	}
+
+	// The previous dive didn't fit into a single chunk. Replace all
+	// chunks with a single one that is large enough to hold everything.
+	for (dc_parser_chunk_t *c = chunk; c != NULL; c = c->next) {
+		size += c->size;
+	}
+
+	dc_parser_arena_free (chunk, NULL);
+	parser->arena = NULL;
+
+	dc_parser_arena_push (parser, size);
+}
+
+static char *
+dc_parser_arena_reserve (dc_parser_t *parser, size_t size)
+{
+	dc_parser_chunk_t *chunk = parser->arena;
+
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		size_t n = (chunk ? chunk->size * 2 : ARENA_MINSIZE);
+		while (n < size)
+			n *= 2;
+
+		chunk = dc_parser_arena_push (parser, n);
+		if (chunk == NULL)
+			return NULL;
+	}
+
+	return CHUNK_DATA (chunk) + chunk->used;
+}
+
 void
 dc_parser_deallocate (dc_parser_t *parser)
 {
+	if (parser == NULL)
+		return;
+
+	dc_parser_arena_free (parser->arena, NULL);
+
 	free (parser);
 }
 
@@ -244,6 +352,31 @@ dc_parser_isinstance (dc_parser_t *parser, const dc_parser_vtable_t *vtable)
 }
 
 
+static dc_status_t
+dc_parser_drop_record (dc_parser_t *parser)
+{
+	if (parser->record == NULL)
+		return DC_STATUS_SUCCESS;
+
+	// On a cache hit, the backend never received the dive data. Pass it
+	// again, to stop answering from the state of an earlier dive.
+	dc_cache_record_free (parser->record);
+	parser->record = NULL;
+
+	return parser->vtable->set_data (parser, parser->data, parser->size);
+}
+
+
+dc_status_t
+dc_parser_calibrate (dc_parser_t *parser, double atmospheric, double hydrostatic)
+{
+	parser->atmospheric = atmospheric;
+	parser->hydrostatic = hydrostatic;
+
+	return dc_parser_drop_record (parser);
+}
+
+
 dc_family_t
 dc_parser_get_type (dc_parser_t *parser)
 {
@@ -254,19 +387,55 @@ dc_parser_get_type (dc_parser_t *parser)
 }
 
 
+dc_status_t
+dc_parser_set_cache (dc_parser_t *parser, dc_cache_t *cache)
+{
+	if (parser == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	parser->cache = cache;
+
+	return dc_parser_drop_record (parser);
+}
+
+
 dc_status_t
 dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int size)
 {
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
 	if (parser == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
 	if (parser->vtable->set_data == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
+	dc_cache_record_free (parser->record);
+	parser->record = NULL;
+
+	dc_parser_arena_reset (parser);
+
 	parser->data = data;
 	parser->size = size;
 
-	return parser->vtable->set_data (parser, data, size);
+	// On a cache hit, the dive is not parsed at all. All further
+	// requests are answered from the cache record instead.
+	if (parser->cache && data != NULL &&
+		dc_cache_lookup (parser->cache, parser, data, size, &parser->record) == DC_STATUS_SUCCESS) {
+		return DC_STATUS_SUCCESS;
+	}
+
+	rc = parser->vtable->set_data (parser, data, size);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Failing to update the cache is not fatal. The new record answers
+	// all further requests, exactly as on a cache hit.
+	if (parser->cache && data != NULL) {
+		dc_cache_insert (parser->cache, parser, data, size, &parser->record);
+	}
+
+	return DC_STATUS_SUCCESS;
 }
 
 
@@ -276,6 +445,9 @@ dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime)
 	if (parser == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
+	if (parser->record)
+		return dc_cache_record_get_datetime (parser->record, datetime);
+
 	if (parser->vtable->datetime == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
@@ -288,6 +460,9 @@ dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int fla
 	if (parser == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
+	if (parser->record)
+		return dc_cache_record_get_field (parser->record, type, flags, value);
+
 	if (parser->vtable->field == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
@@ -301,6 +476,9 @@ dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, v
 	if (parser == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
+	if (parser->record)
+		return dc_cache_record_samples_foreach (parser->record, callback, userdata);
+
 	if (parser->vtable->samples_foreach == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
@@ -320,12 +498,87 @@ dc_parser_destroy (dc_parser_t *parser)
 		status = parser->vtable->destroy (parser);
 	}
 
+	dc_cache_record_free (parser->record);
+
 	dc_parser_deallocate (parser);
 
 	return status;
 }
 
 
+const char *
+dc_parser_strndup (dc_parser_t *parser, const char *value, size_t length)
+{
+	char *buffer = dc_parser_arena_reserve (parser, length + 1);
+	if (buffer == NULL)
+		return NULL;
+
+	memcpy (buffer, value, length);
+	buffer[length] = 0;
+
+	parser->arena->used += length + 1;
+
+	return buffer;
+}
+
+const char *
+dc_parser_strdup (dc_parser_t *parser, const char *value)
+{
+	return dc_parser_strndup (parser, value, strlen (value));
+}
+
+const char *
+dc_parser_vprintf (dc_parser_t *parser, const char *format, va_list ap)
+{
+	char *buffer = NULL;
+	size_t available = 0;
+	va_list copy;
+	int n = 0;
+
+	// Format directly into the free space of the current chunk.
+	buffer = dc_parser_arena_reserve (parser, 1);
+	if (buffer == NULL)
+		return NULL;
+	available = parser->arena->size - parser->arena->used;
+
+	va_copy (copy, ap);
+	n = vsnprintf (buffer, available, format, copy);
+	va_end (copy);
+
+	if (n < 0 || (size_t) n >= available) {
+		// Some legacy implementations don't report the required
+		// size. The output is truncated to a fixed size instead.
+		size_t size = (n < 0 ? ARENA_FMTSIZE : (size_t) n + 1);
+
+		buffer = dc_parser_arena_reserve (parser, size);
+		if (buffer == NULL)
+			return NULL;
+
+		va_copy (copy, ap);
+		(void) vsnprintf (buffer, size, format, copy);
+		va_end (copy);
+		buffer[size - 1] = 0;
+		n = strlen (buffer);
+	}
+
+	parser->arena->used += n + 1;
+
+	return buffer;
+}
+
+const char *
+dc_parser_printf (dc_parser_t *parser, const char *format, ...)
+{
+	const char *buffer = NULL;
+	va_list ap;
+
+	va_start (ap, format);
+	buffer = dc_parser_vprintf (parser, format, ap);
+	va_end (ap);
+
+	return buffer;
+}
+
 void
 sample_statistics_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
 {
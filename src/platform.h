@@ -42,6 +42,9 @@ extern "C" {
 // rounding rules for halfway cases are slightly different (away from
 // zero vs to even). But for our use-case, that's not a problem.
 #define rint(x) ((x) >= 0.0 ? floor((x) + 0.5): ceil((x) - 0.5))
+// The va_copy() macro is only available in MSVC 2013 and later
+// versions. On the supported platforms, a va_list is a plain pointer.
+#define va_copy(dst, src) ((dst) = (src))
 #endif
 #endif
 
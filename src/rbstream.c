@@ -23,8 +23,10 @@
 #include <string.h>
 
 #include "rbstream.h"
+#include "checkpoint.h"
 #include "context-private.h"
 #include "device-private.h"
+#include "array.h"
 
 struct dc_rbstream_t {
 	dc_device_t *device;
@@ -35,6 +37,8 @@ struct dc_rbstream_t {
 	unsigned int address;
 	unsigned int available;
 	unsigned int skip;
+	dc_checkpoint_t *checkpoint;
+	unsigned int offset;
 	unsigned char cache[];
 };
 
@@ -99,6 +103,23 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 	rbstream->address = iceil(address, pagesize);
 	rbstream->available = 0;
 	rbstream->skip = rbstream->address - address;
+	rbstream->offset = 0;
+
+	// The packets are recorded in a checkpoint, in the order they are
+	// downloaded. The start address (typically the end of profile
+	// pointer) is part of the key, so an interrupted download is only
+	// resumed if no new dives were recorded in the meantime.
+	unsigned char key[20];
+	array_uint32_le_set (key +  0, pagesize);
+	array_uint32_le_set (key +  4, packetsize);
+	array_uint32_le_set (key +  8, begin);
+	array_uint32_le_set (key + 12, end);
+	array_uint32_le_set (key + 16, address);
+	dc_status_t status = dc_checkpoint_new (&rbstream->checkpoint, device, begin, end - begin, key, sizeof (key));
+	if (status != DC_STATUS_SUCCESS) {
+		free (rbstream);
+		return status;
+	}
 
 	*out = rbstream;
 
@@ -116,6 +137,7 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 	unsigned int address = rbstream->address;
 	unsigned int available = rbstream->available;
 	unsigned int skip = rbstream->skip;
+	unsigned int position = rbstream->offset;
 
 	unsigned int nbytes = 0;
 	unsigned int offset = size;
@@ -133,10 +155,16 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 			// Move to the begin of the current packet.
 			address -= len;
 
-			// Read the packet into the cache.
-			rc = dc_device_read (rbstream->device, address, rbstream->cache, rbstream->packetsize);
-			if (rc != DC_STATUS_SUCCESS)
-				return rc;
+			// Read the packet into the cache, or take it from the
+			// checkpoint of a previous attempt.
+			if (dc_checkpoint_read (rbstream->checkpoint, position, rbstream->cache, rbstream->packetsize) != DC_STATUS_SUCCESS) {
+				rc = dc_device_read (rbstream->device, address, rbstream->cache, rbstream->packetsize);
+				if (rc != DC_STATUS_SUCCESS)
+					return rc;
+
+				dc_checkpoint_update (rbstream->checkpoint, position, rbstream->cache, rbstream->packetsize);
+			}
+			position += rbstream->packetsize;
 
 			available = len - skip;
 			skip = 0;
@@ -163,6 +191,7 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 	rbstream->address = address;
 	rbstream->available = available;
 	rbstream->skip = skip;
+	rbstream->offset = position;
 
 	return rc;
 }
@@ -170,6 +199,10 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 dc_status_t
 dc_rbstream_free (dc_rbstream_t *rbstream)
 {
+	if (rbstream == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_checkpoint_free (rbstream->checkpoint);
 	free (rbstream);
 
 	return DC_STATUS_SUCCESS;
@@ -56,6 +56,8 @@ static const dc_device_vtable_t reefnet_sensus_device_vtable = {
 	NULL, /* write */
 	reefnet_sensus_device_dump, /* dump */
 	reefnet_sensus_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	reefnet_sensus_device_close /* close */
 };
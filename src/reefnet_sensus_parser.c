@@ -119,7 +119,7 @@ reefnet_sensus_parser_set_calibration (dc_parser_t *abstract, double atmospheric
 	parser->atmospheric = atmospheric;
 	parser->hydrostatic = hydrostatic;
 
-	return DC_STATUS_SUCCESS;
+	return dc_parser_calibrate (abstract, atmospheric, hydrostatic);
 }
 
 
@@ -118,7 +118,7 @@ reefnet_sensuspro_parser_set_calibration (dc_parser_t *abstract, double atmosphe
 	parser->atmospheric = atmospheric;
 	parser->hydrostatic = hydrostatic;
 
-	return DC_STATUS_SUCCESS;
+	return dc_parser_calibrate (abstract, atmospheric, hydrostatic);
 }
 
 
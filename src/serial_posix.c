@@ -30,7 +30,6 @@
 #include <fcntl.h>	// fcntl
 #include <termios.h>	// tcgetattr, tcsetattr, cfsetispeed, cfsetospeed, tcflush, tcsendbreak
 #include <sys/ioctl.h>	// ioctl
-#include <time.h>	// nanosleep
 #ifdef HAVE_LINUX_SERIAL_H
 #include <linux/serial.h>
 #endif
@@ -673,11 +672,16 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 	// The absolute target time.
 	dc_usecs_t target = 0;
 
+	// The cancellation pipe interrupts the wait.
+	int cancel = dc_iostream_get_cancel_fd (abstract);
+	int nfds = (cancel > device->fd ? cancel : device->fd) + 1;
+
 	int init = 1;
 	while (nbytes < size) {
 		fd_set fds;
 		FD_ZERO (&fds);
 		FD_SET (device->fd, &fds);
+		FD_SET (cancel, &fds);
 
 		struct timeval tv, *ptv = NULL;
 		if (device->timeout > 0) {
@@ -712,7 +716,7 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 			ptv = &tv;
 		}
 
-		int rc = select (device->fd + 1, &fds, NULL, NULL, ptv);
+		int rc = select (nfds, &fds, NULL, NULL, ptv);
 		if (rc < 0) {
 			int errcode = errno;
 			if (errcode == EINTR)
@@ -722,6 +726,9 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 			goto out;
 		} else if (rc == 0) {
 			break; // Timeout.
+		} else if (FD_ISSET (cancel, &fds)) {
+			status = DC_STATUS_CANCELLED;
+			goto out;
 		}
 
 		ssize_t n = read (device->fd, (char *) data + nbytes, size - nbytes);
@@ -757,12 +764,18 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 	dc_serial_t *device = (dc_serial_t *) abstract;
 	size_t nbytes = 0;
 
+	// The cancellation pipe interrupts the wait.
+	int cancel = dc_iostream_get_cancel_fd (abstract);
+	int nfds = (cancel > device->fd ? cancel : device->fd) + 1;
+
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
+		fd_set rfds, wfds;
+		FD_ZERO (&rfds);
+		FD_ZERO (&wfds);
+		FD_SET (cancel, &rfds);
+		FD_SET (device->fd, &wfds);
 
-		int rc = select (device->fd + 1, NULL, &fds, NULL, NULL);
+		int rc = select (nfds, &rfds, &wfds, NULL, NULL);
 		if (rc < 0) {
 			int errcode = errno;
 			if (errcode == EINTR)
@@ -772,6 +785,9 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 			goto out;
 		} else if (rc == 0) {
 			break; // Timeout.
+		} else if (FD_ISSET (cancel, &rfds)) {
+			status = DC_STATUS_CANCELLED;
+			goto out;
 		}
 
 		ssize_t n = write (device->fd, (const char *) data + nbytes, size - nbytes);
@@ -946,17 +962,5 @@ dc_serial_get_lines (dc_iostream_t *abstract, unsigned int *value)
 static dc_status_t
 dc_serial_sleep (dc_iostream_t *abstract, unsigned int timeout)
 {
-	struct timespec ts;
-	ts.tv_sec  = (timeout / 1000);
-	ts.tv_nsec = (timeout % 1000) * 1000000;
-
-	while (nanosleep (&ts, &ts) != 0) {
-		int errcode = errno;
-		if (errcode != EINTR ) {
-			SYSERROR (abstract->context, errcode);
-			return syserror (errcode);
-		}
-	}
-
-	return DC_STATUS_SUCCESS;
+	return dc_iostream_sleep_cancellable (abstract, timeout);
 }
@@ -0,0 +1,468 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+#include <libdivecomputer/session.h>
+
+#include "device-private.h"
+#include "iostream-private.h"
+#include "context-private.h"
+#include "thread.h"
+
+#define SESSION_DEPTH 8
+
+// Queue entry for a dive, instead of an event.
+#define SESSION_DIVE 0
+
+typedef struct dc_session_message_t {
+	unsigned int type;
+	union {
+		dc_event_progress_t progress;
+		dc_event_devinfo_t devinfo;
+		dc_event_clock_t clock;
+	} event;
+	dc_buffer_t *data;
+	dc_buffer_t *fingerprint;
+} dc_session_message_t;
+
+struct dc_session_t {
+	dc_device_t *device;
+	dc_dive_callback_t callback;
+	void *userdata;
+	// The callbacks of the application, which are replaced while the
+	// download is running.
+	dc_event_callback_t event_callback;
+	void *event_userdata;
+	dc_cancel_callback_t cancel_callback;
+	void *cancel_userdata;
+	// Worker thread.
+	dc_thread_t *thread;
+	dc_mutex_t *mutex;
+	dc_cond_t *notfull;
+	int fd[2];
+	unsigned int signalled;
+	// Bounded queue with the pending events and dives.
+	dc_session_message_t queue[SESSION_DEPTH];
+	unsigned int head, count;
+	unsigned int done, stop, cancelled;
+	dc_status_t status;
+};
+
+#ifndef _WIN32
+static void
+dc_session_wakeup (dc_session_t *session)
+{
+	// The pipe only needs to contain a single byte to become readable.
+	if (session->signalled)
+		return;
+
+	unsigned char byte = 0;
+	if (write (session->fd[1], &byte, 1) == 1)
+		session->signalled = 1;
+}
+
+static void
+dc_session_drain (dc_session_t *session)
+{
+	unsigned char buffer[16];
+	while (read (session->fd[0], buffer, sizeof (buffer)) > 0);
+	session->signalled = 0;
+}
+
+static int
+dc_session_push (dc_session_t *session, unsigned int type, const void *event, const unsigned char data[], unsigned int size, const unsigned char fingerprint[], unsigned int fsize)
+{
+	dc_mutex_lock (session->mutex);
+
+	// Progress events are only a snapshot of the current state. Merge
+	// them with a pending progress event, unless that one is already
+	// being dispatched.
+	if (type == DC_EVENT_PROGRESS && session->count > 1) {
+		dc_session_message_t *last = session->queue + (session->head + session->count - 1) % SESSION_DEPTH;
+		if (last->type == DC_EVENT_PROGRESS) {
+			last->event.progress = *(const dc_event_progress_t *) event;
+			dc_mutex_unlock (session->mutex);
+			return 1;
+		}
+	}
+
+	// Wait for a free slot.
+	while (session->count == SESSION_DEPTH && !session->stop)
+		dc_cond_wait (session->notfull, session->mutex);
+
+	if (session->stop) {
+		dc_mutex_unlock (session->mutex);
+		return 0;
+	}
+
+	// The free slot is not accessed by the dispatch function, so it can
+	// be filled without holding the lock.
+	dc_session_message_t *message = session->queue + (session->head + session->count) % SESSION_DEPTH;
+	dc_mutex_unlock (session->mutex);
+
+	message->type = type;
+	switch (type) {
+	case DC_EVENT_PROGRESS:
+		message->event.progress = *(const dc_event_progress_t *) event;
+		break;
+	case DC_EVENT_DEVINFO:
+		message->event.devinfo = *(const dc_event_devinfo_t *) event;
+		break;
+	case DC_EVENT_CLOCK:
+		message->event.clock = *(const dc_event_clock_t *) event;
+		break;
+	default:
+		break;
+	}
+
+	dc_buffer_clear (message->data);
+	dc_buffer_clear (message->fingerprint);
+	if (!dc_buffer_append (message->data, data, size) ||
+		!dc_buffer_append (message->fingerprint, fingerprint, fsize)) {
+		ERROR (session->device->context, "Failed to allocate memory.");
+		dc_mutex_lock (session->mutex);
+		session->status = DC_STATUS_NOMEMORY;
+		dc_mutex_unlock (session->mutex);
+		return 0;
+	}
+
+	dc_mutex_lock (session->mutex);
+	session->count++;
+	dc_session_wakeup (session);
+	dc_mutex_unlock (session->mutex);
+
+	return 1;
+}
+
+static void
+dc_session_event_cb (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata)
+{
+	dc_session_t *session = (dc_session_t *) userdata;
+
+	if (session->event_callback == NULL)
+		return;
+
+	if (event == DC_EVENT_VENDOR) {
+		const dc_event_vendor_t *vendor = (const dc_event_vendor_t *) data;
+		dc_session_push (session, event, NULL, vendor->data, vendor->size, NULL, 0);
+	} else {
+		dc_session_push (session, event, data, NULL, 0, NULL, 0);
+	}
+}
+
+static int
+dc_session_cancel_cb (void *userdata)
+{
+	dc_session_t *session = (dc_session_t *) userdata;
+
+	dc_mutex_lock (session->mutex);
+	int cancelled = session->cancelled;
+	dc_mutex_unlock (session->mutex);
+
+	if (cancelled)
+		return 1;
+
+	if (session->cancel_callback == NULL)
+		return 0;
+
+	return session->cancel_callback (session->cancel_userdata);
+}
+
+static int
+dc_session_dive_cb (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	dc_session_t *session = (dc_session_t *) userdata;
+
+	return dc_session_push (session, SESSION_DIVE, NULL, data, size, fingerprint, fsize);
+}
+
+static void
+dc_session_run (void *userdata)
+{
+	dc_session_t *session = (dc_session_t *) userdata;
+	dc_device_t *device = session->device;
+
+	dc_status_t status = dc_device_foreach (device, dc_session_dive_cb, session);
+
+	// Restore the callbacks of the application.
+	device->event_callback = session->event_callback;
+	device->event_userdata = session->event_userdata;
+	device->cancel_callback = session->cancel_callback;
+	device->cancel_userdata = session->cancel_userdata;
+
+	dc_mutex_lock (session->mutex);
+	// Resume the I/O stream after a cancelled download, such that the
+	// device remains usable.
+	if (session->cancelled && device->iostream) {
+		dc_iostream_set_cancelled (device->iostream, 0);
+	}
+	if (session->status == DC_STATUS_SUCCESS)
+		session->status = status;
+	session->done = 1;
+	dc_session_wakeup (session);
+	dc_mutex_unlock (session->mutex);
+}
+#endif
+
+dc_status_t
+dc_session_new (dc_session_t **out, dc_device_t *device, dc_dive_callback_t callback, void *userdata)
+{
+#ifdef _WIN32
+	return DC_STATUS_UNSUPPORTED;
+#else
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_session_t *session = NULL;
+
+	if (out == NULL || device == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	session = (dc_session_t *) malloc (sizeof (dc_session_t));
+	if (session == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	memset (session, 0, sizeof (dc_session_t));
+	session->device = device;
+	session->callback = callback;
+	session->userdata = userdata;
+	session->fd[0] = session->fd[1] = -1;
+	session->status = DC_STATUS_SUCCESS;
+
+	status = dc_mutex_new (&session->mutex);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_free;
+
+	status = dc_cond_new (&session->notfull);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_free;
+
+	for (unsigned int i = 0; i < SESSION_DEPTH; ++i) {
+		session->queue[i].data = dc_buffer_new (0);
+		session->queue[i].fingerprint = dc_buffer_new (0);
+		if (session->queue[i].data == NULL || session->queue[i].fingerprint == NULL) {
+			ERROR (device->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_free;
+		}
+	}
+
+	// Both ends of the pipe are non-blocking. The worker thread should
+	// never block on a full pipe, and the application drains the pipe
+	// without knowing how many bytes are available.
+	if (pipe (session->fd) != 0) {
+		SYSERROR (device->context, errno);
+		status = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	for (unsigned int i = 0; i < 2; ++i) {
+		int flags = fcntl (session->fd[i], F_GETFL);
+		if (flags < 0 || fcntl (session->fd[i], F_SETFL, flags | O_NONBLOCK) != 0 ||
+			fcntl (session->fd[i], F_SETFD, FD_CLOEXEC) != 0) {
+			SYSERROR (device->context, errno);
+			status = DC_STATUS_IO;
+			goto error_free;
+		}
+	}
+
+	// Route the events and the cancellation through the session.
+	session->event_callback = device->event_callback;
+	session->event_userdata = device->event_userdata;
+	session->cancel_callback = device->cancel_callback;
+	session->cancel_userdata = device->cancel_userdata;
+	device->event_callback = dc_session_event_cb;
+	device->event_userdata = session;
+	device->cancel_callback = dc_session_cancel_cb;
+	device->cancel_userdata = session;
+
+	status = dc_thread_new (&session->thread, dc_session_run, session);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (device->context, "Failed to create the worker thread.");
+		device->event_callback = session->event_callback;
+		device->event_userdata = session->event_userdata;
+		device->cancel_callback = session->cancel_callback;
+		device->cancel_userdata = session->cancel_userdata;
+		goto error_free;
+	}
+
+	*out = session;
+
+	return DC_STATUS_SUCCESS;
+
+error_free:
+	dc_session_free (session);
+	return status;
+#endif
+}
+
+int
+dc_session_get_fd (dc_session_t *session)
+{
+	if (session == NULL)
+		return -1;
+
+	return session->fd[0];
+}
+
+dc_status_t
+dc_session_dispatch (dc_session_t *session)
+{
+#ifdef _WIN32
+	return DC_STATUS_UNSUPPORTED;
+#else
+	if (session == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_device_t *device = session->device;
+
+	dc_mutex_lock (session->mutex);
+	dc_session_drain (session);
+
+	// Only the messages that are already queued are dispatched. Messages
+	// that arrive while dispatching wake up the event loop again.
+	unsigned int n = session->count;
+	for (unsigned int i = 0; i < n; ++i) {
+		dc_session_message_t *message = session->queue + session->head;
+		unsigned int stop = session->stop;
+		dc_mutex_unlock (session->mutex);
+
+		const unsigned char *data = dc_buffer_get_data (message->data);
+		unsigned int size = dc_buffer_get_size (message->data);
+
+		int proceed = 1;
+		if (message->type == SESSION_DIVE) {
+			// Once the application has stopped the download, the
+			// remaining dives are discarded.
+			if (!stop && session->callback) {
+				proceed = session->callback (data, size,
+					dc_buffer_get_data (message->fingerprint),
+					dc_buffer_get_size (message->fingerprint),
+					session->userdata);
+			}
+		} else if (message->type == DC_EVENT_VENDOR) {
+			dc_event_vendor_t vendor;
+			vendor.data = data;
+			vendor.size = size;
+			session->event_callback (device, DC_EVENT_VENDOR, &vendor, session->event_userdata);
+		} else if (message->type == DC_EVENT_WAITING) {
+			session->event_callback (device, DC_EVENT_WAITING, NULL, session->event_userdata);
+		} else {
+			session->event_callback (device, (dc_event_type_t) message->type, &message->event, session->event_userdata);
+		}
+
+		dc_mutex_lock (session->mutex);
+		if (!proceed)
+			session->stop = 1;
+		session->head = (session->head + 1) % SESSION_DEPTH;
+		session->count--;
+		dc_cond_signal (session->notfull);
+	}
+
+	unsigned int done = session->done && session->count == 0;
+	dc_status_t status = session->status;
+	dc_mutex_unlock (session->mutex);
+
+	if (!done)
+		return DC_STATUS_SUCCESS;
+
+	if (session->thread) {
+		dc_thread_join (session->thread);
+		session->thread = NULL;
+	}
+
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	return DC_STATUS_DONE;
+#endif
+}
+
+dc_status_t
+dc_session_cancel (dc_session_t *session)
+{
+	if (session == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (session->mutex) {
+		dc_mutex_lock (session->mutex);
+		session->cancelled = 1;
+		// Interrupt a blocking I/O operation immediately.
+		if (!session->done) {
+			dc_device_cancel (session->device);
+		}
+		dc_mutex_unlock (session->mutex);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_session_free (dc_session_t *session)
+{
+	if (session == NULL)
+		return DC_STATUS_SUCCESS;
+
+#ifndef _WIN32
+	// Cancel a download that is still running, and discard all pending
+	// messages, such that the worker thread can finish.
+	if (session->thread) {
+		dc_mutex_lock (session->mutex);
+		session->cancelled = 1;
+		session->stop = 1;
+		dc_cond_broadcast (session->notfull);
+		if (!session->done) {
+			dc_device_cancel (session->device);
+		}
+		dc_mutex_unlock (session->mutex);
+
+		dc_thread_join (session->thread);
+	}
+
+	for (unsigned int i = 0; i < 2; ++i) {
+		if (session->fd[i] >= 0)
+			close (session->fd[i]);
+	}
+#endif
+
+	for (unsigned int i = 0; i < SESSION_DEPTH; ++i) {
+		dc_buffer_free (session->queue[i].fingerprint);
+		dc_buffer_free (session->queue[i].data);
+	}
+
+	dc_cond_free (session->notfull);
+	dc_mutex_free (session->mutex);
+	free (session);
+
+	return DC_STATUS_SUCCESS;
+}
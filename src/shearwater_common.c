@@ -25,10 +25,13 @@
 #include "shearwater_common.h"
 
 #include "context-private.h"
+#include "checkpoint.h"
 #include "platform.h"
 #include "array.h"
 
 #define SZ_PACKET  254
+#define SZ_FRAME   32
+#define SZ_ENCODED (2 * (SZ_PACKET + 4) + 1)
 
 // SLIP special character codes
 #define END       0xC0
@@ -42,6 +45,8 @@ shearwater_common_setup (shearwater_common_device_t *device, dc_context_t *conte
 	dc_status_t status = DC_STATUS_SUCCESS;
 
 	device->iostream = iostream;
+	device->available = 0;
+	device->offset = 0;
 
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
@@ -60,6 +65,8 @@ shearwater_common_setup (shearwater_common_device_t *device, dc_context_t *conte
 	// Make sure everything is in a sane state.
 	dc_iostream_sleep (device->iostream, 300);
 	dc_iostream_purge (device->iostream, DC_DIRECTION_ALL);
+	device->available = 0;
+	device->offset = 0;
 
 	return DC_STATUS_SUCCESS;
 }
@@ -75,38 +82,66 @@ shearwater_common_decompress_lre (unsigned char *data, unsigned int size, dc_buf
 	if (nbits % 9 != 0)
 		return -1;
 
-	unsigned int offset = 0;
-	while (offset + 9 <= nbits) {
+	// The 9th bit indicates whether the remaining 8 bits represent
+	// a run of zero bytes or not. If the bit is set, the value is
+	// not a run and doesn’t need expansion. If the bit is not set,
+	// the value contains the number of zero bytes in the run. A
+	// zero-length run indicates the end of the compressed stream.
+	// The first pass calculates the decompressed size, such that the
+	// buffer is only resized once per packet.
+	unsigned int length = 0;
+	unsigned int final = 0;
+	unsigned int end = 0;
+	while (end + 9 <= nbits) {
 		// Extract the 9 bit value.
-		unsigned int byte = offset / 8;
-		unsigned int bit  = offset % 8;
+		unsigned int byte = end / 8;
+		unsigned int bit  = end % 8;
 		unsigned int shift = 16 - (bit + 9);
 		unsigned int value = (array_uint16_be (data + byte) >> shift) & 0x1FF;
 
-		// The 9th bit indicates whether the remaining 8 bits represent
-		// a run of zero bytes or not. If the bit is set, the value is
-		// not a run and doesn’t need expansion. If the bit is not set,
-		// the value contains the number of zero bytes in the run. A
-		// zero-length run indicates the end of the compressed stream.
 		if (value & 0x100) {
-			// Append the data byte directly.
-			unsigned char c = value & 0xFF;
-			if (!dc_buffer_append (buffer, &c, 1))
-				return -1;
+			length++;
 		} else if (value == 0) {
 			// Reached the end of the compressed stream.
-			if (isfinal)
-				*isfinal = 1;
+			final = 1;
 			break;
 		} else {
-			// Expand the run with zero bytes.
-			if (!dc_buffer_resize (buffer, dc_buffer_get_size (buffer) + value))
-				return -1;
+			length += value;
+		}
+
+		end += 9;
+	}
+
+	// Expand the buffer. The new space is zero filled, which takes care
+	// of the runs of zero bytes.
+	size_t previous = dc_buffer_get_size (buffer);
+	if (!dc_buffer_resize (buffer, previous + length))
+		return -1;
+
+	unsigned char *output = dc_buffer_get_data (buffer) + previous;
+
+	unsigned int offset = 0;
+	while (offset < end) {
+		// Extract the 9 bit value.
+		unsigned int byte = offset / 8;
+		unsigned int bit  = offset % 8;
+		unsigned int shift = 16 - (bit + 9);
+		unsigned int value = (array_uint16_be (data + byte) >> shift) & 0x1FF;
+
+		if (value & 0x100) {
+			// Store the data byte directly.
+			*output++ = value & 0xFF;
+		} else {
+			// Skip the run of zero bytes.
+			output += value;
 		}
 
 		offset += 9;
 	}
 
+	if (final && isfinal)
+		*isfinal = 1;
+
 	return 0;
 }
 
@@ -123,95 +158,142 @@ shearwater_common_decompress_xor (unsigned char *data, unsigned int size)
 	return 0;
 }
 
-static dc_status_t
-shearwater_common_slip_write (shearwater_common_device_t *device, const unsigned char data[], unsigned int size)
+static unsigned int
+shearwater_common_slip_span (const unsigned char data[], unsigned int size)
+{
+	// Get the length of the run without any special characters.
+	unsigned int i = 0;
+	while (i < size && data[i] != END && data[i] != ESC)
+		i++;
+
+	return i;
+}
+
+
+static unsigned int
+shearwater_common_slip_encode (const unsigned char data[], unsigned int size, unsigned char output[])
 {
-	dc_status_t status = DC_STATUS_SUCCESS;
-	dc_transport_t transport = dc_iostream_get_transport(device->iostream);
-	unsigned char buffer[32];
 	unsigned int nbytes = 0;
+	unsigned int offset = 0;
 
-	if (transport == DC_TRANSPORT_BLE) {
-		// Calculate the total number of bytes.
-		unsigned int count = 1;
-		for (unsigned int i = 0; i < size; ++i) {
-			unsigned char c = data[i];
-			if (c == END || c == ESC) {
-				count += 2;
-			} else {
-				count++;
-			}
+	while (offset < size) {
+		// Copy the run of regular characters at once.
+		unsigned int n = shearwater_common_slip_span (data + offset, size - offset);
+		memcpy (output + nbytes, data + offset, n);
+		nbytes += n;
+		offset += n;
+
+		if (offset < size) {
+			// Escape the special character.
+			output[nbytes++] = ESC;
+			output[nbytes++] = (data[offset] == END ? ESC_END : ESC_ESC);
+			offset++;
 		}
+	}
 
-		// Calculate the total number of frames.
-		unsigned int nframes = (count + sizeof(buffer) - 1) / sizeof(buffer);
+	// Append the END character to indicate the end of the packet.
+	output[nbytes++] = END;
 
-		buffer[0] = nframes;
-		buffer[1] = 0;
-		nbytes = 2;
-	}
+	return nbytes;
+}
 
-	for (unsigned int i = 0; i < size; ++i) {
-		unsigned char c = data[i];
 
-		if (c == END || c == ESC) {
-			// Append the escape character.
-			buffer[nbytes++] = ESC;
+static dc_status_t
+shearwater_common_slip_write (shearwater_common_device_t *device, const unsigned char data[], unsigned int size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_transport_t transport = dc_iostream_get_transport(device->iostream);
+	unsigned char buffer[SZ_ENCODED];
 
-			// Flush the buffer if necessary.
-			if (nbytes >= sizeof(buffer)) {
-				status = dc_iostream_write (device->iostream, buffer, nbytes, NULL);
-				if (status != DC_STATUS_SUCCESS) {
-					ERROR (device->base.context, "Failed to send the packet.");
-					return status;
-				}
+	if (size > SZ_PACKET + 4)
+		return DC_STATUS_INVALIDARGS;
 
-				if (transport == DC_TRANSPORT_BLE) {
-					buffer[1]++;
-					nbytes = 2;
-				} else {
-					nbytes = 0;
-				}
-			}
+	// Encode the entire packet.
+	unsigned int length = shearwater_common_slip_encode (data, size, buffer);
 
-			// Escape the character.
-			if (c == END) {
-				c = ESC_END;
-			} else {
-				c = ESC_ESC;
-			}
+	if (transport != DC_TRANSPORT_BLE) {
+		// Send the packet with a single write.
+		status = dc_iostream_write (device->iostream, buffer, length, NULL);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (device->base.context, "Failed to send the packet.");
+			return status;
 		}
 
-		// Append the character.
-		buffer[nbytes++] = c;
+		return DC_STATUS_SUCCESS;
+	}
+
+	// With BLE, the packet is split into frames, each starting with a
+	// two byte header containing the number of frames and the frame
+	// index. Note that the number of frames is calculated without taking
+	// the headers into account.
+	unsigned int nframes = (length + SZ_FRAME - 1) / SZ_FRAME;
+	unsigned int count = (length + SZ_FRAME - 2 - 1) / (SZ_FRAME - 2);
+	unsigned char frame[SZ_FRAME];
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int len = SZ_FRAME - 2;
+		if (offset + len > length)
+			len = length - offset;
 
-		// Flush the buffer if necessary.
-		if (nbytes >= sizeof(buffer)) {
-			status = dc_iostream_write (device->iostream, buffer, nbytes, NULL);
-			if (status != DC_STATUS_SUCCESS) {
-				ERROR (device->base.context, "Failed to send the packet.");
-				return status;
-			}
+		frame[0] = nframes;
+		frame[1] = i;
+		memcpy (frame + 2, buffer + offset, len);
 
-			if (transport == DC_TRANSPORT_BLE) {
-				buffer[1]++;
-				nbytes = 2;
-			} else {
-				nbytes = 0;
-			}
+		status = dc_iostream_write (device->iostream, frame, len + 2, NULL);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (device->base.context, "Failed to send the packet.");
+			return status;
 		}
+
+		offset += len;
 	}
 
-	// Append the END character to indicate the end of the packet.
-	buffer[nbytes++] = END;
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+shearwater_common_slip_fill (shearwater_common_device_t *device)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_transport_t transport = dc_iostream_get_transport(device->iostream);
 
-	// Flush the buffer.
-	status = dc_iostream_write (device->iostream, buffer, nbytes, NULL);
+	// Read at least a single byte, and everything that is already
+	// available. Any data beyond the end of the packet remains in the
+	// cache for the next packet. With BLE, every read returns exactly
+	// one frame.
+	size_t length = 1;
+	if (transport == DC_TRANSPORT_BLE) {
+		length = sizeof(device->cache);
+	} else {
+		size_t available = 0;
+		status = dc_iostream_get_available (device->iostream, &available);
+		if (status == DC_STATUS_SUCCESS && available > length)
+			length = available;
+		if (length > sizeof(device->cache))
+			length = sizeof(device->cache);
+	}
+
+	size_t transferred = 0;
+	status = dc_iostream_read (device->iostream, device->cache, length, &transferred);
 	if (status != DC_STATUS_SUCCESS) {
-		ERROR (device->base.context, "Failed to send the packet.");
+		ERROR (device->base.context, "Failed to receive the packet.");
 		return status;
 	}
 
+	size_t offset = 0;
+	if (transport == DC_TRANSPORT_BLE) {
+		if (transferred < 2) {
+			ERROR (device->base.context, "Invalid packet length (" DC_PRINTF_SIZE ").", transferred);
+			return DC_STATUS_PROTOCOL;
+		}
+
+		offset = 2;
+	}
+
+	device->available = transferred - offset;
+	device->offset = offset;
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -220,44 +302,46 @@ static dc_status_t
 shearwater_common_slip_read (shearwater_common_device_t *device, unsigned char data[], unsigned int size, unsigned int *actual)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
-	dc_transport_t transport = dc_iostream_get_transport(device->iostream);
-	unsigned char buffer[256];
 	unsigned int escaped = 0;
 	unsigned int nbytes = 0;
 
-	// Get the packet size.
-	size_t packetsize = (transport == DC_TRANSPORT_BLE) ? sizeof(buffer) : 1;
-
 	// Read bytes until a complete packet has been received. If the
 	// buffer runs out of space, bytes are dropped. The caller can
 	// detect this condition because the return value will be larger
 	// than the supplied buffer size.
 	while (1) {
-		size_t transferred = 0;
-		status = dc_iostream_read (device->iostream, buffer, packetsize, &transferred);
-		if (status != DC_STATUS_SUCCESS) {
-			ERROR (device->base.context, "Failed to receive the packet.");
-			return status;
+		if (device->available == 0) {
+			status = shearwater_common_slip_fill (device);
+			if (status != DC_STATUS_SUCCESS)
+				return status;
 		}
 
-		size_t offset = 0;
-		if (transport == DC_TRANSPORT_BLE) {
-			if (transferred < 2) {
-				ERROR (device->base.context, "Invalid packet length (" DC_PRINTF_SIZE ").", transferred);
-				return DC_STATUS_PROTOCOL;
+		const unsigned char *p = device->cache + device->offset;
+		unsigned int n = device->available;
+		unsigned int i = 0;
+
+		while (i < n) {
+			if (!escaped) {
+				// Copy the run of regular characters at once.
+				unsigned int len = shearwater_common_slip_span (p + i, n - i);
+				if (nbytes < size) {
+					unsigned int count = (nbytes + len > size ? size - nbytes : len);
+					memcpy (data + nbytes, p + i, count);
+				}
+				nbytes += len;
+				i += len;
+				if (i == n)
+					break;
 			}
 
-			offset = 2;
-		}
-
-		for (size_t i = offset; i < transferred; ++i) {
-			unsigned char c = buffer[i];
+			unsigned char c = p[i++];
 
 			if (c == END || c == ESC) {
 				if (escaped) {
 					// If the END or ESC characters are escaped, then we
 					// have a protocol violation, and an error is reported.
 					ERROR (device->base.context, "SLIP frame escaped the special character %02x.", c);
+					device->available = 0;
 					return DC_STATUS_PROTOCOL;
 				}
 
@@ -268,6 +352,8 @@ shearwater_common_slip_read (shearwater_common_device_t *device, unsigned char d
 					// packets generated by the duplicate END characters which
 					// are sent to try to detect line noise.
 					if (nbytes) {
+						device->offset += i;
+						device->available -= i;
 						goto done;
 					}
 				} else {
@@ -279,28 +365,28 @@ shearwater_common_slip_read (shearwater_common_device_t *device, unsigned char d
 				continue;
 			}
 
-			if (escaped) {
-				// If it's not one of the two escaped characters, then we
-				// have a protocol violation. The best bet seems to be to
-				// leave the byte alone and just stuff it into the packet.
-				switch (c) {
-				case ESC_END:
-					c = END;
-					break;
-				case ESC_ESC:
-					c = ESC;
-					break;
-				default:
-					break;
-				}
-
-				escaped = 0;
+			// If it's not one of the two escaped characters, then we
+			// have a protocol violation. The best bet seems to be to
+			// leave the byte alone and just stuff it into the packet.
+			switch (c) {
+			case ESC_END:
+				c = END;
+				break;
+			case ESC_ESC:
+				c = ESC;
+				break;
+			default:
+				break;
 			}
 
+			escaped = 0;
+
 			if (nbytes < size)
 				data[nbytes] = c;
 			nbytes++;
 		}
+
+		device->available = 0;
 	}
 
 done:
@@ -380,8 +466,8 @@ shearwater_common_transfer (shearwater_common_device_t *device, const unsigned c
 }
 
 
-dc_status_t
-shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buffer, unsigned int address, unsigned int size, unsigned int compression, dc_event_progress_t *progress)
+static dc_status_t
+shearwater_common_download_begin (shearwater_common_device_t *device, unsigned int address, unsigned int size, unsigned int compression)
 {
 	dc_device_t *abstract = (dc_device_t *) device;
 	dc_status_t rc = DC_STATUS_SUCCESS;
@@ -398,10 +484,61 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		(size >> 16) & 0xFF,
 		(size >>  8) & 0xFF,
 		(size      ) & 0xFF};
-	unsigned char req_block[] = {0x36, 0x00};
+	unsigned char response[SZ_PACKET];
+
+	// Transfer the init request.
+	rc = shearwater_common_transfer (device, req_init, sizeof (req_init), response, 3, &n);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// Verify the init response.
+	if (n != 3 || response[0] != 0x75 || response[1] != 0x10 || response[2] > SZ_PACKET) {
+		ERROR (abstract->context, "Unexpected response packet.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+shearwater_common_download_end (shearwater_common_device_t *device)
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	unsigned int n = 0;
+
 	unsigned char req_quit[] = {0x37};
 	unsigned char response[SZ_PACKET];
 
+	// Transfer the quit request.
+	rc = shearwater_common_transfer (device, req_quit, sizeof (req_quit), response, 2, &n);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// Verify the quit response.
+	if (n != 2 || response[0] != 0x77 || response[1] != 0x00) {
+		ERROR (abstract->context, "Unexpected response packet.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buffer, unsigned int address, unsigned int size, unsigned int compression, unsigned int resume, dc_event_progress_t *progress)
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_checkpoint_t *checkpoint = NULL;
+	unsigned int n = 0;
+
+	unsigned char req_block[] = {0x36, 0x00};
+	unsigned char response[SZ_PACKET];
+
 	// Erase the current contents of the buffer.
 	if (!dc_buffer_clear (buffer)) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
@@ -415,18 +552,11 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
 	}
 
-	// Transfer the init request.
-	rc = shearwater_common_transfer (device, req_init, sizeof (req_init), response, 3, &n);
+	rc = shearwater_common_download_begin (device, address, size, compression);
 	if (rc != DC_STATUS_SUCCESS) {
 		return rc;
 	}
 
-	// Verify the init response.
-	if (n != 3 || response[0] != 0x75 || response[1] != 0x10 || response[2] > SZ_PACKET) {
-		ERROR (abstract->context, "Unexpected response packet.");
-		return DC_STATUS_PROTOCOL;
-	}
-
 	// Update and emit a progress event.
 	if (progress) {
 		current += 3;
@@ -442,20 +572,22 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		req_block[1] = block;
 		rc = shearwater_common_transfer (device, req_block, sizeof (req_block), response, sizeof (response), &n);
 		if (rc != DC_STATUS_SUCCESS) {
-			return rc;
+			goto error_free;
 		}
 
 		// Verify the block header.
 		if (n < 2 || response[0] != 0x76 || response[1] != block) {
 			ERROR (abstract->context, "Unexpected response packet.");
-			return DC_STATUS_PROTOCOL;
+			rc = DC_STATUS_PROTOCOL;
+			goto error_free;
 		}
 
 		// Verify the block length.
 		unsigned int length = n - 2;
 		if (nbytes + length > size) {
 			ERROR (abstract->context, "Unexpected packet size.");
-			return DC_STATUS_PROTOCOL;
+			rc = DC_STATUS_PROTOCOL;
+			goto error_free;
 		}
 
 		// Update and emit a progress event.
@@ -468,36 +600,81 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		if (compression) {
 			if (shearwater_common_decompress_lre (response + 2, length, buffer, &done) != 0) {
 				ERROR (abstract->context, "Decompression error (LRE phase).");
-				return DC_STATUS_PROTOCOL;
+				rc = DC_STATUS_PROTOCOL;
+				goto error_free;
 			}
 		} else {
 			if (!dc_buffer_append (buffer, response + 2, length)) {
 				ERROR (abstract->context, "Insufficient buffer space available.");
-				return DC_STATUS_PROTOCOL;
+				rc = DC_STATUS_PROTOCOL;
+				goto error_free;
 			}
+
+			// Uncompressed data can be resumed at any offset. The first
+			// block serves as the snapshot of the device state for the
+			// checkpoint. That is only correct if any change to the data
+			// also changes the first block. The caller decides.
+			if (resume && checkpoint == NULL) {
+				rc = dc_checkpoint_new (&checkpoint, abstract, address, size, response + 2, length);
+				if (rc != DC_STATUS_SUCCESS)
+					goto error_free;
+			}
+
+			dc_checkpoint_update (checkpoint, nbytes, response + 2, length);
 		}
 
 		nbytes += length;
 		block++;
+
+		// Skip the data of a previous attempt.
+		unsigned int available = dc_checkpoint_available (checkpoint);
+		if (!compression && available > nbytes) {
+			if (available > size)
+				available = size;
+
+			// Restart at the end of the available data. If everything is
+			// available, the quit request after the loop ends the transfer.
+			if (available < size) {
+				rc = shearwater_common_download_end (device);
+				if (rc != DC_STATUS_SUCCESS)
+					goto error_free;
+
+				rc = shearwater_common_download_begin (device, address + available, size - available, compression);
+				if (rc != DC_STATUS_SUCCESS)
+					goto error_free;
+			}
+
+			if (!dc_buffer_resize (buffer, available)) {
+				ERROR (abstract->context, "Insufficient buffer space available.");
+				rc = DC_STATUS_NOMEMORY;
+				goto error_free;
+			}
+
+			dc_checkpoint_read (checkpoint, nbytes, dc_buffer_get_data (buffer) + nbytes, available - nbytes);
+
+			// Update and emit a progress event.
+			if (progress) {
+				current += available - nbytes;
+				progress->current = initial + STEP (current, maximum);
+				device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
+			}
+
+			nbytes = available;
+			block = 1;
+		}
 	}
 
 	if (compression) {
 		if (shearwater_common_decompress_xor (dc_buffer_get_data (buffer), dc_buffer_get_size (buffer)) != 0) {
 			ERROR (abstract->context, "Decompression error (XOR phase).");
-			return DC_STATUS_PROTOCOL;
+			rc = DC_STATUS_PROTOCOL;
+			goto error_free;
 		}
 	}
 
-	// Transfer the quit request.
-	rc = shearwater_common_transfer (device, req_quit, sizeof (req_quit), response, 2, &n);
+	rc = shearwater_common_download_end (device);
 	if (rc != DC_STATUS_SUCCESS) {
-		return rc;
-	}
-
-	// Verify the quit response.
-	if (n != 2 || response[0] != 0x77 || response[1] != 0x00) {
-		ERROR (abstract->context, "Unexpected response packet.");
-		return DC_STATUS_PROTOCOL;
+		goto error_free;
 	}
 
 	// Update and emit a progress event.
@@ -507,7 +684,9 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
 	}
 
-	return DC_STATUS_SUCCESS;
+error_free:
+	dc_checkpoint_free (checkpoint);
+	return rc;
 }
 
 
@@ -46,6 +46,8 @@ typedef struct shearwater_petrel_device_t {
 
 static dc_status_t shearwater_petrel_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size);
 static dc_status_t shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t shearwater_petrel_device_headers (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t shearwater_petrel_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
 static dc_status_t shearwater_petrel_device_close (dc_device_t *abstract);
 
 static const dc_device_vtable_t shearwater_petrel_device_vtable = {
@@ -56,6 +58,8 @@ static const dc_device_vtable_t shearwater_petrel_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	shearwater_petrel_device_foreach, /* foreach */
+	shearwater_petrel_device_headers, /* headers */
+	shearwater_petrel_device_read_dive, /* read_dive */
 	NULL, /* timesync */
 	shearwater_petrel_device_close /* close */
 };
@@ -147,32 +151,15 @@ shearwater_petrel_device_set_fingerprint (dc_device_t *abstract, const unsigned
 
 
 static dc_status_t
-shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+shearwater_petrel_device_devinfo (dc_device_t *abstract, dc_buffer_t *buffer)
 {
 	shearwater_petrel_device_t *device = (shearwater_petrel_device_t *) abstract;
 	dc_status_t rc = DC_STATUS_SUCCESS;
 
-	// Allocate memory buffers for the manifests.
-	dc_buffer_t *buffer = dc_buffer_new (MANIFEST_SIZE);
-	dc_buffer_t *manifests = dc_buffer_new (MANIFEST_SIZE);
-	if (buffer == NULL || manifests == NULL) {
-		ERROR (abstract->context, "Insufficient buffer space available.");
-		dc_buffer_free (buffer);
-		dc_buffer_free (manifests);
-		return DC_STATUS_NOMEMORY;
-	}
-
-	// Enable progress notifications.
-	unsigned int current = 0, maximum = 0;
-	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
-	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
-
 	// Read the serial number.
 	rc = shearwater_common_identifier (&device->base, buffer, ID_SERIAL);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to read the serial number.");
-		dc_buffer_free (buffer);
-		dc_buffer_free (manifests);
 		return rc;
 	}
 
@@ -181,8 +168,6 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	if (array_convert_hex2bin (dc_buffer_get_data (buffer), dc_buffer_get_size (buffer),
 		serial, sizeof (serial)) != 0 ) {
 		ERROR (abstract->context, "Failed to convert the serial number.");
-		dc_buffer_free (buffer);
-		dc_buffer_free (manifests);
 		return DC_STATUS_DATAFORMAT;
 
 	}
@@ -191,8 +176,6 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	rc = shearwater_common_identifier (&device->base, buffer, ID_FIRMWARE);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to read the firmware version.");
-		dc_buffer_free (buffer);
-		dc_buffer_free (manifests);
 		return rc;
 	}
 
@@ -203,8 +186,6 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	rc = shearwater_common_identifier (&device->base, buffer, ID_HARDWARE);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to read the hardware type.");
-		dc_buffer_free (buffer);
-		dc_buffer_free (manifests);
 		return rc;
 	}
 
@@ -252,17 +233,50 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	devinfo.serial = array_uint32_be (serial);
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+shearwater_petrel_device_download (dc_device_t *abstract, unsigned int headers, dc_dive_callback_t callback, void *userdata)
+{
+	shearwater_petrel_device_t *device = (shearwater_petrel_device_t *) abstract;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	// Allocate memory buffers for the manifests.
+	dc_buffer_t *buffer = dc_buffer_new (MANIFEST_SIZE);
+	dc_buffer_t *manifests = dc_buffer_new (MANIFEST_SIZE);
+	if (buffer == NULL || manifests == NULL) {
+		ERROR (abstract->context, "Insufficient buffer space available.");
+		dc_buffer_free (buffer);
+		dc_buffer_free (manifests);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	// Enable progress notifications.
+	unsigned int current = 0, maximum = 0;
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Emit a device info event.
+	rc = shearwater_petrel_device_devinfo (abstract, buffer);
+	if (rc != DC_STATUS_SUCCESS) {
+		dc_buffer_free (buffer);
+		dc_buffer_free (manifests);
+		return rc;
+	}
+
 	while (1) {
 		// Update the progress state.
 		// Assume the worst case scenario of a full manifest, and adjust the
 		// value with the actual number of dives after the manifest has been
-		// processed.
-		maximum += 1 + RECORD_COUNT;
+		// processed. In header only mode, the dives are not downloaded.
+		maximum += 1 + (headers ? 0 : RECORD_COUNT);
 
 		// Download a manifest.
 		progress.current = NSTEPS * current;
 		progress.maximum = NSTEPS * maximum;
-		rc = shearwater_common_download (&device->base, buffer, MANIFEST_ADDR, MANIFEST_SIZE, 0, &progress);
+		rc = shearwater_common_download (&device->base, buffer, MANIFEST_ADDR, MANIFEST_SIZE, 0, 1, &progress);
 		if (rc != DC_STATUS_SUCCESS) {
 			ERROR (abstract->context, "Failed to download the manifest.");
 			dc_buffer_free (buffer);
@@ -293,7 +307,8 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 
 		// Update the progress state.
 		current += 1;
-		maximum -= RECORD_COUNT - count;
+		if (!headers)
+			maximum -= RECORD_COUNT - count;
 
 		// Append the manifest records to the main buffer.
 		if (!dc_buffer_append (manifests, data, count * RECORD_SIZE)) {
@@ -319,13 +334,24 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 
 	unsigned int offset = 0;
 	while (offset < size) {
+		// Pass the manifest record, which contains the same
+		// fingerprint as the dive itself.
+		if (headers) {
+			unsigned char *record = data + offset;
+			if (callback && !callback (record, RECORD_SIZE, record + 4, sizeof (device->fingerprint), userdata))
+				break;
+
+			offset += RECORD_SIZE;
+			continue;
+		}
+
 		// Get the address of the dive.
 		unsigned int address = array_uint32_be (data + offset + 20);
 
 		// Download the dive.
 		progress.current = NSTEPS * current;
 		progress.maximum = NSTEPS * maximum;
-		rc = shearwater_common_download (&device->base, buffer, DIVE_ADDR + address, DIVE_SIZE, 1, &progress);
+		rc = shearwater_common_download (&device->base, buffer, DIVE_ADDR + address, DIVE_SIZE, 1, 0, &progress);
 		if (rc != DC_STATUS_SUCCESS) {
 			ERROR (abstract->context, "Failed to download the dive.");
 			dc_buffer_free (buffer);
@@ -354,3 +380,114 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 
 	return rc;
 }
+
+
+static dc_status_t
+shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return shearwater_petrel_device_download (abstract, 0, callback, userdata);
+}
+
+
+static dc_status_t
+shearwater_petrel_device_headers (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return shearwater_petrel_device_download (abstract, 1, callback, userdata);
+}
+
+
+static dc_status_t
+shearwater_petrel_device_read_dive (dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	shearwater_petrel_device_t *device = (shearwater_petrel_device_t *) abstract;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	if (size != sizeof (device->fingerprint))
+		return DC_STATUS_INVALIDARGS;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	// Emit a device info event.
+	rc = shearwater_petrel_device_devinfo (abstract, buffer);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// Search the manifests for the dive with the matching fingerprint.
+	// The manifest record contains the address of the dive, so only the
+	// requested dive needs to be downloaded.
+	unsigned int address = 0, found = 0;
+	unsigned int current = 0, maximum = 0;
+	while (!found) {
+		// Update the progress state. Assume the dive is located in the
+		// next manifest.
+		maximum += 2;
+
+		// Download a manifest.
+		progress.current = NSTEPS * current;
+		progress.maximum = NSTEPS * maximum;
+		rc = shearwater_common_download (&device->base, buffer, MANIFEST_ADDR, MANIFEST_SIZE, 0, 1, &progress);
+		if (rc != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to download the manifest.");
+			return rc;
+		}
+
+		// Cache the buffer pointer and size.
+		const unsigned char *data = dc_buffer_get_data (buffer);
+		unsigned int length = dc_buffer_get_size (buffer);
+
+		// Process the records in the manifest.
+		unsigned int count = 0;
+		unsigned int offset = 0;
+		while (offset < length) {
+			// Check for a valid dive header.
+			unsigned int header = array_uint16_be (data + offset);
+			if (header != 0xA5C4)
+				break;
+
+			// Check the fingerprint data.
+			if (memcmp (data + offset + 4, fingerprint, size) == 0) {
+				address = array_uint32_be (data + offset + 20);
+				found = 1;
+				break;
+			}
+
+			offset += RECORD_SIZE;
+			count++;
+		}
+
+		// Update the progress state.
+		current += 1;
+		maximum -= 1;
+
+		// Stop downloading manifest if there are no more records.
+		if (!found && count != RECORD_COUNT)
+			break;
+	}
+
+	if (!found) {
+		ERROR (abstract->context, "No dive with the requested fingerprint.");
+		dc_buffer_clear (buffer);
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Download the dive.
+	maximum += 1;
+	progress.current = NSTEPS * current;
+	progress.maximum = NSTEPS * maximum;
+	rc = shearwater_common_download (&device->base, buffer, DIVE_ADDR + address, DIVE_SIZE, 1, 0, &progress);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to download the dive.");
+		return rc;
+	}
+
+	// Update and emit a progress event.
+	current += 1;
+	progress.current = NSTEPS * current;
+	progress.maximum = NSTEPS * maximum;
+	device_event_emit (abstract, DC_EVENT_PROGRESS, &progress);
+
+	return DC_STATUS_SUCCESS;
+}
@@ -53,6 +53,8 @@ static const dc_device_vtable_t shearwater_predator_device_vtable = {
 	NULL, /* write */
 	shearwater_predator_device_dump, /* dump */
 	shearwater_predator_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -128,7 +130,10 @@ shearwater_predator_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 	progress.current = 0;
 	progress.maximum = NSTEPS;
 
-	return shearwater_common_download (device, buffer, 0xDD000000, SZ_MEMORY, 0, &progress);
+	// The first block doesn't capture the state of the profile ringbuffer,
+	// and the rest of the memory can change without it. Therefore an
+	// interrupted dump is never resumed.
+	return shearwater_common_download (device, buffer, 0xDD000000, SZ_MEMORY, 0, 0, &progress);
 }
 
 
@@ -41,6 +41,7 @@
 	dc_parser_isinstance((parser), &shearwater_petrel_parser_vtable))
 
 #define SZ_BLOCK   0x80
+#define SZ_MANIFEST 0x20
 #define SZ_SAMPLE_PREDATOR  0x10
 #define SZ_SAMPLE_PETREL    0x20
 
@@ -56,6 +57,11 @@
 #define NGASMIXES 10
 #define MAXSTRINGS 32
 
+#define MANIFEST_HEADER 0xA5C4
+
+// A manifest record, as returned by a header only download.
+#define ISMANIFEST(data,size) ((size) == SZ_MANIFEST && array_uint16_be (data) == MANIFEST_HEADER)
+
 #define PREDATOR 2
 #define PETREL   3
 
@@ -220,11 +226,18 @@ shearwater_predator_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *d
 {
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
+	unsigned int ticks = 0;
 
-	if (size < 2 * SZ_BLOCK)
-		return DC_STATUS_DATAFORMAT;
+	if (ISMANIFEST (data, size)) {
+		// The manifest record contains the same timestamp as the
+		// opening record of the dive.
+		ticks = array_uint32_be (data + 4);
+	} else {
+		if (size < 2 * SZ_BLOCK)
+			return DC_STATUS_DATAFORMAT;
 
-	unsigned int ticks = array_uint32_be (data + 12);
+		ticks = array_uint32_be (data + 12);
+	}
 
 	if (!dc_datetime_gmtime (datetime, ticks))
 		return DC_STATUS_DATAFORMAT;
@@ -239,18 +252,24 @@ shearwater_predator_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *d
  * library rather than copied for all the dive computers.
  *
  * This is just copied from the EON Steel code.
+ *
+ * The value is not copied. It's either a string constant, or
+ * a string that was formatted into the parser string arena.
  */
 static void
 add_string(shearwater_predator_parser_t *parser, const char *desc, const char *value)
 {
 	int i;
 
+	if (!value)
+		return;
+
 	for (i = 0; i < MAXSTRINGS; i++) {
 		dc_field_string_t *str = parser->strings+i;
 		if (str->desc)
 			continue;
 		str->desc = desc;
-		str->value = strdup(value);
+		str->value = value;
 		break;
 	}
 }
@@ -258,22 +277,11 @@ add_string(shearwater_predator_parser_t *parser, const char *desc, const char *v
 static void
 add_string_fmt(shearwater_predator_parser_t *parser, const char *desc, const char *fmt, ...)
 {
-	char buffer[256];
 	va_list ap;
 
-	/*
-	 * We ignore the return value from vsnprintf, and we
-	 * always NUL-terminate the destination buffer ourselves.
-	 *
-	 * That way we don't have to worry about random bad legacy
-	 * implementations.
-	 */
 	va_start(ap, fmt);
-	buffer[sizeof(buffer)-1] = 0;
-	(void) vsnprintf(buffer, sizeof(buffer)-1, fmt, ap);
+	add_string(parser, desc, dc_parser_vprintf(&parser->base, fmt, ap));
 	va_end(ap);
-
-	return add_string(parser, desc, buffer);
 }
 
 // The Battery state is a big-endian word:
@@ -386,6 +394,11 @@ shearwater_predator_parser_cache (shearwater_predator_parser_t *parser)
 		return DC_STATUS_SUCCESS;
 	}
 
+	// A manifest record contains no other dive data.
+	if (ISMANIFEST (data, size)) {
+		return DC_STATUS_UNSUPPORTED;
+	}
+
 	unsigned int headersize = SZ_BLOCK;
 	unsigned int footersize = SZ_BLOCK;
 	if (size < headersize + footersize) {
@@ -193,10 +193,20 @@ dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 	dc_socket_t *socket = (dc_socket_t *) abstract;
 	size_t nbytes = 0;
 
+	// The cancellation pipe interrupts the wait. Windows can only wait
+	// for sockets, and checks for cancellation between the operations.
+	int cancel = dc_iostream_get_cancel_fd (abstract);
+	int nfds = (int) socket->fd + 1;
+	if (cancel >= nfds)
+		nfds = cancel + 1;
+
 	while (nbytes < size) {
 		fd_set fds;
 		FD_ZERO (&fds);
 		FD_SET (socket->fd, &fds);
+#ifndef _WIN32
+		FD_SET (cancel, &fds);
+#endif
 
 		struct timeval tvt;
 		if (socket->timeout > 0) {
@@ -206,7 +216,7 @@ dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 			timerclear (&tvt);
 		}
 
-		int rc = select (socket->fd + 1, &fds, NULL, NULL, socket->timeout >= 0 ? &tvt : NULL);
+		int rc = select (nfds, &fds, NULL, NULL, socket->timeout >= 0 ? &tvt : NULL);
 		if (rc < 0) {
 			s_errcode_t errcode = S_ERRNO;
 			if (errcode == S_EINTR)
@@ -217,6 +227,12 @@ dc_socket_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 		} else if (rc == 0) {
 			break; // Timeout.
 		}
+#ifndef _WIN32
+		if (FD_ISSET (cancel, &fds)) {
+			status = DC_STATUS_CANCELLED;
+			goto out;
+		}
+#endif
 
 		s_ssize_t n = recv (socket->fd, (char *) data + nbytes, size - nbytes, 0);
 		if (n < 0) {
@@ -251,12 +267,22 @@ dc_socket_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 	dc_socket_t *socket = (dc_socket_t *) abstract;
 	size_t nbytes = 0;
 
+	// The cancellation pipe interrupts the wait.
+	int cancel = dc_iostream_get_cancel_fd (abstract);
+	int nfds = (int) socket->fd + 1;
+	if (cancel >= nfds)
+		nfds = cancel + 1;
+
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (socket->fd, &fds);
+		fd_set rfds, wfds;
+		FD_ZERO (&rfds);
+		FD_ZERO (&wfds);
+		FD_SET (socket->fd, &wfds);
+#ifndef _WIN32
+		FD_SET (cancel, &rfds);
+#endif
 
-		int rc = select (socket->fd + 1, NULL, &fds, NULL, NULL);
+		int rc = select (nfds, &rfds, &wfds, NULL, NULL);
 		if (rc < 0) {
 			s_errcode_t errcode = S_ERRNO;
 			if (errcode == S_EINTR)
@@ -267,6 +293,12 @@ dc_socket_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 		} else if (rc == 0) {
 			break; // Timeout.
 		}
+#ifndef _WIN32
+		if (FD_ISSET (cancel, &rfds)) {
+			status = DC_STATUS_CANCELLED;
+			goto out;
+		}
+#endif
 
 		s_ssize_t n = send (socket->fd, (const char *) data + nbytes, size - nbytes, 0);
 		if (n < 0) {
@@ -297,21 +329,5 @@ out:
 dc_status_t
 dc_socket_sleep (dc_iostream_t *abstract, unsigned int timeout)
 {
-#ifdef _WIN32
-	Sleep (timeout);
-#else
-	struct timespec ts;
-	ts.tv_sec  = (timeout / 1000);
-	ts.tv_nsec = (timeout % 1000) * 1000000;
-
-	while (nanosleep (&ts, &ts) != 0) {
-		int errcode = errno;
-		if (errcode != EINTR ) {
-			SYSERROR (abstract->context, errcode);
-			return dc_socket_syserror (errcode);
-		}
-	}
-#endif
-
-	return DC_STATUS_SUCCESS;
+	return dc_iostream_sleep_cancellable (abstract, timeout);
 }
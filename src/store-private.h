@@ -0,0 +1,82 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_STORE_PRIVATE_H
+#define DC_STORE_PRIVATE_H
+
+#include <libdivecomputer/store.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Magic number of the files with cached data, shared by the checkpoint
+ * files of the store and the parser cache.
+ */
+#define DC_STORE_MAGIC_CACHE 0x31434344 /* "DCC1" */
+
+/*
+ * Get the flags the store was opened with.
+ */
+unsigned int
+dc_store_get_flags (dc_store_t *store);
+
+/*
+ * Load the memory mirror of a device. The per-block checksums are
+ * verified, and only the blocks with a valid checksum are copied into
+ * the data buffer and marked in the valid array (one byte per block).
+ */
+dc_status_t
+dc_store_get_mirror (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned char data[], unsigned int size, unsigned int blocksize, unsigned char valid[]);
+
+/*
+ * Replace the memory mirror of a device.
+ */
+dc_status_t
+dc_store_set_mirror (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size, unsigned int blocksize);
+
+/*
+ * Get the data of an interrupted transfer. A transfer is identified by
+ * its address range, and a key with a snapshot of the device state (e.g.
+ * the ringbuffer pointers) at the time of the transfer. If there is no
+ * checkpoint with a matching range and key, the data buffer is empty.
+ */
+dc_status_t
+dc_store_get_checkpoint (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize, dc_buffer_t *data);
+
+/*
+ * Record the data received so far by a transfer. An older checkpoint for
+ * the same address range is replaced.
+ */
+dc_status_t
+dc_store_set_checkpoint (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize, const unsigned char data[], unsigned int dsize);
+
+/*
+ * Remove all checkpoints of a device.
+ */
+dc_status_t
+dc_store_clear_checkpoints (dc_store_t *store, dc_family_t family, unsigned int serial);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_STORE_PRIVATE_H */
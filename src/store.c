@@ -0,0 +1,1071 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#define NOGDI
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "store-private.h"
+#include "context-private.h"
+#include "checksum.h"
+#include "array.h"
+#include "platform.h"
+#include "thread.h"
+
+#define MAGIC        0x31534344 /* "DCS1" */
+#define MAGIC_MIRROR 0x314D4344 /* "DCM1" */
+#define MAGIC_CHECKPOINT DC_STORE_MAGIC_CACHE
+
+#define SZ_HEADER        28
+#define SZ_HEADER_MIRROR 20
+#define SZ_HEADER_CHECKPOINT 16
+#define SZ_CHECKPOINT    16
+
+#define MAX_CHECKPOINTS 4
+
+typedef unsigned long long dc_store_hash_t;
+
+typedef struct dc_store_checkpoint_t {
+	unsigned int address;
+	unsigned int size;
+	dc_buffer_t *key;
+	dc_buffer_t *data;
+} dc_store_checkpoint_t;
+
+typedef struct dc_store_entry_t {
+	dc_family_t family;
+	unsigned int serial;
+	unsigned int loaded;
+	unsigned int dirty;
+	dc_buffer_t *fingerprint;
+	unsigned int devtime;
+	dc_ticks_t systime;
+	dc_store_hash_t *hashes;
+	size_t nhashes, capacity;
+	// Checkpoints of interrupted transfers, oldest first.
+	dc_store_checkpoint_t checkpoints[MAX_CHECKPOINTS];
+	unsigned int ncheckpoints;
+	unsigned int checkpoints_dirty;
+} dc_store_entry_t;
+
+struct dc_store_t {
+	dc_context_t *context;
+	char *directory;
+	unsigned int flags;
+	dc_store_entry_t entry;
+	// Serializes the access to the entry. The pipelined download updates
+	// the store from its worker thread, while the transfer thread keeps
+	// reading and writing checkpoints. Without thread support there is no
+	// pipelining, and the mutex is not needed.
+	dc_mutex_t *mutex;
+};
+
+static void
+dc_store_lock (dc_store_t *store)
+{
+	if (store->mutex)
+		dc_mutex_lock (store->mutex);
+}
+
+static void
+dc_store_unlock (dc_store_t *store)
+{
+	if (store->mutex)
+		dc_mutex_unlock (store->mutex);
+}
+
+static void
+dc_store_entry_reset (dc_store_entry_t *entry)
+{
+	dc_buffer_clear (entry->fingerprint);
+	entry->loaded = 0;
+	entry->dirty = 0;
+	entry->devtime = 0;
+	entry->systime = 0;
+	entry->nhashes = 0;
+	entry->ncheckpoints = 0;
+	entry->checkpoints_dirty = 0;
+}
+
+static int
+dc_store_filename (dc_store_t *store, dc_family_t family, unsigned int serial, const char *extension, char filename[], size_t size)
+{
+	int n = snprintf (filename, size, "%s/%08X-%08X.%s",
+		store->directory, family, serial, extension);
+	if (n < 0 || (size_t) n >= size)
+		return -1;
+
+	return 0;
+}
+
+static dc_status_t
+dc_store_load (dc_store_t *store, const char *filename, dc_buffer_t *buffer)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	FILE *fp = NULL;
+
+	fp = fopen (filename, "rb");
+	if (fp == NULL) {
+		// A missing file is not an error. It simply means there is no
+		// state available yet.
+		return DC_STATUS_SUCCESS;
+	}
+
+	unsigned char block[1024];
+	size_t nbytes = 0;
+	while ((nbytes = fread (block, 1, sizeof (block), fp)) > 0) {
+		if (!dc_buffer_append (buffer, block, nbytes)) {
+			ERROR (store->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			break;
+		}
+	}
+
+	fclose (fp);
+
+	return status;
+}
+
+static dc_status_t
+dc_store_replace (dc_store_t *store, const char *filename, const unsigned char data[], size_t size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	FILE *fp = NULL;
+	char tmpname[1024];
+
+	int n = snprintf (tmpname, sizeof (tmpname), "%s.tmp", filename);
+	if (n < 0 || (size_t) n >= sizeof (tmpname)) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Write the new contents to a temporary file first, and flush it all
+	// the way to the disk. Only then the temporary file is moved over the
+	// original file. Because the rename is atomic, a crash will leave
+	// either the old or the new file behind, but never a partial one.
+	fp = fopen (tmpname, "wb");
+	if (fp == NULL) {
+		SYSERROR (store->context, errno);
+		return DC_STATUS_IO;
+	}
+
+	if (fwrite (data, 1, size, fp) != size || fflush (fp) != 0) {
+		SYSERROR (store->context, errno);
+		status = DC_STATUS_IO;
+		fclose (fp);
+		goto error_remove;
+	}
+
+#ifdef _WIN32
+	if (_commit (_fileno (fp)) != 0) {
+#else
+	if (fsync (fileno (fp)) != 0) {
+#endif
+		SYSERROR (store->context, errno);
+		status = DC_STATUS_IO;
+		fclose (fp);
+		goto error_remove;
+	}
+
+	if (fclose (fp) != 0) {
+		SYSERROR (store->context, errno);
+		status = DC_STATUS_IO;
+		goto error_remove;
+	}
+
+#ifdef _WIN32
+	if (!MoveFileExA (tmpname, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		SYSERROR (store->context, GetLastError ());
+#else
+	if (rename (tmpname, filename) != 0) {
+		SYSERROR (store->context, errno);
+#endif
+		status = DC_STATUS_IO;
+		goto error_remove;
+	}
+
+	return DC_STATUS_SUCCESS;
+
+error_remove:
+	remove (tmpname);
+	return status;
+}
+
+static dc_status_t
+dc_store_checkpoint_assign (dc_store_t *store, dc_store_checkpoint_t *checkpoint, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize, const unsigned char data[], unsigned int dsize)
+{
+	if (checkpoint->key == NULL)
+		checkpoint->key = dc_buffer_new (ksize);
+	if (checkpoint->data == NULL)
+		checkpoint->data = dc_buffer_new (dsize);
+	if (checkpoint->key == NULL || checkpoint->data == NULL) {
+		ERROR (store->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	dc_buffer_clear (checkpoint->key);
+	dc_buffer_clear (checkpoint->data);
+	if (!dc_buffer_append (checkpoint->key, key, ksize) ||
+		!dc_buffer_append (checkpoint->data, data, dsize)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	checkpoint->address = address;
+	checkpoint->size = size;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_store_read_checkpoints (dc_store_t *store, dc_store_entry_t *entry)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (dc_store_filename (store, entry->family, entry->serial, "ckp", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	buffer = dc_buffer_new (0);
+	if (buffer == NULL) {
+		ERROR (store->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	status = dc_store_load (store, filename, buffer);
+	if (status != DC_STATUS_SUCCESS || dc_buffer_get_size (buffer) == 0)
+		goto error_free;
+
+	const unsigned char *data = dc_buffer_get_data (buffer);
+	size_t size = dc_buffer_get_size (buffer);
+
+	// A corrupt or mismatching file is ignored. The transfers are simply
+	// started from the beginning again.
+	if (size < SZ_HEADER_CHECKPOINT + 4 ||
+		array_uint32_le (data) != MAGIC_CHECKPOINT ||
+		array_uint32_le (data + 4) != entry->family ||
+		array_uint32_le (data + 8) != entry->serial ||
+		array_uint32_le (data + size - 4) != checksum_crc32 (data, size - 4)) {
+		WARNING (store->context, "Ignoring corrupt checkpoint file '%s'.", filename);
+		goto error_free;
+	}
+
+	unsigned int count = array_uint32_le (data + 12);
+	if (count > MAX_CHECKPOINTS)
+		count = MAX_CHECKPOINTS;
+
+	size_t offset = SZ_HEADER_CHECKPOINT;
+	for (unsigned int i = 0; i < count; ++i) {
+		if (offset + SZ_CHECKPOINT > size - 4)
+			break;
+
+		unsigned int address = array_uint32_le (data + offset + 0);
+		unsigned int length = array_uint32_le (data + offset + 4);
+		unsigned int ksize = array_uint32_le (data + offset + 8);
+		unsigned int dsize = array_uint32_le (data + offset + 12);
+		offset += SZ_CHECKPOINT;
+
+		if (ksize > size - 4 - offset || dsize > size - 4 - offset - ksize) {
+			WARNING (store->context, "Ignoring corrupt checkpoint file '%s'.", filename);
+			break;
+		}
+
+		status = dc_store_checkpoint_assign (store, &entry->checkpoints[entry->ncheckpoints],
+			address, length, data + offset, ksize, data + offset + ksize, dsize);
+		if (status != DC_STATUS_SUCCESS)
+			break;
+
+		entry->ncheckpoints++;
+		offset += ksize + dsize;
+	}
+
+error_free:
+	dc_buffer_free (buffer);
+	return status;
+}
+
+static dc_status_t
+dc_store_write_checkpoints (dc_store_t *store, dc_store_entry_t *entry)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (dc_store_filename (store, entry->family, entry->serial, "ckp", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Without any checkpoints, the file is no longer needed.
+	if (entry->ncheckpoints == 0) {
+		remove (filename);
+		entry->checkpoints_dirty = 0;
+		return DC_STATUS_SUCCESS;
+	}
+
+	size_t size = SZ_HEADER_CHECKPOINT + 4;
+	for (unsigned int i = 0; i < entry->ncheckpoints; ++i) {
+		size += SZ_CHECKPOINT +
+			dc_buffer_get_size (entry->checkpoints[i].key) +
+			dc_buffer_get_size (entry->checkpoints[i].data);
+	}
+
+	buffer = dc_buffer_new (size);
+	if (buffer == NULL || !dc_buffer_resize (buffer, size)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		dc_buffer_free (buffer);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data (buffer);
+	array_uint32_le_set (data +  0, MAGIC_CHECKPOINT);
+	array_uint32_le_set (data +  4, entry->family);
+	array_uint32_le_set (data +  8, entry->serial);
+	array_uint32_le_set (data + 12, entry->ncheckpoints);
+
+	unsigned char *p = data + SZ_HEADER_CHECKPOINT;
+	for (unsigned int i = 0; i < entry->ncheckpoints; ++i) {
+		const dc_store_checkpoint_t *checkpoint = &entry->checkpoints[i];
+		unsigned int ksize = dc_buffer_get_size (checkpoint->key);
+		unsigned int dsize = dc_buffer_get_size (checkpoint->data);
+		array_uint32_le_set (p +  0, checkpoint->address);
+		array_uint32_le_set (p +  4, checkpoint->size);
+		array_uint32_le_set (p +  8, ksize);
+		array_uint32_le_set (p + 12, dsize);
+		p += SZ_CHECKPOINT;
+		if (ksize) {
+			memcpy (p, dc_buffer_get_data (checkpoint->key), ksize);
+		}
+		p += ksize;
+		if (dsize) {
+			memcpy (p, dc_buffer_get_data (checkpoint->data), dsize);
+		}
+		p += dsize;
+	}
+	array_uint32_le_set (data + size - 4, checksum_crc32 (data, size - 4));
+
+	status = dc_store_replace (store, filename, data, size);
+	if (status == DC_STATUS_SUCCESS)
+		entry->checkpoints_dirty = 0;
+
+	dc_buffer_free (buffer);
+
+	return status;
+}
+
+static dc_status_t
+dc_store_read (dc_store_t *store, dc_store_entry_t *entry)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (dc_store_filename (store, entry->family, entry->serial, "bin", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	buffer = dc_buffer_new (0);
+	if (buffer == NULL) {
+		ERROR (store->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	status = dc_store_load (store, filename, buffer);
+	if (status != DC_STATUS_SUCCESS || dc_buffer_get_size (buffer) == 0)
+		goto error_free;
+
+	const unsigned char *data = dc_buffer_get_data (buffer);
+	size_t size = dc_buffer_get_size (buffer);
+
+	// Verify the header and the checksum. A corrupt file is ignored, and
+	// will be replaced on the next update.
+	if (size < SZ_HEADER + 8 ||
+		array_uint32_le (data) != MAGIC ||
+		array_uint32_le (data + size - 4) != checksum_crc32 (data, size - 4)) {
+		WARNING (store->context, "Ignoring corrupt store file '%s'.", filename);
+		goto error_free;
+	}
+
+	// The sizes are checked against the remaining length, to avoid an
+	// overflow in the size arithmetic.
+	unsigned int fsize = array_uint32_le (data + 24);
+	if (fsize > size - SZ_HEADER - 8) {
+		WARNING (store->context, "Ignoring corrupt store file '%s'.", filename);
+		goto error_free;
+	}
+
+	unsigned int nhashes = array_uint32_le (data + SZ_HEADER + fsize);
+	if (nhashes > (size - SZ_HEADER - fsize - 8) / 8 ||
+		SZ_HEADER + fsize + 8 + (size_t) nhashes * 8 != size) {
+		WARNING (store->context, "Ignoring corrupt store file '%s'.", filename);
+		goto error_free;
+	}
+
+	if (array_uint32_le (data + 4) != entry->family ||
+		array_uint32_le (data + 8) != entry->serial) {
+		WARNING (store->context, "Ignoring mismatching store file '%s'.", filename);
+		goto error_free;
+	}
+
+	if (nhashes > entry->capacity) {
+		dc_store_hash_t *hashes = (dc_store_hash_t *) realloc (entry->hashes, nhashes * sizeof (dc_store_hash_t));
+		if (hashes == NULL) {
+			ERROR (store->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_free;
+		}
+		entry->hashes = hashes;
+		entry->capacity = nhashes;
+	}
+
+	if (!dc_buffer_append (entry->fingerprint, data + SZ_HEADER, fsize)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	entry->devtime = array_uint32_le (data + 12);
+	entry->systime = (dc_ticks_t) (array_uint32_le (data + 16) |
+		((unsigned long long) array_uint32_le (data + 20) << 32));
+
+	const unsigned char *p = data + SZ_HEADER + fsize + 4;
+	for (unsigned int i = 0; i < nhashes; ++i) {
+		entry->hashes[i] = array_uint32_le (p + i * 8) |
+			((dc_store_hash_t) array_uint32_le (p + i * 8 + 4) << 32);
+	}
+	entry->nhashes = nhashes;
+
+error_free:
+	dc_buffer_free (buffer);
+	return status;
+}
+
+static dc_status_t
+dc_store_write (dc_store_t *store, dc_store_entry_t *entry)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (dc_store_filename (store, entry->family, entry->serial, "bin", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	unsigned int fsize = dc_buffer_get_size (entry->fingerprint);
+	size_t size = SZ_HEADER + fsize + 4 + entry->nhashes * 8 + 4;
+
+	buffer = dc_buffer_new (size);
+	if (buffer == NULL || !dc_buffer_resize (buffer, size)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		dc_buffer_free (buffer);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data (buffer);
+	unsigned long long systime = (unsigned long long) entry->systime;
+	array_uint32_le_set (data +  0, MAGIC);
+	array_uint32_le_set (data +  4, entry->family);
+	array_uint32_le_set (data +  8, entry->serial);
+	array_uint32_le_set (data + 12, entry->devtime);
+	array_uint32_le_set (data + 16, systime & 0xFFFFFFFF);
+	array_uint32_le_set (data + 20, (systime >> 32) & 0xFFFFFFFF);
+	array_uint32_le_set (data + 24, fsize);
+	if (fsize) {
+		memcpy (data + SZ_HEADER, dc_buffer_get_data (entry->fingerprint), fsize);
+	}
+	unsigned char *p = data + SZ_HEADER + fsize;
+	array_uint32_le_set (p, entry->nhashes);
+	p += 4;
+	for (size_t i = 0; i < entry->nhashes; ++i) {
+		array_uint32_le_set (p + i * 8 + 0, entry->hashes[i] & 0xFFFFFFFF);
+		array_uint32_le_set (p + i * 8 + 4, (entry->hashes[i] >> 32) & 0xFFFFFFFF);
+	}
+	array_uint32_le_set (data + size - 4, checksum_crc32 (data, size - 4));
+
+	status = dc_store_replace (store, filename, data, size);
+	if (status == DC_STATUS_SUCCESS && entry->checkpoints_dirty)
+		status = dc_store_write_checkpoints (store, entry);
+	if (status == DC_STATUS_SUCCESS)
+		entry->dirty = 0;
+
+	dc_buffer_free (buffer);
+
+	return status;
+}
+
+static dc_status_t
+dc_store_select (dc_store_t *store, dc_family_t family, unsigned int serial)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_store_entry_t *entry = &store->entry;
+
+	if (entry->loaded && entry->family == family && entry->serial == serial)
+		return DC_STATUS_SUCCESS;
+
+	// Write the pending changes of the previous device.
+	if (entry->loaded && entry->dirty) {
+		status = dc_store_write (store, entry);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+	}
+
+	dc_store_entry_reset (entry);
+	entry->family = family;
+	entry->serial = serial;
+
+	status = dc_store_read (store, entry);
+	if (status == DC_STATUS_SUCCESS && (store->flags & DC_STORE_CHECKPOINT))
+		status = dc_store_read_checkpoints (store, entry);
+	if (status != DC_STATUS_SUCCESS) {
+		dc_store_entry_reset (entry);
+		return status;
+	}
+
+	entry->loaded = 1;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_store_open (dc_store_t **out, dc_context_t *context, const char *directory, unsigned int flags)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_store_t *store = NULL;
+
+	if (out == NULL || directory == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	store = (dc_store_t *) malloc (sizeof (dc_store_t));
+	if (store == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	store->context = context;
+	store->flags = flags;
+	store->mutex = NULL;
+	memset (&store->entry, 0, sizeof (store->entry));
+
+	store->directory = (char *) malloc (strlen (directory) + 1);
+	store->entry.fingerprint = dc_buffer_new (0);
+	if (store->directory == NULL || store->entry.fingerprint == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		dc_buffer_free (store->entry.fingerprint);
+		free (store->directory);
+		free (store);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	strcpy (store->directory, directory);
+
+	status = dc_mutex_new (&store->mutex);
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+		ERROR (context, "Failed to create the mutex.");
+		dc_buffer_free (store->entry.fingerprint);
+		free (store->directory);
+		free (store);
+		return status;
+	}
+
+	*out = store;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_store_sync (dc_store_t *store)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_store_lock (store);
+	if (store->entry.loaded && store->entry.dirty)
+		status = dc_store_write (store, &store->entry);
+	dc_store_unlock (store);
+
+	return status;
+}
+
+dc_status_t
+dc_store_close (dc_store_t *store)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL)
+		return DC_STATUS_SUCCESS;
+
+	status = dc_store_sync (store);
+
+	for (unsigned int i = 0; i < MAX_CHECKPOINTS; ++i) {
+		dc_buffer_free (store->entry.checkpoints[i].key);
+		dc_buffer_free (store->entry.checkpoints[i].data);
+	}
+	dc_buffer_free (store->entry.fingerprint);
+	free (store->entry.hashes);
+	dc_mutex_free (store->mutex);
+	free (store->directory);
+	free (store);
+
+	return status;
+}
+
+dc_status_t
+dc_store_get_fingerprint (dc_store_t *store, dc_family_t family, unsigned int serial, dc_buffer_t *fingerprint)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL || fingerprint == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	dc_buffer_clear (fingerprint);
+	if (!dc_buffer_append (fingerprint,
+		dc_buffer_get_data (store->entry.fingerprint),
+		dc_buffer_get_size (store->entry.fingerprint))) {
+		ERROR (store->context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_unlock;
+	}
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+dc_status_t
+dc_store_set_fingerprint (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL || (data == NULL && size != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	dc_buffer_clear (store->entry.fingerprint);
+	if (!dc_buffer_append (store->entry.fingerprint, data, size)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_unlock;
+	}
+
+	store->entry.dirty = 1;
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+dc_status_t
+dc_store_get_clock (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int *devtime, dc_ticks_t *systime)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	if (devtime)
+		*devtime = store->entry.devtime;
+	if (systime)
+		*systime = store->entry.systime;
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+dc_status_t
+dc_store_set_clock (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int devtime, dc_ticks_t systime)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	store->entry.devtime = devtime;
+	store->entry.systime = systime;
+	store->entry.dirty = 1;
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+static int
+dc_store_find_hash (dc_store_entry_t *entry, dc_store_hash_t hash)
+{
+	for (size_t i = 0; i < entry->nhashes; ++i) {
+		if (entry->hashes[i] == hash)
+			return 1;
+	}
+
+	return 0;
+}
+
+int
+dc_store_has_dive (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size)
+{
+	int found = 0;
+
+	if (store == NULL || (store->flags & DC_STORE_HASHES) == 0)
+		return 0;
+
+	dc_store_hash_t hash = checksum_fnv1a64 (data, size, CHECKSUM_FNV1A64_INIT);
+
+	dc_store_lock (store);
+	if (dc_store_select (store, family, serial) == DC_STATUS_SUCCESS)
+		found = dc_store_find_hash (&store->entry, hash);
+	dc_store_unlock (store);
+
+	return found;
+}
+
+dc_status_t
+dc_store_add_dive (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL || (data == NULL && size != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_HASHES) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_store_hash_t hash = checksum_fnv1a64 (data, size, CHECKSUM_FNV1A64_INIT);
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	dc_store_entry_t *entry = &store->entry;
+	if (dc_store_find_hash (entry, hash))
+		goto error_unlock;
+
+	if (entry->nhashes >= entry->capacity) {
+		size_t capacity = entry->capacity ? entry->capacity * 2 : 64;
+		dc_store_hash_t *hashes = (dc_store_hash_t *) realloc (entry->hashes, capacity * sizeof (dc_store_hash_t));
+		if (hashes == NULL) {
+			ERROR (store->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_unlock;
+		}
+		entry->hashes = hashes;
+		entry->capacity = capacity;
+	}
+
+	entry->hashes[entry->nhashes++] = hash;
+	entry->dirty = 1;
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+unsigned int
+dc_store_get_flags (dc_store_t *store)
+{
+	if (store == NULL)
+		return 0;
+
+	return store->flags;
+}
+
+dc_status_t
+dc_store_get_mirror (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned char data[], unsigned int size, unsigned int blocksize, unsigned char valid[])
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (store == NULL || blocksize == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_MIRROR) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	unsigned int nblocks = (size + blocksize - 1) / blocksize;
+	memset (valid, 0, nblocks);
+
+	if (dc_store_filename (store, family, serial, "dmp", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	buffer = dc_buffer_new (0);
+	if (buffer == NULL) {
+		ERROR (store->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	status = dc_store_load (store, filename, buffer);
+	if (status != DC_STATUS_SUCCESS || dc_buffer_get_size (buffer) == 0)
+		goto error_free;
+
+	const unsigned char *p = dc_buffer_get_data (buffer);
+
+	// A mirror with a different layout is useless, and simply ignored.
+	if (dc_buffer_get_size (buffer) != SZ_HEADER_MIRROR + nblocks * 4 + size ||
+		array_uint32_le (p +  0) != MAGIC_MIRROR ||
+		array_uint32_le (p +  4) != family ||
+		array_uint32_le (p +  8) != serial ||
+		array_uint32_le (p + 12) != size ||
+		array_uint32_le (p + 16) != blocksize) {
+		WARNING (store->context, "Ignoring mismatching mirror file '%s'.", filename);
+		goto error_free;
+	}
+
+	// Only the blocks with a valid checksum are used. All other blocks
+	// will be downloaded again.
+	const unsigned char *crc = p + SZ_HEADER_MIRROR;
+	const unsigned char *image = crc + nblocks * 4;
+	for (unsigned int i = 0; i < nblocks; ++i) {
+		unsigned int offset = i * blocksize;
+		unsigned int len = size - offset < blocksize ? size - offset : blocksize;
+		if (array_uint32_le (crc + i * 4) == checksum_crc32 (image + offset, len)) {
+			memcpy (data + offset, image + offset, len);
+			valid[i] = 1;
+		}
+	}
+
+error_free:
+	dc_buffer_free (buffer);
+	return status;
+}
+
+dc_status_t
+dc_store_set_mirror (dc_store_t *store, dc_family_t family, unsigned int serial, const unsigned char data[], unsigned int size, unsigned int blocksize)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_buffer_t *buffer = NULL;
+	char filename[1024];
+
+	if (store == NULL || blocksize == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_MIRROR) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (dc_store_filename (store, family, serial, "dmp", filename, sizeof (filename)) != 0) {
+		ERROR (store->context, "Store filename too long.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	unsigned int nblocks = (size + blocksize - 1) / blocksize;
+	size_t length = SZ_HEADER_MIRROR + nblocks * 4 + size;
+
+	buffer = dc_buffer_new (length);
+	if (buffer == NULL || !dc_buffer_resize (buffer, length)) {
+		ERROR (store->context, "Failed to allocate memory.");
+		dc_buffer_free (buffer);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *p = dc_buffer_get_data (buffer);
+	array_uint32_le_set (p +  0, MAGIC_MIRROR);
+	array_uint32_le_set (p +  4, family);
+	array_uint32_le_set (p +  8, serial);
+	array_uint32_le_set (p + 12, size);
+	array_uint32_le_set (p + 16, blocksize);
+
+	unsigned char *crc = p + SZ_HEADER_MIRROR;
+	for (unsigned int i = 0; i < nblocks; ++i) {
+		unsigned int offset = i * blocksize;
+		unsigned int len = size - offset < blocksize ? size - offset : blocksize;
+		array_uint32_le_set (crc + i * 4, checksum_crc32 (data + offset, len));
+	}
+	memcpy (crc + nblocks * 4, data, size);
+
+	status = dc_store_replace (store, filename, p, length);
+
+	dc_buffer_free (buffer);
+
+	return status;
+}
+
+dc_status_t
+dc_store_get_checkpoint (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize, dc_buffer_t *data)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL || data == NULL || (key == NULL && ksize != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_CHECKPOINT) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	dc_buffer_clear (data);
+
+	dc_store_entry_t *entry = &store->entry;
+	for (unsigned int i = 0; i < entry->ncheckpoints; ++i) {
+		const dc_store_checkpoint_t *checkpoint = &entry->checkpoints[i];
+		if (checkpoint->address != address || checkpoint->size != size)
+			continue;
+
+		// A checkpoint taken with a different device state is useless.
+		if (dc_buffer_get_size (checkpoint->key) != ksize ||
+			(ksize && memcmp (dc_buffer_get_data (checkpoint->key), key, ksize) != 0))
+			break;
+
+		if (!dc_buffer_append (data,
+			dc_buffer_get_data (checkpoint->data),
+			dc_buffer_get_size (checkpoint->data))) {
+			ERROR (store->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_unlock;
+		}
+		break;
+	}
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+dc_status_t
+dc_store_set_checkpoint (dc_store_t *store, dc_family_t family, unsigned int serial, unsigned int address, unsigned int size, const unsigned char key[], unsigned int ksize, const unsigned char data[], unsigned int dsize)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL || (key == NULL && ksize != 0) || (data == NULL && dsize != 0))
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_CHECKPOINT) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	dc_store_entry_t *entry = &store->entry;
+
+	// Remove the previous checkpoint for the same range, or the oldest
+	// checkpoint if there is no free slot left. The buffers of the
+	// removed checkpoint are re-used for the new one.
+	unsigned int i = 0;
+	while (i < entry->ncheckpoints) {
+		if (entry->checkpoints[i].address == address && entry->checkpoints[i].size == size)
+			break;
+		i++;
+	}
+	if (i == MAX_CHECKPOINTS)
+		i = 0;
+	if (i < entry->ncheckpoints) {
+		dc_store_checkpoint_t removed = entry->checkpoints[i];
+		memmove (entry->checkpoints + i, entry->checkpoints + i + 1,
+			(entry->ncheckpoints - i - 1) * sizeof (dc_store_checkpoint_t));
+		entry->ncheckpoints--;
+		entry->checkpoints[entry->ncheckpoints] = removed;
+	}
+
+	entry->checkpoints_dirty = 1;
+	entry->dirty = 1;
+
+	status = dc_store_checkpoint_assign (store, &entry->checkpoints[entry->ncheckpoints],
+		address, size, key, ksize, data, dsize);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	entry->ncheckpoints++;
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
+
+dc_status_t
+dc_store_clear_checkpoints (dc_store_t *store, dc_family_t family, unsigned int serial)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (store == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if ((store->flags & DC_STORE_CHECKPOINT) == 0)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_store_lock (store);
+
+	status = dc_store_select (store, family, serial);
+	if (status != DC_STATUS_SUCCESS)
+		goto error_unlock;
+
+	if (store->entry.ncheckpoints) {
+		store->entry.ncheckpoints = 0;
+		store->entry.checkpoints_dirty = 1;
+		store->entry.dirty = 1;
+	}
+
+error_unlock:
+	dc_store_unlock (store);
+	return status;
+}
@@ -34,6 +34,7 @@
 
 #define SZ_VERSION    0x04
 #define SZ_PACKET     0x78
+#define SZ_PIPELINE   (4 * SZ_PACKET)
 #define SZ_MINIMUM    8
 
 #define RB_PROFILE_DISTANCE(l,a,b,m)  ringbuffer_distance (a, b, m, l->rb_profile_begin, l->rb_profile_end)
@@ -49,6 +50,40 @@ suunto_common2_device_init (suunto_common2_device_t *device)
 	device->layout = NULL;
 	memset (device->version, 0, sizeof (device->version));
 	memset (device->fingerprint, 0, sizeof (device->fingerprint));
+	device->pipelined = 0;
+}
+
+
+dc_status_t
+suunto_common2_device_verify (dc_device_t *abstract, const unsigned char command[], const unsigned char answer[], unsigned int asize, unsigned int size)
+{
+	// Verify the header of the package.
+	if (answer[0] != command[0]) {
+		ERROR (abstract->context, "Unexpected answer header.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the size of the package.
+	if (array_uint16_be (answer + 1) + 4 != asize) {
+		ERROR (abstract->context, "Unexpected answer size.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the parameters of the package.
+	if (memcmp (command + 3, answer + 3, asize - size - 4) != 0) {
+		ERROR (abstract->context, "Unexpected answer parameters.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the checksum of the package.
+	unsigned char crc = answer[asize - 1];
+	unsigned char ccrc = checksum_xor_uint8 (answer, asize - 1, 0x00);
+	if (crc != ccrc) {
+		ERROR (abstract->context, "Unexpected answer checksum.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	return DC_STATUS_SUCCESS;
 }
 
 
@@ -132,10 +167,101 @@ suunto_common2_device_reset_maxdepth (dc_device_t *abstract)
 }
 
 
+static void
+suunto_common2_read_command (unsigned char command[7], unsigned int address, unsigned int len)
+{
+	command[0] = 0x05;
+	command[1] = 0x00;
+	command[2] = 0x03;
+	command[3] = (address >> 8) & 0xFF; // high
+	command[4] = (address     ) & 0xFF; // low
+	command[5] = len; // count
+	command[6] = checksum_xor_uint8 (command, 6, 0x00);
+}
+
+
+static dc_status_t
+suunto_common2_device_read_pipelined (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size, unsigned int *actual)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	unsigned char command[2][7];
+	unsigned char answer[SZ_PACKET + 7] = {0};
+
+	// Send the first read command.
+	unsigned int len = size < SZ_PACKET ? size : SZ_PACKET;
+	suunto_common2_read_command (command[0], address, len);
+	rc = VTABLE (abstract)->send (abstract, command[0], sizeof (command[0]));
+	if (rc != DC_STATUS_SUCCESS) {
+		*actual = 0;
+		return rc;
+	}
+
+	unsigned int nbytes = 0;
+	unsigned int current = 0;
+	while (nbytes < size) {
+		rc = VTABLE (abstract)->receive (abstract, answer, len + 7);
+		if (rc != DC_STATUS_SUCCESS)
+			break;
+
+		// The line is free again as soon as the answer has arrived. Send
+		// the next command right away, and verify the answer while the
+		// next one is being transferred.
+		unsigned int next = 0;
+		if (nbytes + len < size) {
+			next = size - nbytes - len;
+			if (next > SZ_PACKET)
+				next = SZ_PACKET;
+
+			suunto_common2_read_command (command[!current], address + nbytes + len, next);
+			rc = VTABLE (abstract)->send (abstract, command[!current], sizeof (command[!current]));
+			if (rc != DC_STATUS_SUCCESS)
+				break;
+		}
+
+		rc = suunto_common2_device_verify (abstract, command[current], answer, len + 7, len);
+		if (rc != DC_STATUS_SUCCESS) {
+			// Drain the answer to the pending command.
+			if (next)
+				VTABLE (abstract)->receive (abstract, answer, next + 7);
+			break;
+		}
+
+		memcpy (data + nbytes, answer + 6, len);
+
+		nbytes += len;
+		len = next;
+		current = !current;
+	}
+
+	*actual = nbytes;
+
+	return rc;
+}
+
+
 dc_status_t
 suunto_common2_device_read (dc_device_t *abstract, unsigned int address, unsigned char data[], unsigned int size)
 {
+	suunto_common2_device_t *device = (suunto_common2_device_t *) abstract;
+
 	unsigned int nbytes = 0;
+	if (device->pipelined && size > SZ_PACKET &&
+		VTABLE (abstract)->send && VTABLE (abstract)->receive) {
+		dc_status_t rc = suunto_common2_device_read_pipelined (abstract, address, data, size, &nbytes);
+		if (rc == DC_STATUS_SUCCESS)
+			return rc;
+
+		if (rc != DC_STATUS_TIMEOUT && rc != DC_STATUS_PROTOCOL)
+			return rc;
+
+		// Continue with the remaining data in lock-step mode.
+		WARNING (abstract->context, "Pipelined read failed. Falling back to lock-step mode.");
+		device->pipelined = 0;
+
+		address += nbytes;
+		data += nbytes;
+	}
+
 	while (nbytes < size) {
 		// Calculate the package size.
 		unsigned int len = size - nbytes;
@@ -144,12 +270,8 @@ suunto_common2_device_read (dc_device_t *abstract, unsigned int address, unsigne
 
 		// Read the package.
 		unsigned char answer[SZ_PACKET + 7] = {0};
-		unsigned char command[7] = {0x05, 0x00, 0x03,
-				(address >> 8) & 0xFF, // high
-				(address     ) & 0xFF, // low
-				len, // count
-				0};  // CRC
-		command[6] = checksum_xor_uint8 (command, 6, 0x00);
+		unsigned char command[7] = {0};
+		suunto_common2_read_command (command, address, len);
 		dc_status_t rc = suunto_common2_transfer (abstract, command, sizeof (command), answer, len + 7, len);
 		if (rc != DC_STATUS_SUCCESS)
 			return rc;
@@ -305,7 +427,9 @@ suunto_common2_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 
 	// Create the ringbuffer stream.
 	dc_rbstream_t *rbstream = NULL;
-	rc = dc_rbstream_new (&rbstream, abstract, 1, SZ_PACKET, layout->rb_profile_begin, layout->rb_profile_end, end);
+	// In pipelined mode, multiple packets are requested at once.
+	rc = dc_rbstream_new (&rbstream, abstract, 1, device->pipelined ? SZ_PIPELINE : SZ_PACKET,
+		layout->rb_profile_begin, layout->rb_profile_end, end);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to create the ringbuffer stream.");
 		return rc;
@@ -45,16 +45,25 @@ typedef struct suunto_common2_device_t {
 	const suunto_common2_layout_t *layout;
 	unsigned char version[4];
 	unsigned char fingerprint[7];
+	unsigned int pipelined;
 } suunto_common2_device_t;
 
 typedef struct suunto_common2_device_vtable_t {
 	dc_device_vtable_t base;
 	dc_status_t (*packet) (dc_device_t *device, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size);
+	// Optional, for the pipelined read. The send function returns as
+	// soon as the line is ready to receive the answer, and the answer
+	// is verified by the caller.
+	dc_status_t (*send) (dc_device_t *device, const unsigned char command[], unsigned int csize);
+	dc_status_t (*receive) (dc_device_t *device, unsigned char answer[], unsigned int asize);
 } suunto_common2_device_vtable_t;
 
 void
 suunto_common2_device_init (suunto_common2_device_t *device);
 
+dc_status_t
+suunto_common2_device_verify (dc_device_t *device, const unsigned char command[], const unsigned char answer[], unsigned int asize, unsigned int size);
+
 dc_status_t
 suunto_common2_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 
@@ -26,8 +26,6 @@
 #include "suunto_d9.h"
 #include "suunto_common2.h"
 #include "context-private.h"
-#include "checksum.h"
-#include "array.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), (const dc_device_vtable_t *) &suunto_d9_device_vtable)
 
@@ -47,6 +45,8 @@ typedef struct suunto_d9_device_t {
 } suunto_d9_device_t;
 
 static dc_status_t suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size);
+static dc_status_t suunto_d9_device_send (dc_device_t *abstract, const unsigned char command[], unsigned int csize);
+static dc_status_t suunto_d9_device_receive (dc_device_t *abstract, unsigned char answer[], unsigned int asize);
 
 static const suunto_common2_device_vtable_t suunto_d9_device_vtable = {
 	{
@@ -57,10 +57,14 @@ static const suunto_common2_device_vtable_t suunto_d9_device_vtable = {
 		suunto_common2_device_write, /* write */
 		suunto_common2_device_dump, /* dump */
 		suunto_common2_device_foreach, /* foreach */
+		NULL, /* headers */
+		NULL, /* read_dive */
 		NULL, /* timesync */
 		NULL /* close */
 	},
-	suunto_d9_device_packet
+	suunto_d9_device_packet,
+	suunto_d9_device_send,
+	suunto_d9_device_receive
 };
 
 static const suunto_common2_layout_t suunto_d9_layout = {
@@ -203,7 +207,7 @@ error_free:
 
 
 static dc_status_t
-suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size)
+suunto_d9_device_send (dc_device_t *abstract, const unsigned char command[], unsigned int csize)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	suunto_d9_device_t *device = (suunto_d9_device_t *) abstract;
@@ -247,6 +251,16 @@ suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], u
 		return status;
 	}
 
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+suunto_d9_device_receive (dc_device_t *abstract, unsigned char answer[], unsigned int asize)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	suunto_d9_device_t *device = (suunto_d9_device_t *) abstract;
+
 	// Receive the answer of the dive computer.
 	status = dc_iostream_read (device->iostream, answer, asize, NULL);
 	if (status != DC_STATUS_SUCCESS) {
@@ -254,35 +268,25 @@ suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], u
 		return status;
 	}
 
-	// Verify the header of the package.
-	if (answer[0] != command[0]) {
-		ERROR (abstract->context, "Unexpected answer header.");
-		return DC_STATUS_PROTOCOL;
-	}
+	return DC_STATUS_SUCCESS;
+}
 
-	// Verify the size of the package.
-	if (array_uint16_be (answer + 1) + 4 != asize) {
-		ERROR (abstract->context, "Unexpected answer size.");
-		return DC_STATUS_PROTOCOL;
-	}
 
-	// Verify the parameters of the package.
-	if (memcmp (command + 3, answer + 3, asize - size - 4) != 0) {
-		ERROR (abstract->context, "Unexpected answer parameters.");
-		return DC_STATUS_PROTOCOL;
-	}
+static dc_status_t
+suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
 
-	// Verify the checksum of the package.
-	unsigned char crc = answer[asize - 1];
-	unsigned char ccrc = checksum_xor_uint8 (answer, asize - 1, 0x00);
-	if (crc != ccrc) {
-		ERROR (abstract->context, "Unexpected answer checksum.");
-		return DC_STATUS_PROTOCOL;
-	}
+	status = suunto_d9_device_send (abstract, command, csize);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
 
-	return DC_STATUS_SUCCESS;
-}
+	status = suunto_d9_device_receive (abstract, answer, asize);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
 
+	return suunto_common2_device_verify (abstract, command, answer, asize, size);
+}
 
 dc_status_t
 suunto_d9_device_version (dc_device_t *abstract, unsigned char data[], unsigned int size)
@@ -294,6 +298,20 @@ suunto_d9_device_version (dc_device_t *abstract, unsigned char data[], unsigned
 }
 
 
+dc_status_t
+suunto_d9_device_set_pipelined (dc_device_t *abstract, unsigned int value)
+{
+	suunto_common2_device_t *device = (suunto_common2_device_t *) abstract;
+
+	if (!ISINSTANCE (abstract))
+		return DC_STATUS_INVALIDARGS;
+
+	device->pipelined = value;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 dc_status_t
 suunto_d9_device_reset_maxdepth (dc_device_t *abstract)
 {
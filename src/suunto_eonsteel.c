@@ -41,6 +41,7 @@ typedef struct suunto_eonsteel_device_t {
 	unsigned short seq;
 	unsigned char version[0x30];
 	unsigned char fingerprint[4];
+	struct directory_entry *dives;
 } suunto_eonsteel_device_t;
 
 // The EON Steel implements a small filesystem
@@ -80,6 +81,13 @@ struct directory_entry {
 #define MAXDATA_SIZE 2048
 #define CRC_SIZE    4
 
+// File read sizes. Each read reply carries an 8 byte header in front
+// of the file data, and over BLE it has to fit in a single frame.
+#define READ_HEADER   8
+#define READ_SIZE     1024
+#define READ_SIZE_USB 16384
+#define READ_SIZE_BLE (MAXDATA_SIZE - READ_HEADER)
+
 // HDLC special characters
 #define END     0x7E
 #define ESC     0x7D
@@ -87,7 +95,10 @@ struct directory_entry {
 
 static dc_status_t suunto_eonsteel_device_set_fingerprint (dc_device_t *abstract, const unsigned char data[], unsigned int size);
 static dc_status_t suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t suunto_eonsteel_device_headers(dc_device_t *abstract, dc_dive_callback_t callback, void *userdata);
+static dc_status_t suunto_eonsteel_device_read_dive(dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer);
 static dc_status_t suunto_eonsteel_device_timesync(dc_device_t *abstract, const dc_datetime_t *datetime);
+static dc_status_t suunto_eonsteel_device_close(dc_device_t *abstract);
 
 static const dc_device_vtable_t suunto_eonsteel_device_vtable = {
 	sizeof(suunto_eonsteel_device_t),
@@ -97,8 +108,10 @@ static const dc_device_vtable_t suunto_eonsteel_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	suunto_eonsteel_device_foreach, /* foreach */
+	suunto_eonsteel_device_headers, /* headers */
+	suunto_eonsteel_device_read_dive, /* read_dive */
 	suunto_eonsteel_device_timesync, /* timesync */
-	NULL /* close */
+	suunto_eonsteel_device_close /* close */
 };
 
 static const char dive_directory[] = "0:/dives";
@@ -335,10 +348,11 @@ static dc_status_t
 suunto_eonsteel_receive_ble(suunto_eonsteel_device_t *device, unsigned char data[], unsigned int size, unsigned int *actual)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
-	unsigned char buffer[HEADER_SIZE + MAXDATA_SIZE + CRC_SIZE];
 	size_t transferred = 0;
 
-	rc = suunto_eonsteel_hdlc_read(device, buffer, sizeof(buffer), &transferred);
+	// The frame is decoded in place, so the caller has to provide
+	// room for the trailing checksum as well.
+	rc = suunto_eonsteel_hdlc_read(device, data, size, &transferred);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR(device->base.context, "Failed to receive the packet.");
 		return rc;
@@ -351,21 +365,14 @@ suunto_eonsteel_receive_ble(suunto_eonsteel_device_t *device, unsigned char data
 
 	unsigned int nbytes = transferred - CRC_SIZE;
 
-	unsigned int crc = array_uint32_le(buffer + nbytes);
-	unsigned int ccrc = checksum_crc32(buffer, nbytes);
+	unsigned int crc = array_uint32_le(data + nbytes);
+	unsigned int ccrc = checksum_crc32(data, nbytes);
 	if (crc != ccrc) {
 		ERROR(device->base.context, "Invalid checksum (expected %08x, received %08x).", ccrc, crc);
 		return DC_STATUS_PROTOCOL;
 	}
 
-	if (nbytes > size) {
-		ERROR(device->base.context, "Insufficient buffer space available.");
-		return DC_STATUS_PROTOCOL;
-	}
-
-	memcpy(data, buffer, nbytes);
-
-	HEXDUMP (device->base.context, DC_LOGLEVEL_DEBUG, "rcv", buffer, nbytes);
+	HEXDUMP (device->base.context, DC_LOGLEVEL_DEBUG, "rcv", data, nbytes);
 
 	if (actual)
 		*actual = nbytes;
@@ -430,7 +437,32 @@ suunto_eonsteel_send(suunto_eonsteel_device_t *device,
 }
 
 /*
- * Send a command, receive a reply
+ * Copy a part of the reply payload, starting at the given offset, to
+ * its final location. The first psize bytes of the payload go to the
+ * prefix buffer, and everything after that to the answer buffer.
+ */
+static void
+suunto_eonsteel_scatter(const unsigned char data[], unsigned int offset, unsigned int size,
+	unsigned char prefix[], unsigned int psize,
+	unsigned char answer[])
+{
+	if (offset < psize) {
+		unsigned int n = psize - offset;
+		if (n > size)
+			n = size;
+		memcpy(prefix + offset, data, n);
+		data += n;
+		offset += n;
+		size -= n;
+	}
+
+	if (size) {
+		memcpy(answer + offset - psize, data, size);
+	}
+}
+
+/*
+ * Receive the reply to a command
  *
  * This carefully checks the data fields in the reply for a match
  * against the command, and then only returns the actual reply
@@ -441,23 +473,23 @@ suunto_eonsteel_send(suunto_eonsteel_device_t *device,
  * functon does not see the two initial 0x3f 0x?? bytes, and thus the
  * offsets for the cmd/magic/seq/len are off by two compared to the
  * send() side. The offsets are the same in the actual raw packet.
+ *
+ * The reply data is split over two buffers: the first psize bytes
+ * are stored in the prefix buffer, and the remainder in the answer
+ * buffer. This allows the caller to receive the payload of a reply
+ * directly at its final location, without an intermediate copy.
  */
 static dc_status_t
-suunto_eonsteel_transfer(suunto_eonsteel_device_t *device,
+suunto_eonsteel_receive(suunto_eonsteel_device_t *device,
 	unsigned short cmd,
-	const unsigned char data[], unsigned int size,
+	unsigned char prefix[], unsigned int psize,
 	unsigned char answer[], unsigned int asize,
 	unsigned int *actual)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
-	unsigned char header[HEADER_SIZE + MAXDATA_SIZE];
+	unsigned char header[HEADER_SIZE + MAXDATA_SIZE + CRC_SIZE];
 	unsigned int len = 0;
 
-	// Send the command.
-	rc = suunto_eonsteel_send(device, cmd, data, size);
-	if (rc != DC_STATUS_SUCCESS)
-		return rc;
-
 	if (dc_iostream_get_transport(device->iostream) == DC_TRANSPORT_BLE) {
 		// Receive the entire data packet.
 		rc = suunto_eonsteel_receive_ble(device, header, sizeof(header), &len);
@@ -501,7 +533,7 @@ suunto_eonsteel_transfer(suunto_eonsteel_device_t *device,
 	}
 
 	// Verify the length.
-	if (length > asize) {
+	if (length > psize + asize) {
 		ERROR(device->base.context, "Insufficient buffer space available.");
 		return DC_STATUS_PROTOCOL;
 	}
@@ -514,14 +546,28 @@ suunto_eonsteel_transfer(suunto_eonsteel_device_t *device,
 	}
 
 	// Copy the payload data.
-	memcpy(answer, header + HEADER_SIZE, nbytes);
+	suunto_eonsteel_scatter(header + HEADER_SIZE, 0, nbytes, prefix, psize, answer);
 
 	// Receive the remainder of the data.
 	if (dc_iostream_get_transport(device->iostream) != DC_TRANSPORT_BLE) {
 		while (nbytes < length) {
-			rc = suunto_eonsteel_receive_usb(device, answer + nbytes, length - nbytes, &len);
-			if (rc != DC_STATUS_SUCCESS)
-				return rc;
+			if (nbytes < psize) {
+				rc = suunto_eonsteel_receive_usb(device, header, PACKET_SIZE, &len);
+				if (rc != DC_STATUS_SUCCESS)
+					return rc;
+
+				if (len > length - nbytes) {
+					ERROR(device->base.context, "Insufficient buffer space available.");
+					return DC_STATUS_PROTOCOL;
+				}
+
+				suunto_eonsteel_scatter(header, nbytes, len, prefix, psize, answer);
+			} else {
+				// Receive directly at the final location.
+				rc = suunto_eonsteel_receive_usb(device, answer + nbytes - psize, length - nbytes, &len);
+				if (rc != DC_STATUS_SUCCESS)
+					return rc;
+			}
 
 			nbytes += len;
 
@@ -550,6 +596,26 @@ suunto_eonsteel_transfer(suunto_eonsteel_device_t *device,
 	return DC_STATUS_SUCCESS;
 }
 
+/*
+ * Send a command, receive a reply
+ */
+static dc_status_t
+suunto_eonsteel_transfer(suunto_eonsteel_device_t *device,
+	unsigned short cmd,
+	const unsigned char data[], unsigned int size,
+	unsigned char answer[], unsigned int asize,
+	unsigned int *actual)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	// Send the command.
+	rc = suunto_eonsteel_send(device, cmd, data, size);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	return suunto_eonsteel_receive(device, cmd, NULL, 0, answer, asize, actual);
+}
+
 static dc_status_t
 read_file(suunto_eonsteel_device_t *eon, const char *filename, dc_buffer_t *buf)
 {
@@ -585,51 +651,98 @@ read_file(suunto_eonsteel_device_t *eon, const char *filename, dc_buffer_t *buf)
 	size = array_uint32_le(result+4);
 	offset = 0;
 
-	while (size > 0) {
+	// Reserve the space for the entire file up front, and let each
+	// read reply store its data directly at the final location.
+	size_t initial = dc_buffer_get_size(buf);
+	if (!dc_buffer_resize(buf, initial + size)) {
+		ERROR (eon->base.context, "Insufficient buffer space available.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	unsigned char *data = dc_buffer_get_data(buf) + initial;
+
+	// Maximum read size for the transport.
+	unsigned int maxsize = READ_SIZE_USB;
+	if (dc_iostream_get_transport(eon->iostream) == DC_TRANSPORT_BLE)
+		maxsize = READ_SIZE_BLE;
+
+	// The read size is negotiated again for every file, starting
+	// from the size that is known to work.
+	unsigned int readsize = READ_SIZE;
+	unsigned int goodsize = READ_SIZE;
+	unsigned int retried = 0;
+
+	while (offset < size) {
+		unsigned char header[READ_HEADER];
 		unsigned int ask, got, at;
 
-		ask = size;
-		if (ask > 1024)
-			ask = 1024;
+		ask = size - offset;
+		if (ask > readsize)
+			ask = readsize;
 		put_le32(1234, cmdbuf+0);	// Not file offset, after all
 		put_le32(ask, cmdbuf+4);	// Size of read
-		rc = suunto_eonsteel_transfer(eon, CMD_FILE_READ,
-			cmdbuf, 8, result, sizeof(result), &n);
+		rc = suunto_eonsteel_send(eon, CMD_FILE_READ, cmdbuf, 8);
+		if (rc == DC_STATUS_SUCCESS) {
+			rc = suunto_eonsteel_receive(eon, CMD_FILE_READ,
+				header, sizeof(header), data + offset, size - offset, &n);
+		}
+		if (rc == DC_STATUS_SUCCESS && n < 8) {
+			ERROR(eon->base.context, "got short read reply for %s", filename);
+			rc = DC_STATUS_PROTOCOL;
+		}
 		if (rc != DC_STATUS_SUCCESS) {
+			// A larger read may be more than the firmware accepts.
+			// Fall back to the last size that worked, and try once
+			// more without growing again.
+			if (rc != DC_STATUS_CANCELLED && !retried && readsize > goodsize) {
+				WARNING(eon->base.context, "read of %s failed, retrying with %u bytes", filename, goodsize);
+				readsize = maxsize = goodsize;
+				retried = 1;
+				continue;
+			}
 			ERROR(eon->base.context, "unable to read %s", filename);
 			return rc;
 		}
-		if (n < 8) {
-			ERROR(eon->base.context, "got short read reply for %s", filename);
-			return DC_STATUS_PROTOCOL;
-		}
 
 		// Not file offset, just stays unmodified.
-		at = array_uint32_le(result);
+		at = array_uint32_le(header);
 		if (at != 1234) {
 			ERROR(eon->base.context, "read of %s returned different offset than asked for (%d vs %d)", filename, at, offset);
 			return DC_STATUS_PROTOCOL;
 		}
 
 		// Number of bytes actually read
-		got = array_uint32_le(result+4);
+		got = array_uint32_le(header+4);
 		if (!got)
 			break;
 		if (n < 8 + got) {
 			ERROR(eon->base.context, "odd read size reply for offset %d of file %s", offset, filename);
 			return DC_STATUS_PROTOCOL;
 		}
-
-		if (got > size)
-			got = size;
-		if (!dc_buffer_append (buf, result + 8, got)) {
-			ERROR (eon->base.context, "Insufficient buffer space available.");
-			return DC_STATUS_NOMEMORY;
+		if (got > size - offset)
+			got = size - offset;
+
+		// Negotiate the read size. As long as the firmware returns
+		// everything we asked for, try a larger read next time. A
+		// short read in the middle of the file marks the largest
+		// size the firmware accepts.
+		if (got == ask && ask == readsize) {
+			goodsize = readsize;
+			if (readsize < maxsize) {
+				readsize *= 2;
+				if (readsize > maxsize)
+					readsize = maxsize;
+			}
+		} else if (got < ask && offset + got < size) {
+			readsize = goodsize = got;
 		}
+
 		offset += got;
-		size -= got;
 	}
 
+	// Drop the unused part of the reservation.
+	dc_buffer_resize(buf, initial + offset);
+
 	rc = suunto_eonsteel_transfer(eon, CMD_FILE_CLOSE,
 		NULL, 0, result, sizeof(result), &n);
 	if (rc != DC_STATUS_SUCCESS) {
@@ -731,6 +844,30 @@ get_file_list(suunto_eonsteel_device_t *eon, struct directory_entry **res)
 	return DC_STATUS_SUCCESS;
 }
 
+/*
+ * The dive directory only changes when a new dive is logged, and
+ * that doesn't happen while the dive computer is connected. So the
+ * listing is read only once per connection, and then kept until the
+ * device is closed. Further downloads, header reads and single dive
+ * reads on the same handle reuse it. Every new connection still needs
+ * a fresh listing, because that is the only way to find new dives.
+ */
+static dc_status_t
+get_dive_list(suunto_eonsteel_device_t *eon, struct directory_entry **res)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	if (eon->dives == NULL) {
+		rc = get_file_list(eon, &eon->dives);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+	}
+
+	*res = eon->dives;
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 suunto_eonsteel_device_open(dc_device_t **out, dc_context_t *context, dc_iostream_t *iostream, unsigned int model)
 {
@@ -749,6 +886,7 @@ suunto_eonsteel_device_open(dc_device_t **out, dc_context_t *context, dc_iostrea
 	eon->model = model;
 	eon->magic = INIT_MAGIC;
 	eon->seq = INIT_SEQ;
+	eon->dives = NULL;
 	memset (eon->version, 0, sizeof (eon->version));
 	memset (eon->fingerprint, 0, sizeof (eon->fingerprint));
 
@@ -792,7 +930,7 @@ suunto_eonsteel_device_set_fingerprint (dc_device_t *abstract, const unsigned ch
 }
 
 static dc_status_t
-suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+suunto_eonsteel_device_download(dc_device_t *abstract, unsigned int headers, dc_dive_callback_t callback, void *userdata)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_status_t rc = DC_STATUS_SUCCESS;
@@ -812,7 +950,7 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 	devinfo.serial = array_convert_str2num(eon->version + 0x10, 16);
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
-	rc = get_file_list(eon, &de);
+	rc = get_dive_list(eon, &de);
 	if (rc != DC_STATUS_SUCCESS)
 		return rc;
 
@@ -824,34 +962,18 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 	// The filename represent the time of the dive, encoded as a hexadecimal
 	// number. Thus the most recent dive can be found by simply sorting the
 	// filenames alphabetically.
-	struct directory_entry *head = de, *tail = de, *latest = de;
+	struct directory_entry *head = de, *latest = de;
 	while (de) {
 		if (strcmp (de->name, latest->name) > 0) {
 			latest = de;
 		}
-		tail = de;
 		count++;
 		de = de->next;
 	}
 
-	// Make the most recent dive the head of the list.
-	// The linked list is made circular, by attaching the head to the tail and
-	// then cut open again just before the most recent dive.
-	de = head;
-	while (de) {
-		if (de->next == latest) {
-			de->next = NULL;
-			tail->next = head;
-			break;
-		}
-
-		de = de->next;
-	}
-
 	file = dc_buffer_new (16384);
 	if (file == NULL) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
-		file_list_free (latest);
 		return DC_STATUS_NOMEMORY;
 	}
 
@@ -859,10 +981,13 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 	progress.current = 0;
 	device_event_emit(abstract, DC_EVENT_PROGRESS, &progress);
 
+	// Start with the most recent dive. The cached list is treated as
+	// circular, wrapping around from the tail to the head, and ending
+	// just before the most recent dive.
 	de = latest;
 	while (de) {
 		int len;
-		struct directory_entry *next = de->next;
+		struct directory_entry *next = de->next ? de->next : head;
 		unsigned char buf[4];
 		const unsigned char *data = NULL;
 		unsigned int size = 0;
@@ -892,6 +1017,15 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 				break;
 			}
 
+			// The filename is all we know without reading the file. Pass
+			// just the 4-byte time pre-header, which the parser accepts
+			// for the date and time of the dive.
+			if (headers) {
+				if (callback && !callback(buf, sizeof(buf), buf, sizeof(eon->fingerprint), userdata))
+					skip = 1;
+				break;
+			}
+
 			len = snprintf(pathname, sizeof(pathname), "%s/%s", dive_directory, de->name);
 			if (len < 0 || (unsigned int) len >= sizeof(pathname)) {
 				dc_status_set_error(&status, DC_STATUS_PROTOCOL);
@@ -918,14 +1052,80 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 		progress.current++;
 		device_event_emit(abstract, DC_EVENT_PROGRESS, &progress);
 
-		free(de);
-		de = next;
+		de = next != latest ? next : NULL;
 	}
 	dc_buffer_free(file);
 
 	return status;
 }
 
+static dc_status_t
+suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return suunto_eonsteel_device_download(abstract, 0, callback, userdata);
+}
+
+static dc_status_t
+suunto_eonsteel_device_headers(dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
+{
+	return suunto_eonsteel_device_download(abstract, 1, callback, userdata);
+}
+
+static dc_status_t
+suunto_eonsteel_device_read_dive(dc_device_t *abstract, const unsigned char fingerprint[], unsigned int size, dc_buffer_t *buffer)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	struct directory_entry *de, *list;
+	suunto_eonsteel_device_t *eon = (suunto_eonsteel_device_t *) abstract;
+	char pathname[64];
+	unsigned int time;
+	int len;
+
+	if (size != sizeof(eon->fingerprint))
+		return DC_STATUS_INVALIDARGS;
+
+	// Emit a device info event.
+	dc_event_devinfo_t devinfo;
+	devinfo.model = eon->model;
+	devinfo.firmware = array_uint32_be (eon->version + 0x20);
+	devinfo.serial = array_convert_str2num(eon->version + 0x10, 16);
+	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
+
+	// The fingerprint is the dive time, which is also encoded in the
+	// filename. The directory listing is still needed to get the exact
+	// filename.
+	rc = get_dive_list(eon, &list);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	for (de = list; de; de = de->next) {
+		unsigned char buf[4];
+
+		if (de->type != DIRTYPE_FILE)
+			continue;
+
+		if (sscanf(de->name, "%x.LOG", &time) != 1)
+			continue;
+
+		put_le32(time, buf);
+		if (memcmp (buf, fingerprint, sizeof (buf)) == 0)
+			break;
+	}
+
+	if (de == NULL) {
+		ERROR (abstract->context, "No dive with the requested fingerprint.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	len = snprintf(pathname, sizeof(pathname), "%s/%s", dive_directory, de->name);
+	if (len < 0 || (unsigned int) len >= sizeof(pathname))
+		return DC_STATUS_PROTOCOL;
+
+	// Put the 4-byte time at the head, followed by the file contents.
+	dc_buffer_append(buffer, fingerprint, size);
+	return read_file(eon, pathname, buffer);
+}
+
 static dc_status_t suunto_eonsteel_device_timesync(dc_device_t *abstract, const dc_datetime_t *datetime)
 {
 	suunto_eonsteel_device_t *eon = (suunto_eonsteel_device_t *) abstract;
@@ -962,3 +1162,13 @@ static dc_status_t suunto_eonsteel_device_timesync(dc_device_t *abstract, const
 
 	return DC_STATUS_SUCCESS;
 }
+
+static dc_status_t
+suunto_eonsteel_device_close(dc_device_t *abstract)
+{
+	suunto_eonsteel_device_t *eon = (suunto_eonsteel_device_t *) abstract;
+
+	file_list_free(eon->dives);
+
+	return DC_STATUS_SUCCESS;
+}
@@ -69,12 +69,56 @@ enum eon_sample {
 	ES_bookmark,
 };
 
+enum eon_field {
+	EF_none = 0,
+	EF_serial,
+	EF_hw_version,
+	EF_fw_version,
+	EF_battery_start,
+	EF_battery_end,
+	EF_gas_state,
+	EF_gas_oxygen,
+	EF_gas_helium,
+	EF_gas_transmitter,
+	EF_gas_tanksize,
+	EF_gas_fillpressure,
+	EF_gas_battery_start,
+	EF_gas_battery_end,
+	EF_surface_pressure,
+	EF_algorithm,
+	EF_divemode,
+	EF_conservatism,
+	EF_lowsetpoint,
+	EF_highsetpoint,
+	EF_desaturation_time,
+	EF_surface_time,
+	EF_maxdepth,
+	EF_datetime,
+};
+
 #define EON_MAX_GROUP 16
 
+/*
+ * The descriptors are repeated in every dive, and are almost always
+ * identical from one dive to the next. The original descriptor text is
+ * kept, so an unchanged descriptor can be re-used without parsing it
+ * again. The desc, format and mod strings point into that text. For an
+ * enumeration, the names are also kept as separate strings, which stay
+ * valid for as long as the descriptor.
+ *
+ * Only the descriptors declared in the file are stored, in a dense
+ * array. The type number is mapped to the array through an index
+ * table. The field and sample types are stored as a single byte.
+ */
 struct type_desc {
 	char *desc, *format, *mod;
+	char *names;
+	char *text;
+	unsigned int length;
 	unsigned int size;
-	enum eon_sample type[EON_MAX_GROUP];
+	unsigned char field;
+	unsigned char active;
+	unsigned char type[EON_MAX_GROUP];
 };
 
 #define MAXTYPE 512
@@ -83,7 +127,9 @@ struct type_desc {
 
 typedef struct suunto_eonsteel_parser_t {
 	dc_parser_t base;
-	struct type_desc type_desc[MAXTYPE];
+	unsigned short index[MAXTYPE];
+	struct type_desc *type_desc;
+	unsigned int ndescs, maxdescs;
 	// field cache
 	struct {
 		unsigned int initialized;
@@ -140,6 +186,59 @@ static const struct {
 	{ "Events.DiveTimer.Time",		ES_none },
 };
 
+static const struct {
+	const char *name;
+	enum eon_field field;
+} field_translation[] = {
+	{ "sml.DeviceLog.Device.SerialNumber",				EF_serial },
+	{ "sml.DeviceLog.Device.Info.HW",				EF_hw_version },
+	{ "sml.DeviceLog.Device.Info.SW",				EF_fw_version },
+	{ "sml.DeviceLog.Device.Info.BatteryAtStart",			EF_battery_start },
+	{ "sml.DeviceLog.Device.Info.BatteryAtEnd",			EF_battery_end },
+	{ "sml.DeviceLog.Header.Diving.Gases+Gas.State",		EF_gas_state },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.Oxygen",		EF_gas_oxygen },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.Helium",		EF_gas_helium },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.TransmitterID",	EF_gas_transmitter },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.TankSize",		EF_gas_tanksize },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.TankFillPressure",	EF_gas_fillpressure },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.TransmitterStartBatteryCharge", EF_gas_battery_start },
+	{ "sml.DeviceLog.Header.Diving.Gases.Gas.TransmitterEndBatteryCharge", EF_gas_battery_end },
+	{ "sml.DeviceLog.Header.Diving.SurfacePressure",		EF_surface_pressure },
+	{ "sml.DeviceLog.Header.Diving.Algorithm",			EF_algorithm },
+	{ "sml.DeviceLog.Header.Diving.DiveMode",			EF_divemode },
+	{ "sml.DeviceLog.Header.Diving.Conservatism",			EF_conservatism },
+	{ "sml.DeviceLog.Header.Diving.LowSetPoint",			EF_lowsetpoint },
+	{ "sml.DeviceLog.Header.Diving.HighSetPoint",			EF_highsetpoint },
+	{ "sml.DeviceLog.Header.Diving.DesaturationTime",		EF_desaturation_time },
+	{ "sml.DeviceLog.Header.Diving.SurfaceTime",			EF_surface_time },
+	{ "sml.DeviceLog.Header.Depth.Max",				EF_maxdepth },
+	{ "sml.DeviceLog.Header.DateTime",				EF_datetime },
+};
+
+static struct type_desc *lookup_desc(suunto_eonsteel_parser_t *eon, unsigned int type)
+{
+	if (type >= MAXTYPE || eon->index[type] == 0)
+		return NULL;
+
+	return eon->type_desc + eon->index[type] - 1;
+}
+
+static enum eon_field lookup_descriptor_field(suunto_eonsteel_parser_t *eon, struct type_desc *desc)
+{
+	int i;
+	const char *name = desc->desc;
+
+	// Only the header and device fields are of interest
+	if (strncmp(name, "sml.DeviceLog.", 14))
+		return EF_none;
+
+	for (i = 0; i < C_ARRAY_SIZE(field_translation); i++) {
+		if (!strcmp(name, field_translation[i].name))
+			return field_translation[i].field;
+	}
+	return EF_none;
+}
+
 static enum eon_sample lookup_descriptor_type(suunto_eonsteel_parser_t *eon, struct type_desc *desc)
 {
 	int i;
@@ -221,8 +320,8 @@ static int fill_in_group_details(suunto_eonsteel_parser_t *eon, struct type_desc
 			ERROR(eon->base.context, "Group type descriptor '%s' does not parse", desc->desc);
 			break;
 		}
-		base = eon->type_desc + index;
-		if (!base->desc) {
+		base = lookup_desc(eon, index);
+		if (!base || !base->active || !base->desc) {
 			ERROR(eon->base.context, "Group type descriptor '%s' has undescribed index %ld", desc->desc, index);
 			break;
 		}
@@ -278,6 +377,7 @@ static int fill_in_desc_details(suunto_eonsteel_parser_t *eon, struct type_desc
 
 	desc->size = lookup_descriptor_size(eon, desc);
 	desc->type[0] = lookup_descriptor_type(eon, desc);
+	desc->field = lookup_descriptor_field(eon, desc);
 	return 0;
 }
 
@@ -285,64 +385,99 @@ static void
 desc_free (struct type_desc desc[], unsigned int count)
 {
 	for (unsigned int i = 0; i < count; ++i) {
-		free(desc[i].desc);
-		free(desc[i].format);
-		free(desc[i].mod);
+		free(desc[i].text);
 	}
 }
 
 static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const char *name, int namelen)
 {
 	struct type_desc desc;
-	const char *next;
+	unsigned int length = strlen(name);
+	char *text, *line, *next;
+
+	// Re-use the descriptor if the text is unchanged. Group
+	// descriptors depend on their sub-entries, which may have
+	// changed, so those are always resolved again.
+	struct type_desc *cached = lookup_desc(eon, type);
+	if (cached) {
+		if (cached->text && cached->length == length &&
+			!memcmp(cached->text, name, length)) {
+			cached->active = 1;
+			if (cached->desc && isdigit(cached->desc[0])) {
+				cached->size = 0;
+				memset(cached->type, 0, sizeof(cached->type));
+				fill_in_group_details(eon, cached);
+			}
+			return 0;
+		}
+	}
 
 	memset(&desc, 0, sizeof(desc));
+
+	// Keep a copy of the original text, and split it
+	// into lines in a second copy. The third copy is
+	// for the enumeration names.
+	text = (char *) malloc(3 * (length + 1));
+	if (!text) {
+		ERROR(eon->base.context, "out of memory");
+		return -1;
+	}
+	memcpy(text, name, length + 1);
+	line = text + length + 1;
+	memcpy(line, name, length + 1);
+	desc.text = text;
+	desc.length = length;
+	desc.active = 1;
+
 	do {
 		int len;
-		char *p;
 
-		next = strchr(name, '\n');
+		next = strchr(line, '\n');
 		if (next) {
-			len = next - name;
-			next++;
+			len = next - line;
+			*next++ = 0;
 		} else {
-			len = strlen(name);
+			len = strlen(line);
 			if (!len)
 				break;
 		}
 
-		if (len < 5 || name[0] != '<' || name[4] != '>') {
-			ERROR(eon->base.context, "Unexpected type description: %.*s", len, name);
-			return -1;
-		}
-		p = (char *) malloc(len-4);
-		if (!p) {
-			ERROR(eon->base.context, "out of memory");
+		if (len < 5 || line[0] != '<' || line[4] != '>') {
+			ERROR(eon->base.context, "Unexpected type description: %.*s", len, line);
 			desc_free(&desc, 1);
 			return -1;
 		}
-		memcpy(p, name+5, len-5);
-		p[len-5] = 0;
 
 		// PTH, GRP, FRM, MOD
-		switch (name[1]) {
+		switch (line[1]) {
 		case 'P':
 		case 'G':
-			desc.desc = p;
+			desc.desc = line + 5;
 			break;
 		case 'F':
-			desc.format = p;
+			desc.format = line + 5;
 			break;
 		case 'M':
-			desc.mod = p;
+			desc.mod = line + 5;
 			break;
 		default:
-			ERROR(eon->base.context, "Unknown type descriptor: %.*s", len, name);
+			ERROR(eon->base.context, "Unknown type descriptor: %.*s", len, line);
 			desc_free(&desc, 1);
-			free(p);
 			return -1;
 		}
-	} while ((name = next) != NULL);
+	} while ((line = next) != NULL);
+
+	// Split the enumeration values into separate strings, such
+	// that the names can be returned without a copy.
+	if (desc.format && !strncmp(desc.format, "enum:", 5)) {
+		char *names = text + 2 * (length + 1);
+		memcpy(names, text + length + 1, length + 1);
+		desc.names = names + (desc.format - (text + length + 1));
+		for (char *p = desc.names; *p; ++p) {
+			if (*p == ',')
+				*p = 0;
+		}
+	}
 
 	if (type >= MAXTYPE) {
 		ERROR(eon->base.context, "Type out of range (%04x: '%s' '%s' '%s')",
@@ -356,14 +491,34 @@ static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const
 
 	fill_in_desc_details(eon, &desc);
 
-	desc_free(eon->type_desc + type, 1);
-	eon->type_desc[type] = desc;
+	if (cached) {
+		desc_free(cached, 1);
+		*cached = desc;
+		return 0;
+	}
+
+	// Grow the array of descriptors.
+	if (eon->ndescs == eon->maxdescs) {
+		unsigned int maxdescs = eon->maxdescs ? eon->maxdescs * 2 : 64;
+		struct type_desc *descs = (struct type_desc *) realloc(eon->type_desc, maxdescs * sizeof(struct type_desc));
+		if (!descs) {
+			ERROR(eon->base.context, "out of memory");
+			desc_free(&desc, 1);
+			return -1;
+		}
+		eon->type_desc = descs;
+		eon->maxdescs = maxdescs;
+	}
+
+	eon->type_desc[eon->ndescs++] = desc;
+	eon->index[type] = eon->ndescs;
 	return 0;
 }
 
 static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p, int len, eon_data_cb_t callback, void *user)
 {
 	const unsigned char *name, *data, *end, *last, *one_past_end = p + len;
+	const struct type_desc *desc;
 	int textlen, type;
 	int rc;
 
@@ -413,11 +568,12 @@ static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p,
 			end += 4;
 		}
 
-		if (type >= MAXTYPE || !eon->type_desc[type].desc) {
+		desc = lookup_desc(eon, type);
+		if (!desc || !desc->active || !desc->desc) {
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "last", last, 16);
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "this", begin, 16);
 		} else {
-			rc = callback(type, eon->type_desc+type, end, len, user);
+			rc = callback(type, desc, end, len, user);
 			if (rc < 0)
 				return rc;
 		}
@@ -458,8 +614,8 @@ struct sample_data {
 	dc_sample_callback_t callback;
 	void *userdata;
 	unsigned int time;
-	char *state_type, *notify_type;
-	char *warning_type, *alarm_type;
+	const char *state_type, *notify_type;
+	const char *warning_type, *alarm_type;
 
 	/* We gather up deco and cylinder pressure information */
 	int gasnr;
@@ -607,22 +763,22 @@ static void sample_gas_switch_event(struct sample_data *info, unsigned short idx
  * of enumeration values and strings. Example:
  *
  * "enum:0=NoFly Time,1=Depth,2=Surface Time,3=..."
+ *
+ * The returned string points into the descriptor, and remains valid
+ * until the descriptor is replaced or the parser is destroyed.
  */
-static char *lookup_enum(const struct type_desc *desc, unsigned char value)
+static const char *lookup_enum(const struct type_desc *desc, unsigned char value)
 {
 	const char *str = desc->format;
 	unsigned char c;
 
-	if (!str)
-		return NULL;
-	if (strncmp(str, "enum:", 5))
+	if (!str || !desc->names)
 		return NULL;
 	str += 5;
 
 	while ((c = *str) != 0) {
 		unsigned char n;
 		const char *begin, *end;
-		char *ret;
 
 		str++;
 		if (!isdigit(c))
@@ -652,13 +808,7 @@ static char *lookup_enum(const struct type_desc *desc, unsigned char value)
 		if (n != value)
 			continue;
 
-		ret = (char *)malloc(end - begin + 1);
-		if (!ret)
-			break;
-
-		memcpy(ret, begin, end-begin);
-		ret[end-begin] = 0;
-		return ret;
+		return desc->names + (begin - desc->format);
 	}
 	return NULL;
 }
@@ -669,7 +819,6 @@ static char *lookup_enum(const struct type_desc *desc, unsigned char value)
  */
 static void sample_event_state_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->state_type);
 	info->state_type = lookup_enum(desc, type);
 }
 
@@ -692,7 +841,6 @@ static void sample_event_state_value(const struct type_desc *desc, struct sample
 
 static void sample_event_notify_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->notify_type);
 	info->notify_type = lookup_enum(desc, type);
 }
 
@@ -716,7 +864,6 @@ static void sample_event_notify_value(const struct type_desc *desc, struct sampl
 
 static void sample_event_warning_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->warning_type);
 	info->warning_type = lookup_enum(desc, type);
 }
 
@@ -739,7 +886,6 @@ static void sample_event_warning_value(const struct type_desc *desc, struct samp
 
 static void sample_event_alarm_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	free(info->alarm_type);
 	info->alarm_type = lookup_enum(desc, type);
 }
 
@@ -765,7 +911,7 @@ static void sample_event_alarm_value(const struct type_desc *desc, struct sample
 static void sample_setpoint_type(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
 	dc_sample_value_t sample = {0};
-	char *type = lookup_enum(desc, value);
+	const char *type = lookup_enum(desc, value);
 
 	if (!type) {
 		DEBUG(info->eon->base.context, "sample_setpoint_type(%u) did not match anything in %s", value, desc->format);
@@ -780,12 +926,10 @@ static void sample_setpoint_type(const struct type_desc *desc, struct sample_dat
 		sample.ppo2 = info->eon->cache.customsetpoint;
 	else {
 		DEBUG(info->eon->base.context, "sample_setpoint_type(%u) unknown type '%s'", value, type);
-		free(type);
 		return;
 	}
 
 	if (info->callback) info->callback(DC_SAMPLE_SETPOINT, sample, info->userdata);
-	free(type);
 }
 
 // uint32
@@ -960,11 +1104,6 @@ suunto_eonsteel_parser_samples_foreach(dc_parser_t *abstract, dc_sample_callback
 
 	traverse_data(eon, traverse_samples, &data);
 
-	free(data.state_type);
-	free(data.notify_type);
-	free(data.warning_type);
-	free(data.alarm_type);
-
 	return DC_STATUS_SUCCESS;
 }
 
@@ -1115,7 +1254,7 @@ static int add_gas_type(suunto_eonsteel_parser_t *eon, const struct type_desc *d
 {
 	int idx = eon->cache.ngases;
 	dc_tankinfo_t tankinfo = DC_TANKINFO_METRIC;
-	char *name;
+	const char *name;
 
 	if (idx >= MAXGASES)
 		return 0;
@@ -1137,7 +1276,6 @@ static int add_gas_type(suunto_eonsteel_parser_t *eon, const struct type_desc *d
 
 	eon->cache.initialized |= 1 << DC_FIELD_GASMIX_COUNT;
 	eon->cache.initialized |= 1 << DC_FIELD_TANK_COUNT;
-	free(name);
 	return 0;
 }
 
@@ -1180,40 +1318,41 @@ static int add_gas_workpressure(suunto_eonsteel_parser_t *eon, float wp)
 	return 0;
 }
 
-static int add_string(suunto_eonsteel_parser_t *eon, const char *desc, const char *value)
+static int add_string_value(suunto_eonsteel_parser_t *eon, const char *desc, const char *value)
 {
 	int i;
 
+	if (!value)
+		return 0;
+
 	eon->cache.initialized |= 1 << DC_FIELD_STRING;
 	for (i = 0; i < MAXSTRINGS; i++) {
 		dc_field_string_t *str = eon->cache.strings+i;
 		if (str->desc)
 			continue;
 		str->desc = desc;
-		str->value = strdup(value);
+		str->value = value;
 		break;
 	}
 	return 0;
 }
 
+static int add_string(suunto_eonsteel_parser_t *eon, const char *desc, const char *value)
+{
+	return add_string_value(eon, desc, dc_parser_strdup(&eon->base, value));
+}
+
 static int add_string_fmt(suunto_eonsteel_parser_t *eon, const char *desc, const char *fmt, ...)
 {
-	char buffer[256];
+	const char *value;
 	va_list ap;
 
-	/*
-	 * We ignore the return value from vsnprintf, and we
-	 * always NUL-terminate the destination buffer ourselves.
-	 *
-	 * That way we don't have to worry about random bad legacy
-	 * implementations.
-	 */
+	// The string is formatted directly into the parser string arena.
 	va_start(ap, fmt);
-	buffer[sizeof(buffer)-1] = 0;
-	(void) vsnprintf(buffer, sizeof(buffer)-1, fmt, ap);
+	value = dc_parser_vprintf(&eon->base, fmt, ap);
 	va_end(ap);
 
-	return add_string(eon, desc, buffer);
+	return add_string_value(eon, desc, value);
 }
 
 static float get_le32_float(const unsigned char *src)
@@ -1235,78 +1374,17 @@ static float get_le32_float(const unsigned char *src)
 //   Info.SW
 //   Name
 //   SerialNumber
-static int traverse_device_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc,
-                                  const unsigned char *data, int len)
-{
-	const char *name = desc->desc + strlen("sml.DeviceLog.Device.");
-	if (!strcmp(name, "SerialNumber"))
-		return add_string(eon, "Serial", data);
-	if (!strcmp(name, "Info.HW"))
-		return add_string(eon, "HW Version", data);
-	if (!strcmp(name, "Info.SW"))
-		return add_string(eon, "FW Version", data);
-	if (!strcmp(name, "Info.BatteryAtStart"))
-		return add_string(eon, "Battery at start", data);
-	if (!strcmp(name, "Info.BatteryAtEnd"))
-		return add_string(eon, "Battery at end", data);
-	return 0;
-}
-
-// "sml.DeviceLog.Header.Diving.Gases"
 //
-//   +Gas.State (enum:0=Off,1=Primary,3=Diluent,4=Oxygen)
-//   .Gas.Oxygen (uint8,precision=2)
-//   .Gas.Helium (uint8,precision=2)
-//   .Gas.PO2 (uint32)
-//   .Gas.TransmitterID (utf8)
-//   .Gas.TankSize (float32,precision=5)
-//   .Gas.TankFillPressure (float32,precision=0)
-//   .Gas.StartPressure (float32,precision=0)
-//   .Gas.EndPressure (float32,precision=0)
-//   .Gas.TransmitterStartBatteryCharge (int8,precision=2)
-//   .Gas.TransmitterEndBatteryCharge (int8,precision=2)
-static int traverse_gas_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc,
-                               const unsigned char *data, int len)
-{
-	const char *name = desc->desc + strlen("sml.DeviceLog.Header.Diving.Gases");
-
-	if (!strcmp(name, "+Gas.State"))
-		return add_gas_type(eon, desc, data[0]);
-
-	if (!strcmp(name, ".Gas.Oxygen"))
-		return add_gas_o2(eon, data[0]);
-
-	if (!strcmp(name, ".Gas.Helium"))
-		return add_gas_he(eon, data[0]);
-
-	if (!strcmp(name, ".Gas.TransmitterID"))
-		return add_string(eon, "Transmitter ID", data);
-
-	if (!strcmp(name, ".Gas.TankSize"))
-		return add_gas_size(eon, get_le32_float(data));
-
-	if (!strcmp(name, ".Gas.TankFillPressure"))
-		return add_gas_workpressure(eon, get_le32_float(data));
-
-	// There is a bug with older transmitters, where the transmitter
-	// battery charge returns zero. Rather than returning that bogus
-	// data, just don't return any battery charge information at all.
-	//
-	// Make sure to add all non-battery-charge field checks above this
-	// test, so that it doesn't trigger for anything else.
-	if (!data[0])
-		return 0;
-
-	if (!strcmp(name, ".Gas.TransmitterStartBatteryCharge"))
-		return add_string_fmt(eon, "Transmitter Battery at start", "%d %%", data[0]);
-
-	if (!strcmp(name, ".Gas.TransmitterEndBatteryCharge"))
-		return add_string_fmt(eon, "Transmitter Battery at end", "%d %%", data[0]);
-
-	return 0;
-}
-
-
+// "Header" fields are:
+//   Activity (utf8)
+//   DateTime (utf8)
+//   Depth.Avg (float32,precision=2)
+//   Depth.Max (float32,precision=2)
+//   Diving.*
+//   Duration (uint32)
+//   PauseDuration (uint32)
+//   SampleInterval (uint8)
+//
 // "sml.DeviceLog.Header.Diving."
 //
 //   SurfaceTime (uint32)
@@ -1344,111 +1422,109 @@ static int traverse_gas_fields(suunto_eonsteel_parser_t *eon, const struct type_
 //   EndTissue.Helium+Pressure (uint32)
 //   EndTissue.RgbmNitrogen (float32,precision=3)
 //   EndTissue.RgbmHelium (float32,precision=3)
-static int traverse_diving_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc,
-                                  const unsigned char *data, int len)
+//
+// "sml.DeviceLog.Header.Diving.Gases"
+//
+//   +Gas.State (enum:0=Off,1=Primary,3=Diluent,4=Oxygen)
+//   .Gas.Oxygen (uint8,precision=2)
+//   .Gas.Helium (uint8,precision=2)
+//   .Gas.PO2 (uint32)
+//   .Gas.TransmitterID (utf8)
+//   .Gas.TankSize (float32,precision=5)
+//   .Gas.TankFillPressure (float32,precision=0)
+//   .Gas.StartPressure (float32,precision=0)
+//   .Gas.EndPressure (float32,precision=0)
+//   .Gas.TransmitterStartBatteryCharge (int8,precision=2)
+//   .Gas.TransmitterEndBatteryCharge (int8,precision=2)
+//
+// The field of each descriptor is resolved only once, when the
+// descriptor is recorded.
+static int traverse_dynamic_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc, const unsigned char *data, int len)
 {
-	const char *name = desc->desc + strlen("sml.DeviceLog.Header.Diving.");
+	unsigned int pressure, time;
+	double d;
 
-	if (!strncmp(name, "Gases", 5))
-		return traverse_gas_fields(eon, desc, data, len);
+	switch (desc->field) {
+	case EF_serial:
+		return add_string(eon, "Serial", data);
+	case EF_hw_version:
+		return add_string(eon, "HW Version", data);
+	case EF_fw_version:
+		return add_string(eon, "FW Version", data);
+	case EF_battery_start:
+		return add_string(eon, "Battery at start", data);
+	case EF_battery_end:
+		return add_string(eon, "Battery at end", data);
+
+	case EF_gas_state:
+		return add_gas_type(eon, desc, data[0]);
+	case EF_gas_oxygen:
+		return add_gas_o2(eon, data[0]);
+	case EF_gas_helium:
+		return add_gas_he(eon, data[0]);
+	case EF_gas_transmitter:
+		return add_string(eon, "Transmitter ID", data);
+	case EF_gas_tanksize:
+		return add_gas_size(eon, get_le32_float(data));
+	case EF_gas_fillpressure:
+		return add_gas_workpressure(eon, get_le32_float(data));
+
+	// There is a bug with older transmitters, where the transmitter
+	// battery charge returns zero. Rather than returning that bogus
+	// data, just don't return any battery charge information at all.
+	case EF_gas_battery_start:
+		if (!data[0])
+			return 0;
+		return add_string_fmt(eon, "Transmitter Battery at start", "%d %%", data[0]);
+	case EF_gas_battery_end:
+		if (!data[0])
+			return 0;
+		return add_string_fmt(eon, "Transmitter Battery at end", "%d %%", data[0]);
 
-	if (!strcmp(name, "SurfacePressure")) {
-		unsigned int pressure = array_uint32_le(data); // in SI units - Pascal
+	case EF_surface_pressure:
+		pressure = array_uint32_le(data); // in SI units - Pascal
 		eon->cache.surface_pressure = pressure / 100000.0; // bar
 		eon->cache.initialized |= 1 << DC_FIELD_ATMOSPHERIC;
 		return 0;
-	}
-
-	if (!strcmp(name, "Algorithm"))
+	case EF_algorithm:
 		return add_string(eon, "Deco algorithm", data);
-
-	if (!strcmp(name, "DiveMode")) {
+	case EF_divemode:
 		if (!strncmp((const char *)data, "CCR", 3)) {
 			eon->cache.divemode = DC_DIVEMODE_CCR;
 			eon->cache.initialized |= 1 << DC_FIELD_DIVEMODE;
 		}
 		return add_string(eon, "Dive Mode", data);
-	}
-
-	/* Signed byte of conservatism (-2 .. +2) */
-	if (!strcmp(name, "Conservatism")) {
-		int val = *(signed char *)data;
-
-		return add_string_fmt(eon, "Personal Adjustment", "P%d", val);
-	}
-
-	if (!strcmp(name, "LowSetPoint")) {
-		unsigned int pressure = array_uint32_le(data); // in SI units - Pascal
+	case EF_conservatism:
+		/* Signed byte of conservatism (-2 .. +2) */
+		return add_string_fmt(eon, "Personal Adjustment", "P%d", *(signed char *)data);
+	case EF_lowsetpoint:
+		pressure = array_uint32_le(data); // in SI units - Pascal
 		eon->cache.lowsetpoint = pressure / 100000.0; // bar
 		return 0;
-	}
-
-	if (!strcmp(name, "HighSetPoint")) {
-		unsigned int pressure = array_uint32_le(data); // in SI units - Pascal
+	case EF_highsetpoint:
+		pressure = array_uint32_le(data); // in SI units - Pascal
 		eon->cache.highsetpoint = pressure / 100000.0; // bar
 		return 0;
-	}
-
 	// Time recoded in seconds.
 	// Let's just agree to ignore seconds
-	if (!strcmp(name, "DesaturationTime")) {
-		unsigned int time = array_uint32_le(data) / 60;
+	case EF_desaturation_time:
+		time = array_uint32_le(data) / 60;
 		return add_string_fmt(eon, "Desaturation Time", "%d:%02d", time / 60, time % 60);
-	}
-
-	if (!strcmp(name, "SurfaceTime")) {
-		unsigned int time = array_uint32_le(data) / 60;
+	case EF_surface_time:
+		time = array_uint32_le(data) / 60;
 		return add_string_fmt(eon, "Surface Time", "%d:%02d", time / 60, time % 60);
-	}
-
-	return 0;
-}
-
-// "Header" fields are:
-//   Activity (utf8)
-//   DateTime (utf8)
-//   Depth.Avg (float32,precision=2)
-//   Depth.Max (float32,precision=2)
-//   Diving.*
-//   Duration (uint32)
-//   PauseDuration (uint32)
-//   SampleInterval (uint8)
-static int traverse_header_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc,
-                                  const unsigned char *data, int len)
-{
-	const char *name = desc->desc + strlen("sml.DeviceLog.Header.");
-
-	if (!strncmp(name, "Diving.", 7))
-		return traverse_diving_fields(eon, desc, data, len);
 
-	if (!strcmp(name, "Depth.Max")) {
-		double d = get_le32_float(data);
+	case EF_maxdepth:
+		d = get_le32_float(data);
 		if (d > eon->cache.maxdepth)
 			eon->cache.maxdepth = d;
 		return 0;
-	}
-	if (!strcmp(name, "DateTime"))
+	case EF_datetime:
 		return add_string(eon, "Dive ID", data);
 
-	return 0;
-}
-
-static int traverse_dynamic_fields(suunto_eonsteel_parser_t *eon, const struct type_desc *desc, const unsigned char *data, int len)
-{
-	const char *name = desc->desc;
-
-	if (!strncmp(name, "sml.", 4)) {
-		name += 4;
-		if (!strncmp(name, "DeviceLog.", 10)) {
-			name += 10;
-			if (!strncmp(name, "Device.", 7))
-				return traverse_device_fields(eon, desc, data, len);
-			if (!strncmp(name, "Header.", 7)) {
-				return traverse_header_fields(eon, desc, data, len);
-			}
-		}
+	default:
+		return 0;
 	}
-	return 0;
 }
 
 /*
@@ -1497,6 +1573,11 @@ static int traverse_fields(unsigned short type, const struct type_desc *desc, co
 static void initialize_field_caches(suunto_eonsteel_parser_t *eon)
 {
 	memset(&eon->cache, 0, sizeof(eon->cache));
+
+	// A header only download contains only the start time.
+	if (eon->base.size <= 4)
+		return;
+
 	eon->cache.initialized = 1 << DC_FIELD_DIVETIME;
 
 	traverse_data(eon, traverse_fields, eon);
@@ -1510,7 +1591,7 @@ static void show_descriptor(suunto_eonsteel_parser_t *eon, int nr, struct type_d
 {
 	int i;
 
-	if (!desc->desc)
+	if (!desc || !desc->active || !desc->desc)
 		return;
 	DEBUG(eon->base.context, "Descriptor %d: '%s', size %d bytes", nr, desc->desc, desc->size);
 	if (desc->format)
@@ -1528,7 +1609,7 @@ static void show_descriptor(suunto_eonsteel_parser_t *eon, int nr, struct type_d
 static void show_all_descriptors(suunto_eonsteel_parser_t *eon)
 {
 	for (unsigned int i = 0; i < MAXTYPE; ++i)
-		show_descriptor(eon, i, eon->type_desc+i);
+		show_descriptor(eon, i, lookup_desc(eon, i));
 }
 
 static dc_status_t
@@ -1536,8 +1617,11 @@ suunto_eonsteel_parser_set_data(dc_parser_t *parser, const unsigned char *data,
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) parser;
 
-	desc_free(eon->type_desc, MAXTYPE);
-	memset(eon->type_desc, 0, sizeof(eon->type_desc));
+	// Keep the descriptors of the previous dive for re-use, but
+	// don't use them until they are declared again.
+	for (unsigned int i = 0; i < eon->ndescs; ++i)
+		eon->type_desc[i].active = 0;
+
 	initialize_field_caches(eon);
 	show_all_descriptors(eon);
 	return DC_STATUS_SUCCESS;
@@ -1548,7 +1632,8 @@ suunto_eonsteel_parser_destroy(dc_parser_t *parser)
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) parser;
 
-	desc_free(eon->type_desc, MAXTYPE);
+	desc_free(eon->type_desc, eon->ndescs);
+	free(eon->type_desc);
 
 	return DC_STATUS_SUCCESS;
 }
@@ -1577,7 +1662,10 @@ suunto_eonsteel_parser_create(dc_parser_t **out, dc_context_t *context, unsigned
 		return DC_STATUS_NOMEMORY;
 	}
 
-	memset(&parser->type_desc, 0, sizeof(parser->type_desc));
+	memset(parser->index, 0, sizeof(parser->index));
+	parser->type_desc = NULL;
+	parser->ndescs = 0;
+	parser->maxdescs = 0;
 	memset(&parser->cache, 0, sizeof(parser->cache));
 
 	*out = (dc_parser_t *) parser;
@@ -51,10 +51,14 @@ static const suunto_common2_device_vtable_t suunto_vyper2_device_vtable = {
 		suunto_common2_device_write, /* write */
 		suunto_common2_device_dump, /* dump */
 		suunto_common2_device_foreach, /* foreach */
+		NULL, /* headers */
+		NULL, /* read_dive */
 		NULL, /* timesync */
 		suunto_vyper2_device_close /* close */
 	},
-	suunto_vyper2_device_packet
+	suunto_vyper2_device_packet,
+	NULL, /* send */
+	NULL /* receive */
 };
 
 static const suunto_common2_layout_t suunto_vyper2_layout = {
@@ -73,6 +73,8 @@ static const dc_device_vtable_t tecdiving_divecomputereu_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	tecdiving_divecomputereu_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	tecdiving_divecomputereu_device_close, /* close */
 };
@@ -0,0 +1,344 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#if defined (_WIN32)
+#define NOGDI
+#include <windows.h>
+#define HAVE_THREADS
+#elif defined (HAVE_PTHREAD_H)
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#define HAVE_THREADS
+#endif
+
+#include "thread.h"
+
+struct dc_thread_t {
+#if defined (_WIN32)
+	HANDLE handle;
+#elif defined (HAVE_PTHREAD_H)
+	pthread_t handle;
+#endif
+	dc_thread_func_t func;
+	void *userdata;
+};
+
+struct dc_mutex_t {
+#if defined (_WIN32)
+	CRITICAL_SECTION handle;
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_t handle;
+#endif
+};
+
+struct dc_cond_t {
+#if defined (_WIN32)
+	CONDITION_VARIABLE handle;
+#elif defined (HAVE_PTHREAD_H)
+	pthread_cond_t handle;
+#endif
+};
+
+#if defined (_WIN32)
+static DWORD WINAPI
+dc_thread_run (LPVOID arg)
+{
+	dc_thread_t *thread = (dc_thread_t *) arg;
+	thread->func (thread->userdata);
+	return 0;
+}
+#elif defined (HAVE_PTHREAD_H)
+static void *
+dc_thread_run (void *arg)
+{
+	dc_thread_t *thread = (dc_thread_t *) arg;
+	thread->func (thread->userdata);
+	return NULL;
+}
+#endif
+
+dc_status_t
+dc_thread_new (dc_thread_t **out, dc_thread_func_t func, void *userdata)
+{
+#ifdef HAVE_THREADS
+	dc_thread_t *thread = NULL;
+
+	if (out == NULL || func == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	thread = (dc_thread_t *) malloc (sizeof (dc_thread_t));
+	if (thread == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+	thread->func = func;
+	thread->userdata = userdata;
+
+#if defined (_WIN32)
+	thread->handle = CreateThread (NULL, 0, dc_thread_run, thread, 0, NULL);
+	if (thread->handle == NULL) {
+		free (thread);
+		return DC_STATUS_IO;
+	}
+#else
+	if (pthread_create (&thread->handle, NULL, dc_thread_run, thread) != 0) {
+		free (thread);
+		return DC_STATUS_IO;
+	}
+#endif
+
+	*out = thread;
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+dc_status_t
+dc_thread_join (dc_thread_t *thread)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (thread == NULL)
+		return DC_STATUS_SUCCESS;
+
+#if defined (_WIN32)
+	if (WaitForSingleObject (thread->handle, INFINITE) != WAIT_OBJECT_0) {
+		status = DC_STATUS_IO;
+	}
+	CloseHandle (thread->handle);
+#elif defined (HAVE_PTHREAD_H)
+	if (pthread_join (thread->handle, NULL) != 0) {
+		status = DC_STATUS_IO;
+	}
+#endif
+
+	free (thread);
+
+	return status;
+}
+
+dc_status_t
+dc_mutex_new (dc_mutex_t **out)
+{
+#ifdef HAVE_THREADS
+	dc_mutex_t *mutex = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	mutex = (dc_mutex_t *) malloc (sizeof (dc_mutex_t));
+	if (mutex == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+#if defined (_WIN32)
+	InitializeCriticalSection (&mutex->handle);
+#else
+	if (pthread_mutex_init (&mutex->handle, NULL) != 0) {
+		free (mutex);
+		return DC_STATUS_IO;
+	}
+#endif
+
+	*out = mutex;
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+void
+dc_mutex_lock (dc_mutex_t *mutex)
+{
+#if defined (_WIN32)
+	EnterCriticalSection (&mutex->handle);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_lock (&mutex->handle);
+#endif
+}
+
+void
+dc_mutex_unlock (dc_mutex_t *mutex)
+{
+#if defined (_WIN32)
+	LeaveCriticalSection (&mutex->handle);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_unlock (&mutex->handle);
+#endif
+}
+
+dc_status_t
+dc_mutex_free (dc_mutex_t *mutex)
+{
+	if (mutex == NULL)
+		return DC_STATUS_SUCCESS;
+
+#if defined (_WIN32)
+	DeleteCriticalSection (&mutex->handle);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_destroy (&mutex->handle);
+#endif
+
+	free (mutex);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_cond_new (dc_cond_t **out)
+{
+#ifdef HAVE_THREADS
+	dc_cond_t *cond = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	cond = (dc_cond_t *) malloc (sizeof (dc_cond_t));
+	if (cond == NULL) {
+		return DC_STATUS_NOMEMORY;
+	}
+
+#if defined (_WIN32)
+	InitializeConditionVariable (&cond->handle);
+#else
+	if (pthread_cond_init (&cond->handle, NULL) != 0) {
+		free (cond);
+		return DC_STATUS_IO;
+	}
+#endif
+
+	*out = cond;
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+void
+dc_cond_wait (dc_cond_t *cond, dc_mutex_t *mutex)
+{
+#if defined (_WIN32)
+	SleepConditionVariableCS (&cond->handle, &mutex->handle, INFINITE);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_cond_wait (&cond->handle, &mutex->handle);
+#endif
+}
+
+dc_status_t
+dc_cond_timedwait (dc_cond_t *cond, dc_mutex_t *mutex, unsigned int milliseconds)
+{
+#if defined (_WIN32)
+	if (!SleepConditionVariableCS (&cond->handle, &mutex->handle, milliseconds)) {
+		return GetLastError () == ERROR_TIMEOUT ? DC_STATUS_TIMEOUT : DC_STATUS_IO;
+	}
+#elif defined (HAVE_PTHREAD_H)
+	struct timespec ts;
+	clock_gettime (CLOCK_REALTIME, &ts);
+	ts.tv_sec += milliseconds / 1000;
+	ts.tv_nsec += (milliseconds % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	int rc = pthread_cond_timedwait (&cond->handle, &mutex->handle, &ts);
+	if (rc != 0) {
+		return rc == ETIMEDOUT ? DC_STATUS_TIMEOUT : DC_STATUS_IO;
+	}
+#endif
+
+	return DC_STATUS_SUCCESS;
+}
+
+void
+dc_cond_signal (dc_cond_t *cond)
+{
+#if defined (_WIN32)
+	WakeConditionVariable (&cond->handle);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_cond_signal (&cond->handle);
+#endif
+}
+
+void
+dc_cond_broadcast (dc_cond_t *cond)
+{
+#if defined (_WIN32)
+	WakeAllConditionVariable (&cond->handle);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_cond_broadcast (&cond->handle);
+#endif
+}
+
+dc_status_t
+dc_cond_free (dc_cond_t *cond)
+{
+	if (cond == NULL)
+		return DC_STATUS_SUCCESS;
+
+#if defined (_WIN32)
+	// Condition variables do not need to be destroyed.
+#elif defined (HAVE_PTHREAD_H)
+	pthread_cond_destroy (&cond->handle);
+#endif
+
+	free (cond);
+
+	return DC_STATUS_SUCCESS;
+}
+
+#if defined (_WIN32)
+static SRWLOCK g_once = SRWLOCK_INIT;
+#elif defined (HAVE_PTHREAD_H)
+static pthread_mutex_t g_once = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void
+dc_once (int *flag, dc_once_func_t func)
+{
+#if defined (_WIN32)
+	AcquireSRWLockExclusive (&g_once);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_lock (&g_once);
+#endif
+
+	if (!*flag) {
+		func ();
+		*flag = 1;
+	}
+
+#if defined (_WIN32)
+	ReleaseSRWLockExclusive (&g_once);
+#elif defined (HAVE_PTHREAD_H)
+	pthread_mutex_unlock (&g_once);
+#endif
+}
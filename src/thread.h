@@ -0,0 +1,96 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 libdivecomputer contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_THREAD_H
+#define DC_THREAD_H
+
+#include <libdivecomputer/common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct dc_thread_t dc_thread_t;
+typedef struct dc_mutex_t dc_mutex_t;
+typedef struct dc_cond_t dc_cond_t;
+
+typedef void (*dc_thread_func_t) (void *userdata);
+typedef void (*dc_once_func_t) (void);
+
+/*
+ * All functions return DC_STATUS_UNSUPPORTED on platforms without
+ * thread support. Callers are expected to fall back to a single
+ * threaded implementation in that case.
+ */
+
+dc_status_t
+dc_thread_new (dc_thread_t **thread, dc_thread_func_t func, void *userdata);
+
+dc_status_t
+dc_thread_join (dc_thread_t *thread);
+
+dc_status_t
+dc_mutex_new (dc_mutex_t **mutex);
+
+void
+dc_mutex_lock (dc_mutex_t *mutex);
+
+void
+dc_mutex_unlock (dc_mutex_t *mutex);
+
+dc_status_t
+dc_mutex_free (dc_mutex_t *mutex);
+
+dc_status_t
+dc_cond_new (dc_cond_t **cond);
+
+void
+dc_cond_wait (dc_cond_t *cond, dc_mutex_t *mutex);
+
+/*
+ * Wait at most the given number of milliseconds. Returns DC_STATUS_TIMEOUT
+ * if the condition was not signalled in time.
+ */
+dc_status_t
+dc_cond_timedwait (dc_cond_t *cond, dc_mutex_t *mutex, unsigned int milliseconds);
+
+void
+dc_cond_signal (dc_cond_t *cond);
+
+void
+dc_cond_broadcast (dc_cond_t *cond);
+
+dc_status_t
+dc_cond_free (dc_cond_t *cond);
+
+/*
+ * Call the function exactly once for the given flag, which must be a
+ * static variable initialized to zero. Concurrent callers block until
+ * the first call has returned. Unlike the functions above, this also
+ * works on platforms without thread support.
+ */
+void
+dc_once (int *flag, dc_once_func_t func);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_THREAD_H */
@@ -57,6 +57,7 @@
 #include "iostream-private.h"
 #include "descriptor-private.h"
 #include "iterator-private.h"
+#include "timer.h"
 #include "platform.h"
 
 #ifdef _WIN32
@@ -69,6 +70,10 @@ typedef pthread_mutex_t dc_mutex_t;
 
 #define ISINSTANCE(device) dc_iostream_isinstance((device), &dc_usbhid_vtable)
 
+// Interval (in milliseconds) to check for cancellation, while waiting
+// for a transfer to complete.
+#define CANCEL_INTERVAL 10
+
 typedef struct dc_usbhid_session_t {
 	size_t refcount;
 #if defined(USE_LIBUSB)
@@ -685,6 +690,93 @@ dc_usbhid_set_timeout (dc_iostream_t *abstract, int timeout)
 	return DC_STATUS_SUCCESS;
 }
 
+#if defined(USE_LIBUSB)
+static void LIBUSB_CALL
+dc_usbhid_transfer_cb (struct libusb_transfer *transfer)
+{
+	int *completed = (int *) transfer->user_data;
+	*completed = 1;
+}
+
+/*
+ * Asynchronous version of the libusb_interrupt_transfer function, which
+ * cancels the transfer as soon as the I/O stream is cancelled.
+ */
+static int
+dc_usbhid_transfer (dc_usbhid_t *usbhid, unsigned char endpoint, unsigned char *data, int length, int *transferred, unsigned int timeout)
+{
+	int rc = LIBUSB_SUCCESS;
+	int completed = 0, cancelled = 0;
+
+	struct libusb_transfer *transfer = libusb_alloc_transfer (0);
+	if (transfer == NULL)
+		return LIBUSB_ERROR_NO_MEM;
+
+	libusb_fill_interrupt_transfer (transfer, usbhid->handle, endpoint, data, length,
+		dc_usbhid_transfer_cb, &completed, timeout);
+
+	rc = libusb_submit_transfer (transfer);
+	if (rc != LIBUSB_SUCCESS) {
+		libusb_free_transfer (transfer);
+		return rc;
+	}
+
+	while (!completed) {
+		struct timeval tv;
+		tv.tv_sec = 0;
+		tv.tv_usec = CANCEL_INTERVAL * 1000;
+
+		rc = libusb_handle_events_timeout_completed (usbhid->session->handle, &tv, &completed);
+		if (rc != LIBUSB_SUCCESS && rc != LIBUSB_ERROR_INTERRUPTED) {
+			// Cancel the transfer and wait for the completion, such
+			// that the transfer can be freed safely.
+			libusb_cancel_transfer (transfer);
+			while (!completed) {
+				if (libusb_handle_events_completed (usbhid->session->handle, &completed) < 0)
+					break;
+			}
+			libusb_free_transfer (transfer);
+			return rc;
+		}
+
+		if (!completed && !cancelled && dc_iostream_is_cancelled (&usbhid->base)) {
+			libusb_cancel_transfer (transfer);
+			cancelled = 1;
+		}
+	}
+
+	*transferred = transfer->actual_length;
+
+	switch (transfer->status) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		rc = LIBUSB_SUCCESS;
+		break;
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		rc = LIBUSB_ERROR_TIMEOUT;
+		break;
+	case LIBUSB_TRANSFER_CANCELLED:
+		rc = LIBUSB_ERROR_INTERRUPTED;
+		break;
+	case LIBUSB_TRANSFER_STALL:
+		rc = LIBUSB_ERROR_PIPE;
+		break;
+	case LIBUSB_TRANSFER_NO_DEVICE:
+		rc = LIBUSB_ERROR_NO_DEVICE;
+		break;
+	case LIBUSB_TRANSFER_OVERFLOW:
+		rc = LIBUSB_ERROR_OVERFLOW;
+		break;
+	default:
+		rc = LIBUSB_ERROR_IO;
+		break;
+	}
+
+	libusb_free_transfer (transfer);
+
+	return rc;
+}
+#endif
+
 static dc_status_t
 dc_usbhid_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
 {
@@ -693,15 +785,48 @@ dc_usbhid_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 	int nbytes = 0;
 
 #if defined(USE_LIBUSB)
-	int rc = libusb_interrupt_transfer (usbhid->handle, usbhid->endpoint_in, data, size, &nbytes, usbhid->timeout);
-	if (rc != LIBUSB_SUCCESS) {
+	int rc = dc_usbhid_transfer (usbhid, usbhid->endpoint_in, data, size, &nbytes, usbhid->timeout);
+	if (rc == LIBUSB_ERROR_INTERRUPTED) {
+		status = DC_STATUS_CANCELLED;
+		goto out;
+	} else if (rc != LIBUSB_SUCCESS) {
 		ERROR (abstract->context, "Usb read interrupt transfer failed (%s).",
 			libusb_error_name (rc));
 		status = syserror (rc);
 		goto out;
 	}
 #elif defined(USE_HIDAPI)
-	nbytes = hid_read_timeout(usbhid->handle, data, size, usbhid->timeout);
+	// Wait in short intervals, to check for cancellation in between.
+	dc_timer_t *timer = NULL;
+	status = dc_timer_new (&timer);
+	if (status != DC_STATUS_SUCCESS)
+		goto out;
+
+	while (1) {
+		int timeout = CANCEL_INTERVAL;
+		if (usbhid->timeout >= 0) {
+			dc_usecs_t now = 0;
+			dc_timer_now (timer, &now);
+			dc_usecs_t elapsed = now / 1000;
+			if (elapsed >= (dc_usecs_t) usbhid->timeout) {
+				timeout = 0;
+			} else if (usbhid->timeout - elapsed < CANCEL_INTERVAL) {
+				timeout = usbhid->timeout - elapsed;
+			}
+		}
+
+		nbytes = hid_read_timeout(usbhid->handle, data, size, timeout);
+		if (nbytes != 0 || timeout < CANCEL_INTERVAL)
+			break;
+
+		if (dc_iostream_is_cancelled (abstract)) {
+			status = DC_STATUS_CANCELLED;
+			break;
+		}
+	}
+
+	dc_timer_free (timer);
+
 	if (nbytes < 0) {
 		ERROR (abstract->context, "Usb read interrupt transfer failed.");
 		status = DC_STATUS_IO;
@@ -739,8 +864,11 @@ dc_usbhid_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 		length--;
 	}
 
-	int rc = libusb_interrupt_transfer (usbhid->handle, usbhid->endpoint_out, (void *) buffer, length, &nbytes, 0);
-	if (rc != LIBUSB_SUCCESS) {
+	int rc = dc_usbhid_transfer (usbhid, usbhid->endpoint_out, (unsigned char *) buffer, length, &nbytes, 0);
+	if (rc == LIBUSB_ERROR_INTERRUPTED) {
+		status = DC_STATUS_CANCELLED;
+		goto out;
+	} else if (rc != LIBUSB_SUCCESS) {
 		ERROR (abstract->context, "Usb write interrupt transfer failed (%s).",
 			libusb_error_name (rc));
 		status = syserror (rc);
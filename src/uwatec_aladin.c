@@ -60,6 +60,8 @@ static const dc_device_vtable_t uwatec_aladin_device_vtable = {
 	NULL, /* write */
 	uwatec_aladin_device_dump, /* dump */
 	uwatec_aladin_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
@@ -56,6 +56,8 @@ static const dc_device_vtable_t uwatec_memomouse_device_vtable = {
 	NULL, /* write */
 	uwatec_memomouse_device_dump, /* dump */
 	uwatec_memomouse_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };
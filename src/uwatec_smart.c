@@ -76,6 +76,8 @@ static const dc_device_vtable_t uwatec_smart_device_vtable = {
 	NULL, /* write */
 	uwatec_smart_device_dump, /* dump */
 	uwatec_smart_device_foreach, /* foreach */
+	NULL, /* headers */
+	NULL, /* read_dive */
 	NULL, /* timesync */
 	NULL /* close */
 };